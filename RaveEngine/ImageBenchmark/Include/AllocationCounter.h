@@ -0,0 +1,21 @@
+#pragma once
+#include <stddef.h>
+
+namespace bench
+{
+	// Counts both operator new and the C libraries' mallocs, see CountedMalloc.h
+	struct AllocationStats
+	{
+		size_t count = 0;
+		size_t bytes = 0;
+		// Most heap memory alive at once since the last reset, on top of what was alive at the reset
+		size_t peakBytes = 0;
+	};
+
+	void ResetAllocationStats() noexcept;
+	AllocationStats GetAllocationStats() noexcept;
+
+	// Process wide and never goes down, so only the first format measured in a run gets a clean figure.
+	// Run one format per process with --format to compare them
+	size_t GetPeakResidentBytes() noexcept;
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+#include "Engine/Include/ImageLoader.h"
+#include <string>
+#include <vector>
+
+namespace bench
+{
+	struct CorpusFile
+	{
+		std::string path;
+		// Short name of the format, the results are grouped by it
+		std::string format;
+		// What sets this file apart from the others of its format, like "rgba16" or "progressive-420"
+		std::string variant;
+		rave::ImageFormat type = rave::ImageFormat::Unknown;
+		rave::Size size = { 0, 0 };
+		unsigned int frameCount = 1;
+	};
+
+	// Writes synthetic images in every size, PNG colour type and bit depth, JPEG mode, BMP depth and GIF animation
+	// the benchmark covers. The content is generated from fixed seeds, so every build decodes the exact same bytes.
+	// Files already present are kept unless overwrite is set
+	rave::Result GenerateCorpus(const std::string& directory, std::vector<CorpusFile>& files, bool overwrite = false);
+}
\ No newline at end of file
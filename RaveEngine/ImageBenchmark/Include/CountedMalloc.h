@@ -0,0 +1,24 @@
+#pragma once
+// Force included into every source of the benchmark, so the C libraries' mallocs go through the allocation counter.
+// C++ sources only take part when they define BENCHMARK_COUNT_MALLOC, the standard library headers must keep the real names
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void* BenchmarkMalloc(size_t size);
+void* BenchmarkCalloc(size_t count, size_t size);
+void* BenchmarkRealloc(void* block, size_t size);
+void BenchmarkFree(void* block);
+
+#ifdef __cplusplus
+}
+#endif
+
+#if !defined(__cplusplus) || defined(BENCHMARK_COUNT_MALLOC)
+#define malloc(size) BenchmarkMalloc(size)
+#define calloc(count, size) BenchmarkCalloc(count, size)
+#define realloc(block, size) BenchmarkRealloc(block, size)
+#define free(block) BenchmarkFree(block)
+#endif
\ No newline at end of file
@@ -0,0 +1,9 @@
+#pragma once
+
+namespace bench
+{
+	// Decodes JPEGs of every chroma layout, some of odd width, with every DCT method, with and without fancy upsampling
+	// and at every scale. Each decode runs once with libjpeg's C code and once per SIMD level the CPU has, and the pixel
+	// hashes are compared. Prints what it compared and every mismatch, and returns whether all of them matched
+	bool CheckJpegSimd();
+}
\ No newline at end of file
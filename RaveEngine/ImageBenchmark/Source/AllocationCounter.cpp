@@ -0,0 +1,177 @@
+#include "Include/AllocationCounter.h"
+#include "Engine/Include/Platform.h"
+#include <atomic>
+#include <new>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef RE_PLATFORM_WINDOWS
+#include <Psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Every block starts with its size, so frees know how much stops being alive. 16 bytes keeps malloc's alignment
+static constexpr size_t headerSize = 16;
+
+static std::atomic<size_t> allocationCount = 0;
+static std::atomic<size_t> allocatedBytes = 0;
+static std::atomic<size_t> liveBytes = 0;
+static std::atomic<size_t> peakLiveBytes = 0;
+static std::atomic<size_t> resetLiveBytes = 0;
+
+static void CountAllocation(size_t size) noexcept
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+	const size_t live = liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+	size_t peak = peakLiveBytes.load(std::memory_order_relaxed);
+	while (live > peak && !peakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed));
+}
+
+static void CountFree(size_t size) noexcept
+{
+	liveBytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+// The real CRT functions, CountedMalloc.h only renames them in the library sources
+static void* CountedAllocate(size_t size) noexcept
+{
+	unsigned char* block = static_cast<unsigned char*>(malloc(headerSize + size));
+	if (!block)
+		return nullptr;
+
+	memcpy(block, &size, sizeof(size));
+	CountAllocation(size);
+	return block + headerSize;
+}
+
+static void CountedFree(void* pointer) noexcept
+{
+	if (!pointer)
+		return;
+
+	unsigned char* block = static_cast<unsigned char*>(pointer) - headerSize;
+	size_t size;
+	memcpy(&size, block, sizeof(size));
+	CountFree(size);
+	free(block);
+}
+
+extern "C" void* BenchmarkMalloc(size_t size)
+{
+	return CountedAllocate(size);
+}
+
+extern "C" void* BenchmarkCalloc(size_t count, size_t size)
+{
+	if (size && count > SIZE_MAX / size)
+		return nullptr;
+
+	void* pointer = CountedAllocate(count * size);
+	if (pointer)
+		memset(pointer, 0, count * size);
+	return pointer;
+}
+
+extern "C" void* BenchmarkRealloc(void* pointer, size_t size)
+{
+	if (!pointer)
+		return CountedAllocate(size);
+
+	unsigned char* block = static_cast<unsigned char*>(pointer) - headerSize;
+	size_t oldSize;
+	memcpy(&oldSize, block, sizeof(oldSize));
+
+	unsigned char* grown = static_cast<unsigned char*>(realloc(block, headerSize + size));
+	if (!grown)
+		return nullptr;
+
+	memcpy(grown, &size, sizeof(size));
+	CountFree(oldSize);
+	CountAllocation(size);
+	return grown + headerSize;
+}
+
+extern "C" void BenchmarkFree(void* pointer)
+{
+	CountedFree(pointer);
+}
+
+void* operator new(size_t size)
+{
+	void* pointer = CountedAllocate(size ? size : 1);
+	if (!pointer)
+		throw std::bad_alloc();
+	return pointer;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return CountedAllocate(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return CountedAllocate(size ? size : 1);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	CountedFree(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	CountedFree(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+	CountedFree(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+	CountedFree(pointer);
+}
+
+void bench::ResetAllocationStats() noexcept
+{
+	allocationCount = 0;
+	allocatedBytes = 0;
+	resetLiveBytes = liveBytes.load();
+	peakLiveBytes = resetLiveBytes.load();
+}
+
+bench::AllocationStats bench::GetAllocationStats() noexcept
+{
+	AllocationStats stats;
+	stats.count = allocationCount;
+	stats.bytes = allocatedBytes;
+	const size_t peak = peakLiveBytes;
+	const size_t base = resetLiveBytes;
+	stats.peakBytes = peak > base ? peak - base : 0;
+	return stats;
+}
+
+size_t bench::GetPeakResidentBytes() noexcept
+{
+#ifdef RE_PLATFORM_WINDOWS
+	PROCESS_MEMORY_COUNTERS counters = {};
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return counters.PeakWorkingSetSize;
+#else
+	rusage usage = {};
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+	return (size_t)usage.ru_maxrss * 1024;
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,643 @@
+#include "Include/Corpus.h"
+#include <filesystem>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+
+#define RETURN_ERROR(message) return rave::Result(message, rave::RE_FAIL, rave::RE_IMAGE_LOAD_FAIL)
+
+struct SizeEntry
+{
+	unsigned int width;
+	unsigned int height;
+};
+
+// An icon, a typical texture and a large one, so both per-image overhead and raw throughput show up
+static constexpr SizeEntry corpusSizes[] = {
+	{ 64, 64 },
+	{ 640, 480 },
+	{ 2048, 2048 },
+};
+
+struct PngVariant
+{
+	const char* name;
+	int colorType;
+	int bitDepth;
+	bool interlaced;
+};
+
+// Each one takes a different path through the transformations ReadPNGRaw sets up
+static constexpr PngVariant pngVariants[] = {
+	{ "gray1",            PNG_COLOR_TYPE_GRAY,       1,  false },
+	{ "gray8",            PNG_COLOR_TYPE_GRAY,       8,  false },
+	{ "gray16",           PNG_COLOR_TYPE_GRAY,       16, false },
+	{ "gray-alpha8",      PNG_COLOR_TYPE_GRAY_ALPHA, 8,  false },
+	{ "palette8",         PNG_COLOR_TYPE_PALETTE,    8,  false },
+	{ "rgb8",             PNG_COLOR_TYPE_RGB,        8,  false },
+	{ "rgba8",            PNG_COLOR_TYPE_RGBA,       8,  false },
+	{ "rgba16",           PNG_COLOR_TYPE_RGBA,       16, false },
+	{ "rgba8-interlaced", PNG_COLOR_TYPE_RGBA,       8,  true  },
+};
+
+enum class JpegMode
+{
+	Baseline420,
+	Baseline444,
+	Progressive420,
+	// Baseline 4:2:0 with a restart marker every MCU row, which ReadJPEGRaw decodes in parallel strips
+	Restart420,
+	Gray
+};
+
+struct JpegVariant
+{
+	const char* name;
+	JpegMode mode;
+};
+
+static constexpr JpegVariant jpegVariants[] = {
+	{ "baseline-420",    JpegMode::Baseline420 },
+	{ "baseline-444",    JpegMode::Baseline444 },
+	{ "progressive-420", JpegMode::Progressive420 },
+	{ "restart-420",     JpegMode::Restart420 },
+	{ "gray",            JpegMode::Gray },
+};
+
+static constexpr int jpegQuality = 90;
+static constexpr unsigned int gifFrameCount = 8;
+
+static uint32_t Hash(uint32_t x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+static unsigned char ClampByte(float value)
+{
+	return (unsigned char)std::min(std::max(value, 0.0f), 255.0f);
+}
+
+static unsigned char Luma(const rave::Color& color)
+{
+	return (unsigned char)((color.r * 77 + color.g * 150 + color.b * 29) >> 8);
+}
+
+// Smooth gradients under a few soft discs with a little grain, which compresses roughly like a photo.
+// The phase slides the pattern sideways, for the frames of an animation
+static void Synthesize(const rave::Size& size, unsigned int phase, std::vector<rave::Color>& pixels)
+{
+	struct Disc
+	{
+		float x, y, radius;
+		float r, g, b;
+	};
+	static constexpr Disc discs[] = {
+		{ 0.30f, 0.30f, 0.20f, 240.0f,  60.0f,  40.0f },
+		{ 0.70f, 0.40f, 0.15f,  30.0f, 200.0f,  90.0f },
+		{ 0.50f, 0.75f, 0.25f,  50.0f,  70.0f, 230.0f },
+	};
+
+	pixels.resize((size_t)size.x * size.y);
+	for (unsigned int y = 0; y < size.y; y++)
+	{
+		for (unsigned int x = 0; x < size.x; x++)
+		{
+			const float u = (float)(x + phase * 8) / size.x;
+			const float v = (float)y / size.y;
+
+			float r = 255.0f * u;
+			float g = 255.0f * v;
+			float b = 128.0f + 127.0f * std::sin(6.2831853f * (u * 3.0f + v * 2.0f));
+			for (const Disc& disc : discs)
+			{
+				const float dx = u - disc.x - phase * 0.01f;
+				const float dy = v - disc.y;
+				const float d = (dx * dx + dy * dy) / (disc.radius * disc.radius);
+				if (d < 1.0f)
+				{
+					const float t = 1.0f - d;
+					r += (disc.r - r) * t;
+					g += (disc.g - g) * t;
+					b += (disc.b - b) * t;
+				}
+			}
+
+			const float grain = (float)(Hash(x + y * size.x + phase * 0x9E3779B9u) & 15) - 8.0f;
+			const float dx = 2.0f * v - 1.0f;
+			const float dy = 2.0f * (float)x / size.x - 1.0f;
+			const float alpha = 255.0f - 191.0f * std::min(dx * dx + dy * dy, 1.0f);
+
+			pixels[(size_t)y * size.x + x] = rave::Color(ClampByte(r + grain), ClampByte(g + grain), ClampByte(b + grain), ClampByte(alpha));
+		}
+	}
+}
+
+// A 6x6x6 colour cube, shared by the palette PNGs and the GIFs
+static unsigned char PaletteIndex(const rave::Color& color)
+{
+	return (unsigned char)((color.r * 6 / 256) * 36 + (color.g * 6 / 256) * 6 + color.b * 6 / 256);
+}
+
+static std::vector<unsigned char> MakePalette()
+{
+	std::vector<unsigned char> palette(256 * 3, 0);
+	for (unsigned int i = 0; i < 216; i++)
+	{
+		palette[i * 3 + 0] = (unsigned char)(i / 36 * 51);
+		palette[i * 3 + 1] = (unsigned char)(i / 6 % 6 * 51);
+		palette[i * 3 + 2] = (unsigned char)(i % 6 * 51);
+	}
+	return palette;
+}
+
+static void PngWriteRow(const rave::Color* pixels, unsigned int width, const PngVariant& variant, unsigned int rowIndex, unsigned char* row)
+{
+	auto sample16 = [&](unsigned char value, unsigned int x, unsigned int channel, unsigned char*& out)
+	{
+		// The low byte is noise, so the 16-bit files don't compress like 8-bit ones with the bytes doubled
+		const unsigned int wide = value * 256u + (Hash(x * 4 + channel + rowIndex * width * 4) & 0xFF);
+		*out++ = (unsigned char)(wide >> 8);
+		*out++ = (unsigned char)(wide & 0xFF);
+	};
+
+	unsigned char* out = row;
+	if (variant.bitDepth == 1)
+	{
+		memset(row, 0, (width + 7) / 8);
+		for (unsigned int x = 0; x < width; x++)
+			if (Luma(pixels[x]) > (Hash(x + rowIndex * width) & 0xFF))
+				row[x / 8] |= (unsigned char)(0x80 >> (x % 8));
+		return;
+	}
+
+	for (unsigned int x = 0; x < width; x++)
+	{
+		const rave::Color& color = pixels[x];
+		switch (variant.colorType)
+		{
+		case PNG_COLOR_TYPE_GRAY:
+			if (variant.bitDepth == 16)
+				sample16(Luma(color), x, 0, out);
+			else
+				*out++ = Luma(color);
+			break;
+		case PNG_COLOR_TYPE_GRAY_ALPHA:
+			*out++ = Luma(color);
+			*out++ = color.a;
+			break;
+		case PNG_COLOR_TYPE_PALETTE:
+			*out++ = PaletteIndex(color);
+			break;
+		case PNG_COLOR_TYPE_RGB:
+			*out++ = color.r;
+			*out++ = color.g;
+			*out++ = color.b;
+			break;
+		case PNG_COLOR_TYPE_RGBA:
+			if (variant.bitDepth == 16)
+			{
+				sample16(color.r, x, 0, out);
+				sample16(color.g, x, 1, out);
+				sample16(color.b, x, 2, out);
+				sample16(color.a, x, 3, out);
+			}
+			else
+			{
+				*out++ = color.r;
+				*out++ = color.g;
+				*out++ = color.b;
+				*out++ = color.a;
+			}
+			break;
+		}
+	}
+}
+
+static rave::Result WritePNGVariant(const std::string& path, const std::vector<rave::Color>& pixels, const rave::Size& size, const PngVariant& variant)
+{
+	unsigned int channels = 1;
+	if (variant.colorType == PNG_COLOR_TYPE_GRAY_ALPHA) channels = 2;
+	if (variant.colorType == PNG_COLOR_TYPE_RGB)        channels = 3;
+	if (variant.colorType == PNG_COLOR_TYPE_RGBA)       channels = 4;
+
+	const size_t stride = ((size_t)size.x * channels * variant.bitDepth + 7) / 8;
+	std::vector<unsigned char> image(stride * size.y);
+	std::vector<png_bytep> rows(size.y);
+	for (unsigned int y = 0; y < size.y; y++)
+	{
+		rows[y] = image.data() + stride * y;
+		PngWriteRow(pixels.data() + (size_t)y * size.x, size.x, variant, y, rows[y]);
+	}
+	const std::vector<unsigned char> palette = MakePalette();
+
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file)
+		RETURN_ERROR(L"Unable to create a corpus file");
+
+	png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	png_infop info = png ? png_create_info_struct(png) : NULL;
+	if (!info)
+	{
+		png_destroy_write_struct(&png, NULL);
+		fclose(file);
+		RETURN_ERROR(L"Unable to create a PNG writer");
+	}
+	if (setjmp(png_jmpbuf(png)))
+	{
+		png_destroy_write_struct(&png, &info);
+		fclose(file);
+		RETURN_ERROR(L"Unable to write a corpus PNG");
+	}
+
+	png_init_io(png, file);
+	png_set_IHDR(png, info, size.x, size.y, variant.bitDepth, variant.colorType,
+		variant.interlaced ? PNG_INTERLACE_ADAM7 : PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+	if (variant.colorType == PNG_COLOR_TYPE_PALETTE)
+		png_set_PLTE(png, info, reinterpret_cast<png_const_colorp>(palette.data()), 256);
+
+	png_write_info(png, info);
+	png_write_image(png, rows.data());
+	png_write_end(png, NULL);
+	png_destroy_write_struct(&png, &info);
+
+	if (fclose(file) != 0)
+		RETURN_ERROR(L"Unable to write a corpus PNG");
+	return rave::RE_SUCCESS;
+}
+
+struct CorpusJpegError
+{
+	jpeg_error_mgr manager;
+	jmp_buf jumpBuffer;
+};
+
+static void CorpusJpegErrorExit(j_common_ptr cinfo)
+{
+	longjmp(reinterpret_cast<CorpusJpegError*>(cinfo->err)->jumpBuffer, 1);
+}
+
+static rave::Result WriteJPEGVariant(const std::string& path, const std::vector<rave::Color>& pixels, const rave::Size& size, const JpegVariant& variant)
+{
+	const bool gray = variant.mode == JpegMode::Gray;
+	std::vector<unsigned char> row((size_t)size.x * 3);
+
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file)
+		RETURN_ERROR(L"Unable to create a corpus file");
+
+	jpeg_compress_struct cinfo;
+	CorpusJpegError error;
+	cinfo.err = jpeg_std_error(&error.manager);
+	error.manager.error_exit = CorpusJpegErrorExit;
+	if (setjmp(error.jumpBuffer))
+	{
+		jpeg_destroy_compress(&cinfo);
+		fclose(file);
+		RETURN_ERROR(L"Unable to write a corpus JPEG");
+	}
+
+	jpeg_create_compress(&cinfo);
+	jpeg_stdio_dest(&cinfo, file);
+
+	cinfo.image_width = size.x;
+	cinfo.image_height = size.y;
+	cinfo.input_components = gray ? 1 : 3;
+	cinfo.in_color_space = gray ? JCS_GRAYSCALE : JCS_RGB;
+	jpeg_set_defaults(&cinfo);
+	jpeg_set_quality(&cinfo, jpegQuality, TRUE);
+
+	if (variant.mode == JpegMode::Baseline444)
+	{
+		for (int i = 0; i < cinfo.num_components; i++)
+		{
+			cinfo.comp_info[i].h_samp_factor = 1;
+			cinfo.comp_info[i].v_samp_factor = 1;
+		}
+	}
+	if (variant.mode == JpegMode::Progressive420)
+		jpeg_simple_progression(&cinfo);
+	if (variant.mode == JpegMode::Restart420)
+		cinfo.restart_in_rows = 1;
+
+	jpeg_start_compress(&cinfo, TRUE);
+	while (cinfo.next_scanline < cinfo.image_height)
+	{
+		const rave::Color* src = pixels.data() + (size_t)cinfo.next_scanline * size.x;
+		for (unsigned int x = 0; x < size.x; x++)
+		{
+			if (gray)
+			{
+				row[x] = Luma(src[x]);
+			}
+			else
+			{
+				row[x * 3 + 0] = src[x].r;
+				row[x * 3 + 1] = src[x].g;
+				row[x * 3 + 2] = src[x].b;
+			}
+		}
+		JSAMPROW rowPointer = row.data();
+		jpeg_write_scanlines(&cinfo, &rowPointer, 1);
+	}
+	jpeg_finish_compress(&cinfo);
+	jpeg_destroy_compress(&cinfo);
+
+	if (fclose(file) != 0)
+		RETURN_ERROR(L"Unable to write a corpus JPEG");
+	return rave::RE_SUCCESS;
+}
+
+template<typename T>
+static void Append(std::vector<unsigned char>& bytes, const T& value)
+{
+	const unsigned char* p = reinterpret_cast<const unsigned char*>(&value);
+	bytes.insert(bytes.end(), p, p + sizeof(T));
+}
+
+static rave::Result WriteFile(const std::string& path, const std::vector<unsigned char>& bytes)
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file)
+		RETURN_ERROR(L"Unable to create a corpus file");
+
+	const bool written = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+	if (fclose(file) != 0 || !written)
+		RETURN_ERROR(L"Unable to write a corpus file");
+	return rave::RE_SUCCESS;
+}
+
+// 24-bit files use the plain 40 byte info header, 32-bit ones the 124 byte one with BGRA masks and sRGB, which is what ReadBMPRaw expects
+static rave::Result WriteBMPVariant(const std::string& path, const std::vector<rave::Color>& pixels, const rave::Size& size, unsigned int bitCount)
+{
+	const uint32_t infoSize = bitCount == 32 ? 124 : 40;
+	const uint32_t rowSize = size.x * bitCount / 8;
+	const uint32_t stride = (rowSize + 3) & ~3u;
+	const uint32_t offset = 14 + infoSize;
+
+	std::vector<unsigned char> bytes;
+	bytes.reserve(offset + (size_t)stride * size.y);
+
+	Append(bytes, (uint16_t)0x4D42);
+	Append(bytes, (uint32_t)(offset + stride * size.y));
+	Append(bytes, (uint32_t)0);
+	Append(bytes, offset);
+
+	Append(bytes, infoSize);
+	Append(bytes, (int32_t)size.x);
+	Append(bytes, (int32_t)size.y);
+	Append(bytes, (uint16_t)1);
+	Append(bytes, (uint16_t)bitCount);
+	Append(bytes, (uint32_t)(bitCount == 32 ? 3 : 0));
+	Append(bytes, stride * size.y);
+	Append(bytes, (int32_t)2835);
+	Append(bytes, (int32_t)2835);
+	Append(bytes, (uint32_t)0);
+	Append(bytes, (uint32_t)0);
+	if (bitCount == 32)
+	{
+		Append(bytes, (uint32_t)0x00ff0000);
+		Append(bytes, (uint32_t)0x0000ff00);
+		Append(bytes, (uint32_t)0x000000ff);
+		Append(bytes, (uint32_t)0xff000000);
+		Append(bytes, (uint32_t)0x73524742);
+		bytes.resize(bytes.size() + 16 * sizeof(uint32_t), 0);
+	}
+
+	// Bottom-up rows
+	for (unsigned int y = size.y; y-- > 0;)
+	{
+		const size_t rowStart = bytes.size();
+		const rave::Color* src = pixels.data() + (size_t)y * size.x;
+		for (unsigned int x = 0; x < size.x; x++)
+		{
+			bytes.push_back(src[x].b);
+			bytes.push_back(src[x].g);
+			bytes.push_back(src[x].r);
+			if (bitCount == 32)
+				bytes.push_back(src[x].a);
+		}
+		bytes.resize(rowStart + stride, 0);
+	}
+
+	return WriteFile(path, bytes);
+}
+
+// LZW with 8-bit roots, codes packed LSB first and cut into 255 byte sub-blocks
+class GifLzwEncoder
+{
+public:
+	GifLzwEncoder(std::vector<unsigned char>& output)
+		:
+		output(output),
+		children(4096 * 256)
+	{
+	}
+
+	void Encode(const unsigned char* indices, size_t count)
+	{
+		output.push_back(8);
+		Reset();
+		Emit(clearCode);
+
+		unsigned int current = indices[0];
+		for (size_t i = 1; i < count; i++)
+		{
+			const unsigned int next = indices[i];
+			const uint16_t child = children[current * 256 + next];
+			if (child)
+			{
+				current = child;
+				continue;
+			}
+
+			Emit(current);
+			children[current * 256 + next] = (uint16_t)nextCode++;
+			// The decoder runs one code behind, so it widens once the table has reached the next power of two
+			if (nextCode > (1u << codeSize))
+				codeSize++;
+			if (nextCode == 4096)
+			{
+				Emit(clearCode);
+				Reset();
+			}
+			current = next;
+		}
+
+		Emit(current);
+		Emit(clearCode + 1);
+		if (bitCount)
+			PushByte((unsigned char)bits);
+		FlushBlock();
+		output.push_back(0);
+	}
+
+private:
+	static constexpr unsigned int clearCode = 256;
+
+	void Reset()
+	{
+		std::fill(children.begin(), children.end(), (uint16_t)0);
+		nextCode = clearCode + 2;
+		codeSize = 9;
+	}
+
+	void Emit(unsigned int code)
+	{
+		bits |= code << bitCount;
+		bitCount += codeSize;
+		while (bitCount >= 8)
+		{
+			PushByte((unsigned char)(bits & 0xFF));
+			bits >>= 8;
+			bitCount -= 8;
+		}
+	}
+
+	void PushByte(unsigned char byte)
+	{
+		block[blockSize++] = byte;
+		if (blockSize == 255)
+			FlushBlock();
+	}
+
+	void FlushBlock()
+	{
+		if (!blockSize)
+			return;
+		output.push_back((unsigned char)blockSize);
+		output.insert(output.end(), block, block + blockSize);
+		blockSize = 0;
+	}
+
+	std::vector<unsigned char>& output;
+	std::vector<uint16_t> children;
+	unsigned int nextCode = 0;
+	unsigned int codeSize = 9;
+	uint32_t bits = 0;
+	unsigned int bitCount = 0;
+	unsigned char block[255] = {};
+	unsigned int blockSize = 0;
+};
+
+// Looping animation whose frames all cover the whole canvas, so every frame decodes the full area
+static rave::Result WriteGIFVariant(const std::string& path, const rave::Size& size, unsigned int frameCount)
+{
+	std::vector<unsigned char> bytes = { 'G', 'I', 'F', '8', '9', 'a' };
+	Append(bytes, (uint16_t)size.x);
+	Append(bytes, (uint16_t)size.y);
+	bytes.insert(bytes.end(), { 0xF7, 0, 0 });
+	const std::vector<unsigned char> palette = MakePalette();
+	bytes.insert(bytes.end(), palette.begin(), palette.end());
+
+	static constexpr unsigned char loop[] = { 0x21, 0xFF, 0x0B, 'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E', '2', '.', '0', 0x03, 0x01, 0x00, 0x00, 0x00 };
+	bytes.insert(bytes.end(), std::begin(loop), std::end(loop));
+
+	std::vector<rave::Color> pixels;
+	std::vector<unsigned char> indices((size_t)size.x * size.y);
+	GifLzwEncoder encoder(bytes);
+	for (unsigned int frame = 0; frame < frameCount; frame++)
+	{
+		Synthesize(size, frame, pixels);
+		for (size_t i = 0; i < indices.size(); i++)
+			indices[i] = PaletteIndex(pixels[i]);
+
+		// Graphic control extension: keep the previous frame, 40ms delay
+		bytes.insert(bytes.end(), { 0x21, 0xF9, 0x04, 0x04, 4, 0, 0, 0 });
+		bytes.push_back(0x2C);
+		Append(bytes, (uint16_t)0);
+		Append(bytes, (uint16_t)0);
+		Append(bytes, (uint16_t)size.x);
+		Append(bytes, (uint16_t)size.y);
+		bytes.push_back(0);
+		encoder.Encode(indices.data(), indices.size());
+	}
+	bytes.push_back(0x3B);
+
+	return WriteFile(path, bytes);
+}
+
+static bool AddFile(std::vector<bench::CorpusFile>& files, const std::string& directory, const char* format, const char* variant, const char* extension, rave::ImageFormat type, const rave::Size& size, bool overwrite, unsigned int frameCount = 1)
+{
+	bench::CorpusFile file;
+	file.path = directory + "/" + format + "/" + variant + "_" + std::to_string(size.x) + "x" + std::to_string(size.y) + extension;
+	file.format = format;
+	file.variant = variant;
+	file.type = type;
+	file.size = size;
+	file.frameCount = frameCount;
+	files.push_back(file);
+
+	return overwrite || !std::filesystem::exists(file.path);
+}
+
+rave::Result bench::GenerateCorpus(const std::string& directory, std::vector<CorpusFile>& files, bool overwrite)
+{
+	files.clear();
+	std::error_code error;
+	for (const char* format : { "png", "jpeg", "bmp", "gif", "qoi" })
+	{
+		std::filesystem::create_directories(directory + "/" + format, error);
+		if (error)
+			RETURN_ERROR(L"Unable to create the corpus directory");
+	}
+
+	std::vector<rave::Color> pixels;
+	for (const SizeEntry& entry : corpusSizes)
+	{
+		const rave::Size size = rave::Size(entry.width, entry.height);
+		Synthesize(size, 0, pixels);
+
+		for (const PngVariant& variant : pngVariants)
+		{
+			if (AddFile(files, directory, "png", variant.name, ".png", rave::ImageFormat::PNG, size, overwrite))
+			{
+				rave::Result result = WritePNGVariant(files.back().path, pixels, size, variant);
+				if (result.Failed())
+					return result;
+			}
+		}
+
+		for (const JpegVariant& variant : jpegVariants)
+		{
+			if (AddFile(files, directory, "jpeg", variant.name, ".jpg", rave::ImageFormat::JPEG, size, overwrite))
+			{
+				rave::Result result = WriteJPEGVariant(files.back().path, pixels, size, variant);
+				if (result.Failed())
+					return result;
+			}
+		}
+
+		for (unsigned int bitCount : { 24u, 32u })
+		{
+			if (AddFile(files, directory, "bmp", bitCount == 32 ? "bgra32" : "bgr24", ".bmp", rave::ImageFormat::BMP, size, overwrite))
+			{
+				rave::Result result = WriteBMPVariant(files.back().path, pixels, size, bitCount);
+				if (result.Failed())
+					return result;
+			}
+		}
+
+		if (AddFile(files, directory, "gif", "animated", ".gif", rave::ImageFormat::GIF, size, overwrite, gifFrameCount))
+		{
+			rave::Result result = WriteGIFVariant(files.back().path, size, gifFrameCount);
+			if (result.Failed())
+				return result;
+		}
+
+		if (AddFile(files, directory, "qoi", "rgba8", ".qoi", rave::ImageFormat::QOI, size, overwrite))
+		{
+			rave::Result result = rave::WriteQOI(pixels.data(), size, files.back().path.c_str());
+			if (result.Failed())
+				return result;
+		}
+	}
+
+	return rave::RE_SUCCESS;
+}
\ No newline at end of file
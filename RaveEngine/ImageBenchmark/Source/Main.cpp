@@ -0,0 +1,415 @@
+#include "Include/Corpus.h"
+#include "Include/AllocationCounter.h"
+#include "Include/SimdCheck.h"
+#include "Engine/Utilities/Include/FileMapping.h"
+#include "Engine/Utilities/Include/Timer.h"
+#include "Engine/Utilities/Include/SystemInfo.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <map>
+
+struct BenchmarkSettings
+{
+	std::string corpus = "BenchmarkCorpus";
+	std::string json;
+	// Only files of this format are measured when set, which also gives that format a clean peak RSS
+	std::string format;
+	// Name of the DecodeOptions preset every decode uses
+	std::string preset = "accurate";
+	rave::DecodeOptions options;
+	double minSeconds = 0.5;
+	size_t minIterations = 3;
+	bool regenerate = false;
+	// Compares libjpeg's SIMD decodes with its C code instead of measuring
+	bool checkSimd = false;
+};
+
+// One way into ImageLoader. Raw readers decode into a buffer sized up front, the others allocate their output every call like a real caller's would
+struct EntryPoint
+{
+	const char* name;
+	bool decodes;
+	rave::Result(*run)(const bench::CorpusFile& file, const rave::FileMapping& bytes, std::vector<rave::Color>& buffer, const rave::DecodeOptions& options);
+	// Only run on files of this format when set
+	rave::ImageFormat only = rave::ImageFormat::Unknown;
+};
+
+static rave::Result CheckSize(const bench::CorpusFile& file, unsigned int width, unsigned int height)
+{
+	if (width != file.size.x || height != file.size.y)
+		return rave::Result(L"Decoded size doesn't match the corpus", rave::RE_FAIL, rave::RE_IMAGE_LOAD_FAIL);
+	return rave::RE_SUCCESS;
+}
+
+static rave::Result CheckSize(const bench::CorpusFile& file, const rave::OptionalResult<rave::Size>& size)
+{
+	if (size.GetResult().Failed())
+		return size.GetResult();
+	return CheckSize(file, size.Get().x, size.Get().y);
+}
+
+static const EntryPoint entryPoints[] = {
+	{
+		"ReadImage(file)", true,
+		[](const bench::CorpusFile& file, const rave::FileMapping&, std::vector<rave::Color>&, const rave::DecodeOptions& options)
+		{
+			std::vector<rave::Color> pixels;
+			unsigned int width = 0, height = 0;
+			rave::Result result = rave::ReadImage(file.path, pixels, &width, &height, options);
+			return result.Failed() ? result : CheckSize(file, width, height);
+		}
+	},
+	{
+		"ReadImage(memory)", true,
+		[](const bench::CorpusFile& file, const rave::FileMapping& bytes, std::vector<rave::Color>&, const rave::DecodeOptions& options)
+		{
+			std::vector<rave::Color> pixels;
+			unsigned int width = 0, height = 0;
+			rave::Result result = rave::ReadImage(bytes.Data(), bytes.Size(), pixels, &width, &height, options);
+			return result.Failed() ? result : CheckSize(file, width, height);
+		}
+	},
+	{
+		"ReadImageRaw(file)", true,
+		[](const bench::CorpusFile& file, const rave::FileMapping&, std::vector<rave::Color>& buffer, const rave::DecodeOptions& options)
+		{
+			return rave::ReadImageRaw(file.path, buffer.data(), options);
+		}
+	},
+	{
+		"ReadImageRaw(memory)", true,
+		[](const bench::CorpusFile& file, const rave::FileMapping& bytes, std::vector<rave::Color>& buffer, const rave::DecodeOptions& options)
+		{
+			return rave::ReadImageRaw(bytes.Data(), bytes.Size(), file.type, buffer.data(), options);
+		}
+	},
+	{
+		"ReadGIFRaw(memory, last frame)", true,
+		[](const bench::CorpusFile& file, const rave::FileMapping& bytes, std::vector<rave::Color>& buffer, const rave::DecodeOptions&)
+		{
+			return rave::ReadGIFRaw(bytes.Data(), bytes.Size(), buffer.data(), file.frameCount - 1);
+		},
+		rave::ImageFormat::GIF
+	},
+	{
+		"ImageSize(file)", false,
+		[](const bench::CorpusFile& file, const rave::FileMapping&, std::vector<rave::Color>&, const rave::DecodeOptions&)
+		{
+			return CheckSize(file, rave::ImageSize(file.path));
+		}
+	},
+	{
+		"ImageSize(memory)", false,
+		[](const bench::CorpusFile& file, const rave::FileMapping& bytes, std::vector<rave::Color>&, const rave::DecodeOptions& options)
+		{
+			return CheckSize(file, rave::ImageSize(bytes.Data(), bytes.Size(), file.type, options));
+		}
+	},
+};
+
+struct Measurement
+{
+	const bench::CorpusFile* file = nullptr;
+	const EntryPoint* entryPoint = nullptr;
+	size_t bytes = 0;
+	size_t iterations = 0;
+	double seconds = 0.0;
+	double minSeconds = 0.0;
+	size_t allocations = 0;
+	size_t allocatedBytes = 0;
+	size_t peakHeapBytes = 0;
+	size_t peakResidentBytes = 0;
+	std::string error;
+
+	size_t Pixels() const
+	{
+		return entryPoint->decodes ? (size_t)file->size.x * file->size.y : 0;
+	}
+};
+
+static Measurement Measure(const bench::CorpusFile& file, const EntryPoint& entryPoint, const rave::FileMapping& bytes, const BenchmarkSettings& settings)
+{
+	Measurement measurement;
+	measurement.file = &file;
+	measurement.entryPoint = &entryPoint;
+	measurement.bytes = bytes.Size();
+
+	std::vector<rave::Color> buffer((size_t)file.size.x * file.size.y);
+
+	// The first call warms the caches and checks the output, it isn't counted
+	rave::Result result = entryPoint.run(file, bytes, buffer, settings.options);
+	if (result.Failed())
+	{
+		const wchar_t* message = result.GetErrorMessage();
+		measurement.error = message ? rave::Narrow(message) : "Unknown error";
+		return measurement;
+	}
+
+	bench::ResetAllocationStats();
+	rave::Timer timer;
+	measurement.minSeconds = 1e30;
+	while (measurement.seconds < settings.minSeconds || measurement.iterations < settings.minIterations)
+	{
+		timer.Mark();
+		entryPoint.run(file, bytes, buffer, settings.options);
+		const double seconds = timer.Mark();
+
+		measurement.seconds += seconds;
+		measurement.minSeconds = std::min(measurement.minSeconds, seconds);
+		measurement.iterations++;
+	}
+
+	const bench::AllocationStats stats = bench::GetAllocationStats();
+	measurement.allocations = stats.count;
+	measurement.allocatedBytes = stats.bytes;
+	measurement.peakHeapBytes = stats.peakBytes;
+	measurement.peakResidentBytes = bench::GetPeakResidentBytes();
+	return measurement;
+}
+
+static double PerSecond(double amount, double seconds)
+{
+	return seconds > 0.0 ? amount / seconds : 0.0;
+}
+
+static std::string JsonString(const std::string& string)
+{
+	std::string escaped = "\"";
+	for (char c : string)
+	{
+		if (c == '"' || c == '\\')
+			escaped += '\\';
+		escaped += c;
+	}
+	return escaped + "\"";
+}
+
+// Totals for one format through one entry point, over every file of that format
+struct Summary
+{
+	bool decodes = false;
+	size_t files = 0;
+	size_t iterations = 0;
+	double bytes = 0.0;
+	double pixels = 0.0;
+	double seconds = 0.0;
+	size_t allocations = 0;
+	size_t peakHeapBytes = 0;
+	size_t peakResidentBytes = 0;
+};
+
+using SummaryKey = std::pair<std::string, std::string>;
+
+static std::map<SummaryKey, Summary> Summarize(const std::vector<Measurement>& measurements)
+{
+	std::map<SummaryKey, Summary> summaries;
+	for (const Measurement& m : measurements)
+	{
+		if (!m.error.empty())
+			continue;
+
+		Summary& summary = summaries[SummaryKey(m.file->format, m.entryPoint->name)];
+		summary.decodes = m.entryPoint->decodes;
+		summary.files++;
+		summary.iterations += m.iterations;
+		summary.bytes += (double)m.bytes * m.iterations;
+		summary.pixels += (double)m.Pixels() * m.iterations;
+		summary.seconds += m.seconds;
+		summary.allocations += m.allocations;
+		summary.peakHeapBytes = std::max(summary.peakHeapBytes, m.peakHeapBytes);
+		summary.peakResidentBytes = std::max(summary.peakResidentBytes, m.peakResidentBytes);
+	}
+	return summaries;
+}
+
+// One object per line in a fixed order, so two runs can be compared with a plain text diff
+static bool WriteJson(const std::string& filename, const BenchmarkSettings& settings, const std::vector<Measurement>& measurements)
+{
+	FILE* file = fopen(filename.c_str(), "w");
+	if (!file)
+		return false;
+
+	fprintf(file, "{\n");
+	fprintf(file, "  \"configuration\": \"%s\",\n", rave::System::debug ? "debug" : "release");
+	fprintf(file, "  \"preset\": %s,\n", JsonString(settings.preset).c_str());
+	fprintf(file, "  \"minSeconds\": %.3f,\n", settings.minSeconds);
+	fprintf(file, "  \"results\": [\n");
+	for (size_t i = 0; i < measurements.size(); i++)
+	{
+		const Measurement& m = measurements[i];
+		fprintf(file, "    { \"file\": %s, \"format\": %s, \"variant\": %s, \"width\": %u, \"height\": %u, \"frames\": %u, \"bytes\": %zu, \"entryPoint\": %s, ",
+			JsonString(m.file->path).c_str(), JsonString(m.file->format).c_str(), JsonString(m.file->variant).c_str(),
+			m.file->size.x, m.file->size.y, m.file->frameCount, m.bytes, JsonString(m.entryPoint->name).c_str());
+		if (!m.error.empty())
+		{
+			fprintf(file, "\"error\": %s }", JsonString(m.error).c_str());
+		}
+		else
+		{
+			fprintf(file, "\"iterations\": %zu, \"secondsMean\": %.9f, \"secondsMin\": %.9f, \"imagesPerSecond\": %.3f, ",
+				m.iterations, m.seconds / m.iterations, m.minSeconds, PerSecond((double)m.iterations, m.seconds));
+			// Size queries only read the header, a throughput over the whole file would mean nothing
+			if (m.entryPoint->decodes)
+				fprintf(file, "\"mbPerSecond\": %.3f, \"pixelsPerSecond\": %.0f, ", PerSecond((double)m.bytes * m.iterations / 1e6, m.seconds), PerSecond((double)m.Pixels() * m.iterations, m.seconds));
+			fprintf(file, "\"allocationsPerImage\": %.2f, \"allocatedBytesPerImage\": %.0f, \"peakHeapBytes\": %zu, \"peakRssBytes\": %zu }",
+				(double)m.allocations / m.iterations, (double)m.allocatedBytes / m.iterations, m.peakHeapBytes, m.peakResidentBytes);
+		}
+		fprintf(file, "%s\n", i + 1 < measurements.size() ? "," : "");
+	}
+	fprintf(file, "  ],\n");
+
+	fprintf(file, "  \"formats\": [\n");
+	const auto summaries = Summarize(measurements);
+	size_t index = 0;
+	for (const auto& entry : summaries)
+	{
+		const Summary& s = entry.second;
+		fprintf(file, "    { \"format\": %s, \"entryPoint\": %s, \"files\": %zu, \"imagesPerSecond\": %.3f, ",
+			JsonString(entry.first.first).c_str(), JsonString(entry.first.second).c_str(), s.files, PerSecond((double)s.iterations, s.seconds));
+		if (s.decodes)
+			fprintf(file, "\"mbPerSecond\": %.3f, \"pixelsPerSecond\": %.0f, ", PerSecond(s.bytes / 1e6, s.seconds), PerSecond(s.pixels, s.seconds));
+		fprintf(file, "\"allocationsPerImage\": %.2f, \"peakHeapBytes\": %zu, \"peakRssBytes\": %zu }%s\n",
+			(double)s.allocations / std::max<size_t>(s.iterations, 1), s.peakHeapBytes, s.peakResidentBytes, ++index < summaries.size() ? "," : "");
+	}
+	fprintf(file, "  ]\n");
+	fprintf(file, "}\n");
+
+	return fclose(file) == 0;
+}
+
+static void PrintUsage()
+{
+	printf(
+		"Usage: ImageBenchmark [options]\n"
+		"  --corpus <directory>  Where the generated images are kept (default BenchmarkCorpus)\n"
+		"  --regenerate          Write the corpus again even when it already exists\n"
+		"  --check-simd          Check that the JPEG SIMD kernels decode exactly like the C code, then exit\n"
+		"  --format <name>       Only measure png, jpeg, bmp, gif or qoi\n"
+		"  --preset <name>       Decode with the accurate, trusted or fast-preview options (default accurate)\n"
+		"  --min-time <seconds>  Time spent on every file and entry point (default 0.5)\n"
+		"  --json <file>         Also write the results as JSON\n");
+}
+
+static bool ParseArguments(int argc, char** argv, BenchmarkSettings& settings)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const char* argument = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+		if (strcmp(argument, "--regenerate") == 0)
+		{
+			settings.regenerate = true;
+			continue;
+		}
+		if (strcmp(argument, "--check-simd") == 0)
+		{
+			settings.checkSimd = true;
+			continue;
+		}
+		if (!value)
+			return false;
+
+		if (strcmp(argument, "--corpus") == 0)
+			settings.corpus = value;
+		else if (strcmp(argument, "--format") == 0)
+			settings.format = value;
+		else if (strcmp(argument, "--preset") == 0)
+			settings.preset = value;
+		else if (strcmp(argument, "--min-time") == 0)
+			settings.minSeconds = atof(value);
+		else if (strcmp(argument, "--json") == 0)
+			settings.json = value;
+		else
+			return false;
+		i++;
+	}
+
+	if (settings.preset == "accurate")
+		settings.options = rave::DecodeOptions::Accurate();
+	else if (settings.preset == "trusted")
+		settings.options = rave::DecodeOptions::Trusted();
+	else if (settings.preset == "fast-preview")
+		settings.options = rave::DecodeOptions::FastPreview();
+	else
+		return false;
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	BenchmarkSettings settings;
+	if (!ParseArguments(argc, argv, settings))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (settings.checkSimd)
+		return bench::CheckJpegSimd() ? 0 : 1;
+
+	printf("Preparing the corpus in %s\n", settings.corpus.c_str());
+	std::vector<bench::CorpusFile> files;
+	rave::Result result = bench::GenerateCorpus(settings.corpus, files, settings.regenerate);
+	if (result.Failed())
+	{
+		const wchar_t* message = result.GetErrorMessage();
+		printf("%s\n", message ? rave::Narrow(message).c_str() : "Unable to generate the corpus");
+		return 1;
+	}
+
+	std::vector<Measurement> measurements;
+	printf("%-34s %-30s %10s %10s %12s %10s %12s\n", "File", "Entry point", "Images/s", "MB/s", "Mpixels/s", "Allocs", "Peak heap");
+	for (const bench::CorpusFile& file : files)
+	{
+		if (!settings.format.empty() && file.format != settings.format)
+			continue;
+
+		rave::FileMapping bytes;
+		result = bytes.Open(file.path.c_str());
+		if (result.Failed())
+		{
+			printf("Unable to open %s\n", file.path.c_str());
+			return 1;
+		}
+
+		const std::string name = file.path.substr(settings.corpus.size() + 1);
+		for (const EntryPoint& entryPoint : entryPoints)
+		{
+			if (entryPoint.only != rave::ImageFormat::Unknown && entryPoint.only != file.type)
+				continue;
+
+			measurements.push_back(Measure(file, entryPoint, bytes, settings));
+			const Measurement& m = measurements.back();
+			if (!m.error.empty())
+			{
+				printf("%-34s %-30s failed: %s\n", name.c_str(), entryPoint.name, m.error.c_str());
+				continue;
+			}
+
+			printf("%-34s %-30s %10.0f ", name.c_str(), entryPoint.name, PerSecond((double)m.iterations, m.seconds));
+			if (entryPoint.decodes)
+				printf("%10.1f %12.2f ", PerSecond((double)m.bytes * m.iterations / 1e6, m.seconds), PerSecond((double)m.Pixels() * m.iterations / 1e6, m.seconds));
+			else
+				printf("%10s %12s ", "-", "-");
+			printf("%10.1f %10zuKB\n", (double)m.allocations / m.iterations, m.peakHeapBytes / 1024);
+		}
+	}
+
+	printf("\nPeak RSS %zuKB\n", bench::GetPeakResidentBytes() / 1024);
+
+	if (!settings.json.empty())
+	{
+		if (!WriteJson(settings.json, settings, measurements))
+		{
+			printf("Unable to write %s\n", settings.json.c_str());
+			return 1;
+		}
+		printf("Results written to %s\n", settings.json.c_str());
+	}
+
+	const bool failed = std::any_of(measurements.begin(), measurements.end(), [](const Measurement& m) { return !m.error.empty(); });
+	return failed ? 1 : 0;
+}
\ No newline at end of file
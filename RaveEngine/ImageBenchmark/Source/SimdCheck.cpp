@@ -0,0 +1,230 @@
+#include "Include/SimdCheck.h"
+#include "Engine/Include/ImageLoader.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iterator>
+#include <string>
+#include <vector>
+
+struct SimdCheckLayout
+{
+	const char* name;
+	int hSamp;
+	int vSamp;
+	bool gray;
+	bool progressive;
+};
+
+// Sampling factors of the luma component, the chroma components stay at 1x1
+static constexpr SimdCheckLayout simdCheckLayouts[] = {
+	{ "444",             1, 1, false, false },
+	{ "422",             2, 1, false, false },
+	{ "420",             2, 2, false, false },
+	{ "440",             1, 2, false, false },
+	{ "gray",            1, 1, true,  false },
+	{ "progressive-420", 2, 2, false, true  },
+};
+
+struct SimdCheckSize
+{
+	unsigned int x;
+	unsigned int y;
+};
+
+// Odd widths leave partial MCUs and odd chroma sample counts for the row tails of the kernels
+static constexpr SimdCheckSize simdCheckSizes[] = { { 61, 47 }, { 203, 35 }, { 96, 64 }, { 1, 9 } };
+// 100 keeps the largest coefficients, where an overflow in a kernel would show
+static constexpr int simdCheckQualities[] = { 75, 100 };
+static constexpr J_DCT_METHOD simdCheckMethods[] = { JDCT_ISLOW, JDCT_IFAST, JDCT_FLOAT };
+
+static const char* const simdLevelNames[] = { "C", "SSE2", "AVX2" };
+
+struct SimdCheckJpegError
+{
+	jpeg_error_mgr manager;
+	jmp_buf jumpBuffer;
+};
+
+static void SimdCheckJpegErrorExit(j_common_ptr cinfo)
+{
+	longjmp(reinterpret_cast<SimdCheckJpegError*>(cinfo->err)->jumpBuffer, 1);
+}
+
+// Smooth gradients crossed by bands of noise, so both small and large coefficients occur
+static void FillPixels(const SimdCheckSize& size, std::vector<unsigned char>& rgb)
+{
+	rgb.resize((size_t)size.x * size.y * 3);
+	for (unsigned int y = 0; y < size.y; y++)
+	{
+		for (unsigned int x = 0; x < size.x; x++)
+		{
+			uint32_t h = x * 73856093u ^ y * 19349663u;
+			h ^= h >> 13;
+			h *= 0x5BD1E995u;
+			h ^= h >> 15;
+
+			unsigned char* p = &rgb[((size_t)y * size.x + x) * 3];
+			const bool noisy = (x / 8 + y / 8) % 3 == 0;
+			p[0] = noisy ? (unsigned char)h : (unsigned char)(x * 255 / size.x);
+			p[1] = noisy ? (unsigned char)(h >> 8) : (unsigned char)(y * 255 / size.y);
+			p[2] = noisy ? (unsigned char)(h >> 16) : (unsigned char)((x + y) * 2);
+		}
+	}
+}
+
+static bool EncodeJpeg(const std::vector<unsigned char>& rgb, const SimdCheckSize& size, const SimdCheckLayout& layout, int quality, std::vector<unsigned char>& jpeg)
+{
+	unsigned char* buffer = nullptr;
+	unsigned long length = 0;
+	std::vector<unsigned char> row((size_t)size.x * 3);
+
+	jpeg_compress_struct cinfo;
+	SimdCheckJpegError error;
+	cinfo.err = jpeg_std_error(&error.manager);
+	error.manager.error_exit = SimdCheckJpegErrorExit;
+	if (setjmp(error.jumpBuffer))
+	{
+		jpeg_destroy_compress(&cinfo);
+		free(buffer);
+		return false;
+	}
+
+	jpeg_create_compress(&cinfo);
+	jpeg_mem_dest(&cinfo, &buffer, &length);
+
+	cinfo.image_width = size.x;
+	cinfo.image_height = size.y;
+	cinfo.input_components = layout.gray ? 1 : 3;
+	cinfo.in_color_space = layout.gray ? JCS_GRAYSCALE : JCS_RGB;
+	jpeg_set_defaults(&cinfo);
+	jpeg_set_quality(&cinfo, quality, TRUE);
+	cinfo.comp_info[0].h_samp_factor = layout.hSamp;
+	cinfo.comp_info[0].v_samp_factor = layout.vSamp;
+	if (layout.progressive)
+		jpeg_simple_progression(&cinfo);
+
+	jpeg_start_compress(&cinfo, TRUE);
+	while (cinfo.next_scanline < cinfo.image_height)
+	{
+		const unsigned char* src = &rgb[(size_t)cinfo.next_scanline * size.x * 3];
+		for (unsigned int x = 0; x < size.x; x++)
+		{
+			if (layout.gray)
+				row[x] = src[x * 3 + 1];
+			else
+				memcpy(&row[x * 3], src + x * 3, 3);
+		}
+		JSAMPROW rowPointer = row.data();
+		jpeg_write_scanlines(&cinfo, &rowPointer, 1);
+	}
+	jpeg_finish_compress(&cinfo);
+	jpeg_destroy_compress(&cinfo);
+
+	jpeg.assign(buffer, buffer + length);
+	free(buffer);
+	return true;
+}
+
+// FNV-1a over the decoded pixels, 0 when the decode failed
+static uint64_t HashDecode(const std::vector<unsigned char>& jpeg, const rave::DecodeOptions& options)
+{
+	auto size = rave::ImageSize(jpeg.data(), jpeg.size(), rave::ImageFormat::JPEG, options);
+	if (size.GetResult().Failed())
+		return 0;
+
+	std::vector<rave::Color> pixels((size_t)size.Get().x * size.Get().y);
+	if (rave::ReadJPEGRaw(jpeg.data(), jpeg.size(), pixels.data(), options).Failed())
+		return 0;
+
+	uint64_t hash = 0xCBF29CE484222325ull;
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(pixels.data());
+	for (size_t i = 0; i < pixels.size() * sizeof(rave::Color); i++)
+		hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+	return hash;
+}
+
+struct SimdCheckDecode
+{
+	std::string name;
+	const std::vector<unsigned char>* pJpeg;
+	rave::DecodeOptions options;
+};
+
+bool bench::CheckJpegSimd()
+{
+	const int available = jpeg_simd_limit(2);
+	if (available == 0)
+	{
+		printf("This build or CPU has no JPEG SIMD kernels, there is nothing to compare\n");
+		return true;
+	}
+
+	std::vector<std::vector<unsigned char>> files;
+	std::vector<SimdCheckDecode> decodes;
+	files.reserve(std::size(simdCheckLayouts) * std::size(simdCheckSizes) * std::size(simdCheckQualities));
+
+	std::vector<unsigned char> rgb;
+	for (const SimdCheckSize& size : simdCheckSizes)
+	{
+		FillPixels(size, rgb);
+		for (const SimdCheckLayout& layout : simdCheckLayouts)
+		{
+			for (int quality : simdCheckQualities)
+			{
+				files.emplace_back();
+				if (!EncodeJpeg(rgb, size, layout, quality, files.back()))
+				{
+					printf("Unable to encode the %s test JPEG\n", layout.name);
+					return false;
+				}
+
+				const std::string fileName = std::string(layout.name) + "_" + std::to_string(size.x) + "x" + std::to_string(size.y) + "_q" + std::to_string(quality);
+				for (J_DCT_METHOD method : simdCheckMethods)
+				{
+					for (bool fancy : { true, false })
+					{
+						for (unsigned int eighths = 1; eighths <= 8; eighths++)
+						{
+							SimdCheckDecode decode;
+							decode.name = fileName + " dct" + std::to_string((int)method) + (fancy ? " fancy" : " plain") + " " + std::to_string(eighths) + "/8";
+							decode.pJpeg = &files.back();
+							decode.options.dctMethod = method;
+							decode.options.fancyUpsampling = fancy;
+							decode.options.scale = eighths / 8.0f;
+							decodes.push_back(decode);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// The C results first, then every SIMD level against them
+	std::vector<uint64_t> reference(decodes.size());
+	jpeg_simd_limit(0);
+	for (size_t i = 0; i < decodes.size(); i++)
+		reference[i] = HashDecode(*decodes[i].pJpeg, decodes[i].options);
+
+	size_t mismatches = 0;
+	for (int level = 1; level <= available; level++)
+	{
+		jpeg_simd_limit(level);
+		size_t levelMismatches = 0;
+		for (size_t i = 0; i < decodes.size(); i++)
+		{
+			const uint64_t hash = HashDecode(*decodes[i].pJpeg, decodes[i].options);
+			if (reference[i] == 0 || hash != reference[i])
+			{
+				printf("  %s differs from C: %s\n", simdLevelNames[level], decodes[i].name.c_str());
+				levelMismatches++;
+			}
+		}
+		printf("JPEG %s against C: %zu decodes, %zu mismatches\n", simdLevelNames[level], decodes.size(), levelMismatches);
+		mismatches += levelMismatches;
+	}
+	jpeg_simd_limit(2);
+
+	return mismatches == 0;
+}
\ No newline at end of file
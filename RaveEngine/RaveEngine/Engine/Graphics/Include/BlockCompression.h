@@ -0,0 +1,75 @@
+#pragma once
+#include "Engine/Graphics/Include/MipChain.h"
+
+namespace rave
+{
+	enum class BlockFormat
+	{
+		// RGB at 4 bits per pixel, alpha is dropped
+		BC1,
+		// BC1 colour with a separately interpolated alpha, 8 bits per pixel
+		BC3,
+		// Red only, 4 bits per pixel
+		BC4,
+		// Red and green, 8 bits per pixel
+		BC5,
+		// RGBA at 8 bits per pixel with the best quality of the lot
+		BC7
+	};
+
+	enum class BlockQuality
+	{
+		// One endpoint fit per block, from the block's bounds. BC1 and BC4 find the bounds and the indices in SIMD registers
+		Fast,
+		// Endpoints refined by least squares. BC4 also tries its six value mode, BC7 two-subset partitions for opaque blocks
+		High
+	};
+
+	struct BlockOptions
+	{
+		BlockFormat format = BlockFormat::BC1;
+		BlockQuality quality = BlockQuality::Fast;
+		// Block rows of large levels are split over this pool, or over the shared one without it.
+		// Compressing on a worker of that pool, or on any pool's worker when none is given, stays on the calling thread
+		ThreadPool* pPool = nullptr;
+	};
+
+	// Bytes per 4x4 block
+	size_t BlockBytes(BlockFormat format) noexcept;
+	// Sizes that aren't a multiple of 4 are rounded up to whole blocks, the extra pixels repeat the edge
+	size_t CompressedByteSize(const Size& size, BlockFormat format) noexcept;
+
+	// Writes CompressedByteSize(size, options.format) bytes to dst, row of blocks after row of blocks
+	void CompressBlocks(const Color* pixels, const Size& size, unsigned char* dst, const BlockOptions& options = {});
+
+	// Every level of a texture in one block compressed allocation, laid out like a MipChain
+	class CompressedTexture
+	{
+	public:
+		CompressedTexture() = default;
+		CompressedTexture(const TextureBuffer<Color>& texture, const BlockOptions& options = {});
+		CompressedTexture(const MipChain& mips, const BlockOptions& options = {});
+
+		void Compress(const Color* pixels, const Size& size, const BlockOptions& options = {});
+		void Compress(const MipChain& mips, const BlockOptions& options = {});
+
+		BlockFormat GetFormat() const noexcept;
+		unsigned int GetLevelCount() const noexcept;
+		// In pixels
+		Size GetSize(unsigned int level) const noexcept;
+		// In bytes, from the start of Data()
+		size_t GetOffset(unsigned int level) const noexcept;
+		const unsigned char* GetLevel(unsigned int level) const noexcept;
+
+		const unsigned char* Data() const noexcept;
+		size_t GetByteSize() const noexcept;
+
+	private:
+		void Compress(unsigned int levelCount, const Color* const* levels, const Size* levelSizes, const BlockOptions& options);
+
+		BlockFormat format = BlockFormat::BC1;
+		std::vector<unsigned char> data;
+		std::vector<Size> sizes;
+		std::vector<size_t> offsets;
+	};
+}
\ No newline at end of file
@@ -1,6 +1,10 @@
 #pragma once
 #include "Engine/Graphics/Include/TextureBuffer.h"
+#include "Engine/Graphics/Include/TextureCache.h"
+#include "Engine/Graphics/Include/ImageLoadQueue.h"
 #include "Engine/Utilities/Include/VulkanPointer.h"
+#include "Engine/Utilities/Include/ThreadPool.h"
+#include "Engine/Utilities/Include/ArrayView.h"
 
 namespace rave
 {
@@ -12,13 +16,35 @@ namespace rave
 		Image(const int width, const int height);
 		Image(const int width, const int height, const Color& background);
 
-		Result Load(const char* filename);
+		// With the cache enabled, a matching .rtex entry is used straight from its mapping. Without one the file is decoded and
+		// a new entry is written for the next load. A failed write leaves the image loaded and is returned as a warning
+		Result Load(const char* filename, const DecodeOptions& options = {}, const TextureCacheSettings& cacheSettings = {});
+		// Same as Load, but on the background threads of the default ImageLoadQueue, so the caller never waits on a decode
+		static ImageLoadHandle LoadAsync(const char* filename, LoadPriority priority = LoadPriority::Visible, const DecodeOptions& options = {}, const TextureCacheSettings& cacheSettings = {});
 
 		void Load(const int width, const int height);
 		void Load(const int width, const int height, const Color& background);
 
+		Size GetSize() const noexcept;
+		const Color* Data() const noexcept;
+
 	private:
+		friend class ImageLoadQueue;
+
+		// The two halves of Load: mapping the file and trying the cache, then decoding when the cache missed
+		Result MapSource(const char* filename, const DecodeOptions& options, const TextureCacheSettings& cacheSettings, FileMapping& file, TextureSource& source, bool& cached);
+		Result DecodeSource(const char* filename, const DecodeOptions& options, const TextureCacheSettings& cacheSettings, const FileMapping& file, TextureSource& source);
+
 		TextureBuffer<Color> buffer;
+		TextureCache cache;
 		vk::SurfaceKHR surface;
 	};
+
+	Result LoadTexture(const char* filename, TextureBuffer<Color>& texture, const DecodeOptions& options = {});
+	Result LoadTexture(const void* bytes, size_t length, TextureBuffer<Color>& texture, const DecodeOptions& options = {});
+
+	// Decodes every file into the texture at the same index, spreading the files over the pool.
+	// Textures that already have the right size are reused without reallocating.
+	std::vector<Result> LoadImages(array_view<const char* const> filenames, array_view<TextureBuffer<Color>> textures, ThreadPool& pool, const DecodeOptions& options = {});
+	std::vector<Result> LoadImages(array_view<const char* const> filenames, array_view<TextureBuffer<Color>> textures, size_t threadCount = 0, const DecodeOptions& options = {});
 }
\ No newline at end of file
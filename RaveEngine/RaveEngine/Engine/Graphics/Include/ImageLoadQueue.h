@@ -0,0 +1,74 @@
+#pragma once
+#include "Engine/Include/ImageLoader.h"
+#include "Engine/Graphics/Include/TextureCache.h"
+#include <memory>
+#include <functional>
+#include <thread>
+
+namespace rave
+{
+	class Image;
+	struct ImageLoadState;
+	struct ImageLoadCore;
+
+	enum class LoadPriority
+	{
+		// Needed on screen now, goes before every prefetch
+		Visible,
+		// Likely needed soon, only loaded when no visible load is waiting
+		Prefetch
+	};
+
+	// Shared ownership of one load started by Image::LoadAsync or ImageLoadQueue::Load. Copies refer to the same load
+	class ImageLoadHandle
+	{
+	public:
+		ImageLoadHandle() = default;
+
+		bool IsValid() const noexcept;
+		// True once the load has succeeded, failed or been cancelled
+		bool IsReady() const;
+		Result Wait() const;
+		// Only to be used once the load is ready. The image lives as long as any handle to the load
+		Image& GetImage() const;
+
+		// A load that hasn't started is dropped right away, one in flight is reported cancelled when it stops
+		void Cancel() const;
+		// Moves a waiting load to the back of the queue for the new priority, like a prefetch that became visible
+		void SetPriority(LoadPriority priority) const;
+		// Runs on the loading thread when the load ends, or right here when it already has. Cancelled loads run it too, with a failed result
+		void Then(std::function<void(Image&, const Result&)> continuation) const;
+
+	private:
+		friend class ImageLoadQueue;
+		ImageLoadHandle(std::shared_ptr<ImageLoadState> state);
+
+		std::shared_ptr<ImageLoadState> state;
+	};
+
+	// Background threads for asynchronous image loads. I/O threads map the file and check its texture cache,
+	// decode threads decode whatever the cache can't serve. Both take visible loads before prefetches, each in the order they came in
+	class ImageLoadQueue
+	{
+	public:
+		// 0 decode threads uses one per hardware core but one, so the caller keeps a core to itself
+		ImageLoadQueue(size_t ioThreadCount = 1, size_t decodeThreadCount = 0);
+		ImageLoadQueue(const ImageLoadQueue&) = delete;
+		ImageLoadQueue& operator= (const ImageLoadQueue&) = delete;
+		// Loads in flight finish the step they are on, everything else is reported cancelled
+		~ImageLoadQueue();
+
+		ImageLoadHandle Load(const char* filename, LoadPriority priority = LoadPriority::Visible, const DecodeOptions& options = {}, const TextureCacheSettings& cacheSettings = {});
+
+		// Used by Image::LoadAsync, started on first use
+		static ImageLoadQueue& GetDefault();
+
+	private:
+		void WorkerLoop(int stage);
+		static void RunRead(const std::shared_ptr<ImageLoadState>& state);
+		static void RunDecode(const std::shared_ptr<ImageLoadState>& state);
+
+		std::shared_ptr<ImageLoadCore> core;
+		std::vector<std::thread> threads;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+#include "Engine/Graphics/Include/TextureBuffer.h"
+#include "Engine/Utilities/Include/ThreadPool.h"
+#include <future>
+#include <string>
+
+namespace rave
+{
+	// The PNG row filter, applied before deflating
+	enum class PngFilter
+	{
+		None,
+		Sub,
+		Up,
+		Average,
+		Paeth,
+		// Picks the filter with the smallest sum of absolute differences for every row, like libpng does
+		Adaptive
+	};
+
+	struct PngWriteOptions
+	{
+		PngFilter filter = PngFilter::Adaptive;
+		// Rows are deflated in independent chunks of about this many bytes, primed with the 32KB before them so the ratio barely suffers
+		size_t chunkSize = 128 * 1024;
+		// Chunks are filtered and deflated on this pool, or for large images on the shared one without it.
+		// Encoding on a worker of that pool, or on any pool's worker when none is given, stays on the calling thread
+		ThreadPool* pPool = nullptr;
+	};
+
+	// Level is the zlib level, 0 stores and 9 compresses the most
+	Result EncodePNG(const Color* pixels, const Size& size, std::vector<unsigned char>& png, int level = 6, const PngWriteOptions& options = {});
+	Result WritePNG(const Color* pixels, const Size& size, const char* filename, int level = 6, const PngWriteOptions& options = {});
+	Result WritePNG(const TextureBuffer<Color>& texture, const char* filename, int level = 6, const PngWriteOptions& options = {});
+
+	// Encodes and writes on a thread of its own, so a capture doesn't stall the frame. Move the texture in to avoid the copy
+	std::future<Result> WritePNGAsync(TextureBuffer<Color> texture, std::string filename, int level = 6, const PngWriteOptions& options = {});
+
+	struct JpegWriteOptions
+	{
+		// libjpeg's quality scale, from 1 to 100
+		int quality = 90;
+		// Store chroma at half the resolution both ways (4:2:0), as cameras do. Without it every pixel keeps its own colour
+		bool subsampleChroma = true;
+		// A restart marker every this many MCU rows (16 pixel rows with subsampling, 8 without) lets ReadJPEGRaw decode
+		// the file in strips on several threads. Each marker costs a few bytes, 0 leaves them out
+		unsigned int restartRows = 1;
+	};
+
+	// JPEG has no alpha, it is dropped
+	Result EncodeJPEG(const Color* pixels, const Size& size, std::vector<unsigned char>& jpeg, const JpegWriteOptions& options = {});
+	Result WriteJPEG(const Color* pixels, const Size& size, const char* filename, const JpegWriteOptions& options = {});
+	Result WriteJPEG(const TextureBuffer<Color>& texture, const char* filename, const JpegWriteOptions& options = {});
+
+	// EncodeQOI lives next to the readers in ImageLoader.h
+	Result WriteQOI(const TextureBuffer<Color>& texture, const char* filename);
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+#include "Engine/Graphics/Include/TextureBuffer.h"
+#include "Engine/Utilities/Include/ThreadPool.h"
+
+namespace rave
+{
+	enum class MipFilter
+	{
+		// 2x2 average of the level above
+		Box,
+		// Separable windowed sinc filters, sharper than a box but several times slower
+		Lanczos,
+		Kaiser
+	};
+
+	struct MipOptions
+	{
+		MipFilter filter = MipFilter::Box;
+		// Filter in linear light, so bright detail doesn't darken in the smaller levels
+		bool srgb = true;
+		// Large levels are split over this pool, or over the shared one without it.
+		// Generating on a worker of that pool, or on any pool's worker when none is given, stays on the calling thread
+		ThreadPool* pPool = nullptr;
+	};
+
+	// Every level of a texture down to 1x1, stored back to back in one allocation
+	class MipChain
+	{
+	public:
+		MipChain() = default;
+		MipChain(const TextureBuffer<Color>& texture, const MipOptions& options = {});
+
+		void Generate(const Color* pixels, const Size& size, const MipOptions& options = {});
+
+		unsigned int GetLevelCount() const noexcept;
+		Size GetSize(unsigned int level) const noexcept;
+		// In pixels, from the start of Data()
+		size_t GetOffset(unsigned int level) const noexcept;
+		Color* GetLevel(unsigned int level) noexcept;
+		const Color* GetLevel(unsigned int level) const noexcept;
+
+		Color* Data() noexcept;
+		const Color* Data() const noexcept;
+		// Pixels in all levels together
+		size_t GetLength() const noexcept;
+
+	private:
+		std::vector<Color> data;
+		std::vector<Size> sizes;
+		std::vector<size_t> offsets;
+	};
+
+	MipChain GenerateMips(const TextureBuffer<Color>& texture, const MipOptions& options = {});
+}
\ No newline at end of file
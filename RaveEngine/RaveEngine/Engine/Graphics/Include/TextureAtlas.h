@@ -0,0 +1,87 @@
+#pragma once
+#include "Engine/Graphics/Include/TextureBuffer.h"
+#include <string>
+#include <unordered_map>
+
+namespace rave
+{
+	struct AtlasOptions
+	{
+		// Width and height of a page, a power of two
+		unsigned int pageSize = 1024;
+		// Images too large for a normal page get a page of their own, rounded up to a power of two no larger than this
+		unsigned int maxPageSize = 4096;
+		// Pixels kept free around every image, so neighbours don't bleed into each other when sampling lower mips
+		unsigned int padding = 2;
+		// Fills the padding with the image's edge pixels instead of leaving it transparent, which hides filtering seams
+		bool edgeBleed = true;
+	};
+
+	struct AtlasRect
+	{
+		unsigned int page = 0;
+		// In pixels, without the padding
+		Size position = { 0, 0 };
+		Size size = { 0, 0 };
+		Vector2 uvMin = { 0.0f, 0.0f };
+		Vector2 uvMax = { 0.0f, 0.0f };
+	};
+
+	struct AtlasSource
+	{
+		std::string name;
+		const Color* pixels = nullptr;
+		Size size = { 0, 0 };
+	};
+
+	// Packs many small images into a few pages with MaxRects, so they can all be drawn with one bind per page.
+	// Every insert goes into the free space left on the existing pages, nothing already placed ever moves
+	class TextureAtlas
+	{
+	public:
+		TextureAtlas(const AtlasOptions& options = {});
+
+		// Sorts the images from large to small first, which packs noticeably tighter than inserting them one by one
+		Result Insert(array_view<const AtlasSource> sources);
+		Result Insert(const std::string& name, const Color* pixels, const Size& size);
+		Result Insert(const std::string& name, const TextureBuffer<Color>& texture);
+		// Keyed by the file name
+		Result InsertFile(const char* filename);
+
+		bool Contains(const std::string& name) const;
+		OptionalResult<AtlasRect> Find(const std::string& name) const;
+		const std::unordered_map<std::string, AtlasRect>& GetRects() const noexcept;
+
+		unsigned int GetPageCount() const noexcept;
+		const TextureBuffer<Color>& GetPage(unsigned int page) const noexcept;
+		// Raised by every insert that touches the page, so only the pages that changed need uploading again
+		unsigned int GetPageRevision(unsigned int page) const noexcept;
+
+		void Clear() noexcept;
+
+	private:
+		struct Rect
+		{
+			unsigned int x = 0;
+			unsigned int y = 0;
+			unsigned int width = 0;
+			unsigned int height = 0;
+		};
+
+		struct Page
+		{
+			TextureBuffer<Color> pixels;
+			std::vector<Rect> freeRects;
+			unsigned int revision = 0;
+		};
+
+		bool FindPosition(const Page& page, unsigned int width, unsigned int height, Rect& best, unsigned int& bestShortSide, unsigned int& bestLongSide) const;
+		void Place(Page& page, const Rect& used);
+		void Blit(Page& page, const Rect& cell, const Color* pixels, const Size& size);
+		Page& AddPage(unsigned int size);
+
+		AtlasOptions options;
+		std::vector<Page> pages;
+		std::unordered_map<std::string, AtlasRect> rects;
+	};
+}
\ No newline at end of file
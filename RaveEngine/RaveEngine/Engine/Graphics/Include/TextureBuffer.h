@@ -24,13 +24,13 @@ namespace rave
 			if (rhs.IsActive())
 				std::copy(rhs.begin(), rhs.end(), begin());
 		}
-		TextureBuffer(TextureBuffer&& rhs)
+		TextureBuffer(TextureBuffer&& rhs) noexcept
 			:
-			data(rhs.IsActive() ? new T[rhs.size.x * rhs.size.y] : nullptr),
-			size(rhs.IsActive() ? rhs.size : Size(0, 0))
+			data(rhs.data),
+			size(rhs.size)
 		{
-			if (rhs.IsActive())
-				std::move(rhs.begin(), rhs.end(), begin());
+			rhs.data = nullptr;
+			rhs.size = { 0, 0 };
 		}
 
 		TextureBuffer& operator= (const TextureBuffer& rhs)
@@ -42,16 +42,19 @@ namespace rave
 				data = new T[size.x * size.y];
 				std::copy(rhs.begin(), rhs.end(), begin());
 			}
+			return *this;
 		}
-		TextureBuffer& operator= (TextureBuffer&& rhs)
+		TextureBuffer& operator= (TextureBuffer&& rhs) noexcept
 		{
-			CleanUp();
-			if (rhs.IsActive())
+			if (this != &rhs)
 			{
+				CleanUp();
+				data = rhs.data;
 				size = rhs.size;
-				data = new T[size.x * size.y];
-				std::move(rhs.begin(), rhs.end(), begin());
+				rhs.data = nullptr;
+				rhs.size = { 0, 0 };
 			}
+			return *this;
 		}
 
 		void Load(const int width, const int height)
@@ -157,7 +160,7 @@ namespace rave
 			if (data)
 				delete[] data;
 
-			Size size = { 0, 0 };
+			size = { 0, 0 };
 			data = nullptr;
 		}
 
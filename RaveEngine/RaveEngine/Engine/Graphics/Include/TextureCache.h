@@ -0,0 +1,98 @@
+#pragma once
+#include "Engine/Graphics/Include/MipChain.h"
+#include "Engine/Utilities/Include/FileMapping.h"
+#include <stdint.h>
+#include <string>
+
+namespace rave
+{
+	enum class TextureCacheFormat : uint32_t
+	{
+		RGBA8
+	};
+
+	// Layout of a .rtex file: this header, then the pixels of every level starting at the first page boundary.
+	// Levels follow each other directly, so a mapped file is used in place without any decoding or copying
+	struct TextureCacheHeader
+	{
+		static constexpr uint32_t magicValue = 0x58455452;	// "RTEX"
+		static constexpr uint32_t currentVersion = 1;
+		static constexpr uint32_t maxLevels = 32;
+		static constexpr uint64_t pageSize = 4096;
+
+		uint32_t magic = magicValue;
+		uint32_t version = currentVersion;
+		TextureCacheFormat format = TextureCacheFormat::RGBA8;
+		uint32_t levelCount = 0;
+		uint32_t width = 0;
+		uint32_t height = 0;
+
+		// The decode options the pixels were made with, an entry only serves loads with the same ones
+		uint32_t maxWidth = 0;
+		uint32_t maxHeight = 0;
+		float scale = 1.0f;
+		// The JPEG quality settings, 0 for the defaults. Checksum settings don't change the pixels and aren't kept
+		uint32_t quality = 0;
+
+		uint64_t sourceSize = 0;
+		int64_t sourceTime = 0;
+		uint64_t sourceHash = 0;
+
+		// In bytes, from the start of the file
+		uint64_t levelOffsets[maxLevels] = {};
+	};
+
+	// Stamp of the file a cache entry was made from
+	struct TextureSource
+	{
+		uint64_t size = 0;
+		int64_t time = 0;
+		uint64_t hash = 0;
+	};
+
+	// Fills in the size and modification time, the hash is left at 0
+	OptionalResult<TextureSource> StatTextureSource(const char* filename);
+	uint64_t HashTextureSource(const void* bytes, size_t length) noexcept;
+
+	// Whether and where Image::Load keeps .rtex entries of the files it decodes
+	struct TextureCacheSettings
+	{
+		// Off by default, since a miss hashes the whole source and writes its pixels uncompressed at full size
+		bool enabled = false;
+		// Empty keeps every entry next to its source, which needs the asset folder to be writable
+		std::string directory;
+	};
+
+	// The cache entry of a source image. Without a directory it lives next to the source with .rtex appended, otherwise in
+	// that directory, named after the source's file name and a hash of its whole path so sources of the same name don't collide
+	std::string TextureCachePath(const char* sourceFilename, const std::string& directory = {});
+
+	// A read-only mapping of a .rtex file
+	class TextureCache
+	{
+	public:
+		TextureCache() = default;
+
+		// Checks the header and that every level lies inside the file
+		Result Open(const char* filename);
+		void Close() noexcept;
+		bool IsOpen() const noexcept;
+
+		// True when the entry was made from this source with these options. The size and time are compared first,
+		// the source bytes are only hashed when the time differs, as it does after a copy or a checkout
+		bool Matches(const TextureSource& source, const DecodeOptions& options, const void* sourceBytes, size_t sourceLength) const noexcept;
+
+		const TextureCacheHeader& GetHeader() const noexcept;
+		unsigned int GetLevelCount() const noexcept;
+		Size GetSize(unsigned int level = 0) const noexcept;
+		const Color* GetLevel(unsigned int level = 0) const noexcept;
+
+	private:
+		FileMapping file;
+		const TextureCacheHeader* header = nullptr;
+	};
+
+	// The file is written under a temporary name and then renamed, so readers never see half of it
+	Result WriteTextureCache(const char* filename, const MipChain& mips, const TextureSource& source, const DecodeOptions& options = {});
+	Result WriteTextureCache(const char* filename, const Color* pixels, const Size& size, const TextureSource& source, const DecodeOptions& options = {});
+}
\ No newline at end of file
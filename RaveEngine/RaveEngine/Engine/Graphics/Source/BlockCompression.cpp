@@ -0,0 +1,1153 @@
+#include "Engine/Graphics/Include/BlockCompression.h"
+#include "Engine/Utilities/Include/CpuFeatures.h"
+#include <stdint.h>
+#include <string.h>
+#include <cmath>
+
+#if defined(RE_ARCH_X86)
+#include <immintrin.h>
+#endif
+
+// Levels with fewer blocks than this aren't worth splitting over threads
+static constexpr size_t parallelBlocks = 64 * 64;
+// Partitions BC7 encodes in full, after ranking all 64 by how well each subset fits a line
+static constexpr unsigned int bc7PartitionTries = 3;
+
+static const float bc1Weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+static const int bc7Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+static const int bc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// Bit i is the subset of pixel i
+static const uint16_t bc7Partitions2[64] =
+{
+	0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+	0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+	0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+	0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22
+};
+
+// The pixel of the second subset whose index drops its top bit
+static const unsigned char bc7Anchors2[64] =
+{
+	15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+	15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+	15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+	 6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15
+};
+
+// Fills the block with whole bytes LSB first, the order every BCn format uses
+class BlockWriter
+{
+public:
+	BlockWriter(unsigned char* dst)
+		:
+		dst(dst)
+	{
+		memset(dst, 0, 16);
+	}
+
+	void Write(uint32_t value, unsigned int count)
+	{
+		for (unsigned int i = 0; i < count; i++, position++)
+			if ((value >> i) & 1)
+				dst[position >> 3] |= (unsigned char)(1 << (position & 7));
+	}
+
+private:
+	unsigned char* dst;
+	unsigned int position = 0;
+};
+
+template<typename T>
+static T Clamp(T value, T low, T high)
+{
+	return std::min(std::max(value, low), high);
+}
+
+// Blocks past the right or bottom edge repeat the last column or row
+static void LoadBlock(const rave::Color* pixels, const rave::Size& size, unsigned int blockX, unsigned int blockY, rave::Color* block)
+{
+	for (unsigned int y = 0; y < 4; y++)
+	{
+		const rave::Color* row = pixels + (size_t)std::min(blockY * 4 + y, size.y - 1) * size.x;
+		for (unsigned int x = 0; x < 4; x++)
+			block[y * 4 + x] = row[std::min(blockX * 4 + x, size.x - 1)];
+	}
+}
+
+static void BlockToFloat(const rave::Color* block, float (*points)[4])
+{
+	for (unsigned int i = 0; i < 16; i++)
+	{
+		points[i][0] = block[i].r;
+		points[i][1] = block[i].g;
+		points[i][2] = block[i].b;
+		points[i][3] = block[i].a;
+	}
+}
+
+// Endpoints along the principal axis of the members, found by power iteration on their covariance
+template<int N>
+static void FitLine(const float (*points)[4], const unsigned char* members, unsigned int count, float* e0, float* e1)
+{
+	float mean[N] = {};
+	for (unsigned int i = 0; i < count; i++)
+		for (int c = 0; c < N; c++)
+			mean[c] += points[members[i]][c];
+	for (int c = 0; c < N; c++)
+		mean[c] /= count;
+
+	float covariance[N][N] = {};
+	for (unsigned int i = 0; i < count; i++)
+		for (int a = 0; a < N; a++)
+			for (int b = 0; b < N; b++)
+				covariance[a][b] += (points[members[i]][a] - mean[a]) * (points[members[i]][b] - mean[b]);
+
+	// Starting from the row of the widest channel can't leave the iteration orthogonal to the answer
+	int widest = 0;
+	for (int c = 1; c < N; c++)
+		if (covariance[c][c] > covariance[widest][widest])
+			widest = c;
+
+	float axis[N];
+	for (int c = 0; c < N; c++)
+		axis[c] = covariance[widest][c];
+
+	for (int iteration = 0; iteration < 8; iteration++)
+	{
+		float next[N] = {};
+		float length = 0.0f;
+		for (int a = 0; a < N; a++)
+		{
+			for (int b = 0; b < N; b++)
+				next[a] += covariance[a][b] * axis[b];
+			length = std::max(length, std::abs(next[a]));
+		}
+		if (length == 0.0f)
+			break;
+		for (int c = 0; c < N; c++)
+			axis[c] = next[c] / length;
+	}
+
+	float low = 0.0f;
+	float high = 0.0f;
+	float lengthSq = 0.0f;
+	for (int c = 0; c < N; c++)
+		lengthSq += axis[c] * axis[c];
+	if (lengthSq > 0.0f)
+	{
+		low = 1e30f;
+		high = -1e30f;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			float t = 0.0f;
+			for (int c = 0; c < N; c++)
+				t += (points[members[i]][c] - mean[c]) * axis[c];
+			low = std::min(low, t);
+			high = std::max(high, t);
+		}
+		low /= lengthSq;
+		high /= lengthSq;
+	}
+
+	for (int c = 0; c < N; c++)
+	{
+		e0[c] = Clamp(mean[c] + axis[c] * low, 0.0f, 255.0f);
+		e1[c] = Clamp(mean[c] + axis[c] * high, 0.0f, 255.0f);
+	}
+}
+
+// Turns the bounding box in e0 (minimum) and e1 (maximum) into the corners that lie along the block's trend,
+// each channel is flipped when it falls as green rises
+template<int N>
+static void OrientBox(const float (*points)[4], const unsigned char* members, unsigned int count, float* e0, float* e1)
+{
+	float mean[N] = {};
+	for (unsigned int i = 0; i < count; i++)
+		for (int c = 0; c < N; c++)
+			mean[c] += points[members[i]][c];
+	for (int c = 0; c < N; c++)
+		mean[c] /= count;
+
+	for (int c = 0; c < N; c++)
+	{
+		if (c == 1)
+			continue;
+		float covariance = 0.0f;
+		for (unsigned int i = 0; i < count; i++)
+			covariance += (points[members[i]][c] - mean[c]) * (points[members[i]][1] - mean[1]);
+		if (covariance < 0.0f)
+			std::swap(e0[c], e1[c]);
+	}
+}
+
+// Least squares endpoints for fixed indices, weights holds how much of e1 each index is made of
+template<int N>
+static bool SolveEndpoints(const float (*points)[4], const unsigned char* members, unsigned int count, const unsigned char* indices, const float* weights, float* e0, float* e1)
+{
+	float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+	float ax[N] = {};
+	float bx[N] = {};
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const float w = weights[indices[i]];
+		aa += (1.0f - w) * (1.0f - w);
+		bb += w * w;
+		ab += (1.0f - w) * w;
+		for (int c = 0; c < N; c++)
+		{
+			ax[c] += (1.0f - w) * points[members[i]][c];
+			bx[c] += w * points[members[i]][c];
+		}
+	}
+
+	const float determinant = aa * bb - ab * ab;
+	if (std::abs(determinant) < 1e-6f)
+		return false;
+
+	for (int c = 0; c < N; c++)
+	{
+		e0[c] = Clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f);
+		e1[c] = Clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f);
+	}
+	return true;
+}
+
+static const unsigned char allMembers[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+
+// BC1
+
+static uint16_t PackRGB565(const float* rgb)
+{
+	const int r = Clamp((int)(rgb[0] * (31.0f / 255.0f) + 0.5f), 0, 31);
+	const int g = Clamp((int)(rgb[1] * (63.0f / 255.0f) + 0.5f), 0, 63);
+	const int b = Clamp((int)(rgb[2] * (31.0f / 255.0f) + 0.5f), 0, 31);
+	return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void UnpackRGB565(uint16_t color, int* rgb)
+{
+	const int r = color >> 11;
+	const int g = (color >> 5) & 63;
+	const int b = color & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+static void BC1Palette(uint16_t c0, uint16_t c1, int (*palette)[3])
+{
+	UnpackRGB565(c0, palette[0]);
+	UnpackRGB565(c1, palette[1]);
+	for (int c = 0; c < 3; c++)
+	{
+		palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+	}
+}
+
+// The palette lies on a line, so the nearest entry follows from where each pixel projects onto it.
+// Projections are compared against the midpoints between neighbouring entries, doubled to stay in integers
+static void BC1Stops(const int (*palette)[3], int* direction, int* stops)
+{
+	int dots[4];
+	for (int c = 0; c < 3; c++)
+		direction[c] = palette[0][c] - palette[1][c];
+	for (int i = 0; i < 4; i++)
+		dots[i] = palette[i][0] * direction[0] + palette[i][1] * direction[1] + palette[i][2] * direction[2];
+
+	stops[0] = dots[0] + dots[2];
+	stops[1] = dots[2] + dots[3];
+	stops[2] = dots[3] + dots[1];
+}
+
+// Index for the number of stops a projection passes
+static const unsigned char bc1StopIndices[4] = { 1, 3, 2, 0 };
+
+static void BC1IndicesScalar(const rave::Color* block, const int* direction, const int* stops, unsigned char* indices)
+{
+	for (unsigned int i = 0; i < 16; i++)
+	{
+		const int dot = 2 * (block[i].r * direction[0] + block[i].g * direction[1] + block[i].b * direction[2]);
+		indices[i] = bc1StopIndices[(dot > stops[0]) + (dot > stops[1]) + (dot > stops[2])];
+	}
+}
+
+#if defined(RE_ARCH_X86)
+static void BoundsSSE2(const rave::Color* block, rave::Color& low, rave::Color& high)
+{
+	const __m128i* rows = reinterpret_cast<const __m128i*>(block);
+	__m128i minimum = _mm_loadu_si128(rows);
+	__m128i maximum = minimum;
+	for (int i = 1; i < 4; i++)
+	{
+		const __m128i row = _mm_loadu_si128(rows + i);
+		minimum = _mm_min_epu8(minimum, row);
+		maximum = _mm_max_epu8(maximum, row);
+	}
+
+	// Fold the four pixels of each register onto the first one
+	minimum = _mm_min_epu8(minimum, _mm_shuffle_epi32(minimum, _MM_SHUFFLE(1, 0, 3, 2)));
+	minimum = _mm_min_epu8(minimum, _mm_shuffle_epi32(minimum, _MM_SHUFFLE(2, 3, 0, 1)));
+	maximum = _mm_max_epu8(maximum, _mm_shuffle_epi32(maximum, _MM_SHUFFLE(1, 0, 3, 2)));
+	maximum = _mm_max_epu8(maximum, _mm_shuffle_epi32(maximum, _MM_SHUFFLE(2, 3, 0, 1)));
+
+	const uint32_t minimumBits = (uint32_t)_mm_cvtsi128_si32(minimum);
+	const uint32_t maximumBits = (uint32_t)_mm_cvtsi128_si32(maximum);
+	low = rave::Color((unsigned char)minimumBits, (unsigned char)(minimumBits >> 8), (unsigned char)(minimumBits >> 16), (unsigned char)(minimumBits >> 24));
+	high = rave::Color((unsigned char)maximumBits, (unsigned char)(maximumBits >> 8), (unsigned char)(maximumBits >> 16), (unsigned char)(maximumBits >> 24));
+}
+
+static void BC1IndicesSSE2(const rave::Color* block, const int* direction, const int* stops, unsigned char* indices)
+{
+	// Doubled direction, so the dot products come out doubled like the stops. Alpha gets a weight of 0
+	const __m128i weights = _mm_setr_epi16(
+		(short)(2 * direction[0]), (short)(2 * direction[1]), (short)(2 * direction[2]), 0,
+		(short)(2 * direction[0]), (short)(2 * direction[1]), (short)(2 * direction[2]), 0);
+	const __m128i stop0 = _mm_set1_epi32(stops[0]);
+	const __m128i stop1 = _mm_set1_epi32(stops[1]);
+	const __m128i stop2 = _mm_set1_epi32(stops[2]);
+	const __m128i zero = _mm_setzero_si128();
+
+	alignas(16) int32_t passed[16];
+	for (int i = 0; i < 16; i += 4)
+	{
+		const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+		const __m128i low = _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), weights);
+		const __m128i high = _mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), weights);
+
+		// madd leaves every dot product split over two lanes, add the halves and gather the four sums
+		const __m128i lowSums = _mm_add_epi32(low, _mm_shuffle_epi32(low, _MM_SHUFFLE(2, 3, 0, 1)));
+		const __m128i highSums = _mm_add_epi32(high, _mm_shuffle_epi32(high, _MM_SHUFFLE(2, 3, 0, 1)));
+		const __m128i dots = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lowSums), _mm_castsi128_ps(highSums), _MM_SHUFFLE(2, 0, 2, 0)));
+
+		// Compares give -1 per stop passed
+		__m128i count = _mm_cmpgt_epi32(dots, stop0);
+		count = _mm_add_epi32(count, _mm_cmpgt_epi32(dots, stop1));
+		count = _mm_add_epi32(count, _mm_cmpgt_epi32(dots, stop2));
+		_mm_store_si128(reinterpret_cast<__m128i*>(passed + i), _mm_sub_epi32(zero, count));
+	}
+
+	for (int i = 0; i < 16; i++)
+		indices[i] = bc1StopIndices[passed[i]];
+}
+#endif
+
+static void Bounds(const rave::Color* block, rave::Color& low, rave::Color& high)
+{
+#if defined(RE_ARCH_X86)
+	BoundsSSE2(block, low, high);
+#else
+	low = high = block[0];
+	for (unsigned int i = 1; i < 16; i++)
+	{
+		low = rave::Color(std::min(low.r, block[i].r), std::min(low.g, block[i].g), std::min(low.b, block[i].b), std::min(low.a, block[i].a));
+		high = rave::Color(std::max(high.r, block[i].r), std::max(high.g, block[i].g), std::max(high.b, block[i].b), std::max(high.a, block[i].a));
+	}
+#endif
+}
+
+static void BC1Indices(const rave::Color* block, uint16_t c0, uint16_t c1, unsigned char* indices)
+{
+	int palette[4][3];
+	int direction[3];
+	int stops[3];
+	BC1Palette(c0, c1, palette);
+	BC1Stops(palette, direction, stops);
+
+#if defined(RE_ARCH_X86)
+	BC1IndicesSSE2(block, direction, stops, indices);
+#else
+	BC1IndicesScalar(block, direction, stops, indices);
+#endif
+}
+
+static int BC1Error(const rave::Color* block, uint16_t c0, uint16_t c1, const unsigned char* indices)
+{
+	int palette[4][3];
+	BC1Palette(c0, c1, palette);
+
+	int error = 0;
+	for (unsigned int i = 0; i < 16; i++)
+	{
+		const int* entry = palette[indices[i]];
+		const int r = block[i].r - entry[0];
+		const int g = block[i].g - entry[1];
+		const int b = block[i].b - entry[2];
+		error += r * r + g * g + b * b;
+	}
+	return error;
+}
+
+// Quantizes the endpoints and orders them for the four colour mode, which needs c0 > c1
+static void BC1Endpoints(const float* e0, const float* e1, uint16_t& c0, uint16_t& c1)
+{
+	c0 = PackRGB565(e0);
+	c1 = PackRGB565(e1);
+	if (c0 < c1)
+		std::swap(c0, c1);
+}
+
+static void WriteBC1(uint16_t c0, uint16_t c1, const unsigned char* indices, unsigned char* dst)
+{
+	uint32_t bits = 0;
+	// Equal endpoints select the three colour mode, where index 0 is still the endpoint colour
+	if (c0 != c1)
+		for (unsigned int i = 0; i < 16; i++)
+			bits |= (uint32_t)indices[i] << (2 * i);
+
+	dst[0] = (unsigned char)c0;
+	dst[1] = (unsigned char)(c0 >> 8);
+	dst[2] = (unsigned char)c1;
+	dst[3] = (unsigned char)(c1 >> 8);
+	for (int i = 0; i < 4; i++)
+		dst[4 + i] = (unsigned char)(bits >> (8 * i));
+}
+
+static void EncodeBC1(const rave::Color* block, rave::BlockQuality quality, unsigned char* dst)
+{
+	rave::Color low, high;
+	Bounds(block, low, high);
+
+	float points[16][4];
+	float e0[4], e1[4];
+	BlockToFloat(block, points);
+	for (int c = 0; c < 3; c++)
+	{
+		e0[c] = (&high.r)[c];
+		e1[c] = (&low.r)[c];
+	}
+
+	// The box corners along the trend, pulled in by a sixteenth of the range to centre them on the data
+	OrientBox<3>(points, allMembers, 16, e1, e0);
+	for (int c = 0; c < 3; c++)
+	{
+		const float inset = (e0[c] - e1[c]) / 16.0f;
+		e0[c] -= inset;
+		e1[c] += inset;
+	}
+
+	uint16_t c0, c1;
+	unsigned char indices[16];
+	BC1Endpoints(e0, e1, c0, c1);
+	BC1Indices(block, c0, c1, indices);
+
+	if (quality == rave::BlockQuality::High && !(low.r == high.r && low.g == high.g && low.b == high.b))
+	{
+		int best = BC1Error(block, c0, c1, indices);
+
+		uint16_t candidate0, candidate1;
+		unsigned char candidateIndices[16];
+		FitLine<3>(points, allMembers, 16, e0, e1);
+		BC1Endpoints(e0, e1, candidate0, candidate1);
+
+		for (int iteration = 0; iteration < 3; iteration++)
+		{
+			BC1Indices(block, candidate0, candidate1, candidateIndices);
+			const int error = BC1Error(block, candidate0, candidate1, candidateIndices);
+			if (error < best)
+			{
+				best = error;
+				c0 = candidate0;
+				c1 = candidate1;
+				memcpy(indices, candidateIndices, 16);
+			}
+
+			if (!SolveEndpoints<3>(points, allMembers, 16, candidateIndices, bc1Weights, e0, e1))
+				break;
+			BC1Endpoints(e0, e1, candidate0, candidate1);
+		}
+	}
+
+	WriteBC1(c0, c1, indices, dst);
+}
+
+// BC4, also the alpha half of BC3 and both halves of BC5
+
+static void BC4Palette(int a0, int a1, int* palette)
+{
+	palette[0] = a0;
+	palette[1] = a1;
+	if (a0 > a1)
+	{
+		for (int k = 2; k < 8; k++)
+			palette[k] = ((8 - k) * a0 + (k - 1) * a1 + 3) / 7;
+	}
+	else
+	{
+		for (int k = 2; k < 6; k++)
+			palette[k] = ((6 - k) * a0 + (k - 1) * a1 + 2) / 5;
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+// Exact nearest palette entries, returns the squared error
+static int BC4Indices(const unsigned char* values, int a0, int a1, unsigned char* indices)
+{
+	int palette[8];
+	BC4Palette(a0, a1, palette);
+
+	int error = 0;
+	for (unsigned int i = 0; i < 16; i++)
+	{
+		int best = 0x7FFFFFFF;
+		for (unsigned char k = 0; k < 8; k++)
+		{
+			const int distance = std::abs(values[i] - palette[k]);
+			if (distance < best)
+			{
+				best = distance;
+				indices[i] = k;
+			}
+		}
+		error += best * best;
+	}
+	return error;
+}
+
+// Steps from a0 down to a1 in the eight value mode, mapped to the index that holds them
+static const unsigned char bc4StepIndices[8] = { 0, 2, 3, 4, 5, 6, 7, 1 };
+
+#if defined(RE_ARCH_X86)
+// step = round((high - v) * 7 / range), found by counting the thresholds (2k - 1) * range / 14 that (high - v) passes
+static void BC4StepsSSE2(const unsigned char* values, int high, int low, unsigned char* steps)
+{
+	const int range = high - low;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+	const __m128i top = _mm_set1_epi16((short)high);
+	const __m128i fourteen = _mm_set1_epi16(14);
+
+	__m128i scaled[2] =
+	{
+		_mm_mullo_epi16(_mm_sub_epi16(top, _mm_unpacklo_epi8(bytes, zero)), fourteen),
+		_mm_mullo_epi16(_mm_sub_epi16(top, _mm_unpackhi_epi8(bytes, zero)), fourteen)
+	};
+	__m128i count[2] = { zero, zero };
+	for (int k = 1; k < 8; k++)
+	{
+		const __m128i threshold = _mm_set1_epi16((short)(range * (2 * k - 1) - 1));
+		count[0] = _mm_sub_epi16(count[0], _mm_cmpgt_epi16(scaled[0], threshold));
+		count[1] = _mm_sub_epi16(count[1], _mm_cmpgt_epi16(scaled[1], threshold));
+	}
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(steps), _mm_packus_epi16(count[0], count[1]));
+}
+#endif
+
+static void BC4Steps(const unsigned char* values, int high, int low, unsigned char* steps)
+{
+#if defined(RE_ARCH_X86)
+	BC4StepsSSE2(values, high, low, steps);
+#else
+	const int range = high - low;
+	for (unsigned int i = 0; i < 16; i++)
+		steps[i] = (unsigned char)(((high - values[i]) * 14 + range) / (2 * range));
+#endif
+}
+
+static void WriteBC4(int a0, int a1, const unsigned char* indices, unsigned char* dst)
+{
+	uint64_t bits = 0;
+	for (unsigned int i = 0; i < 16; i++)
+		bits |= (uint64_t)indices[i] << (3 * i);
+
+	dst[0] = (unsigned char)a0;
+	dst[1] = (unsigned char)a1;
+	for (int i = 0; i < 6; i++)
+		dst[2 + i] = (unsigned char)(bits >> (8 * i));
+}
+
+static void EncodeBC4(const rave::Color* block, int channel, rave::BlockQuality quality, unsigned char* dst)
+{
+	unsigned char values[16];
+	for (unsigned int i = 0; i < 16; i++)
+		values[i] = (&block[i].r)[channel];
+
+	rave::Color lowColor, highColor;
+	Bounds(block, lowColor, highColor);
+	const int low = (&lowColor.r)[channel];
+	const int high = (&highColor.r)[channel];
+
+	unsigned char indices[16] = {};
+	if (low == high)
+	{
+		WriteBC4(high, low, indices, dst);
+		return;
+	}
+
+	int a0 = high;
+	int a1 = low;
+	if (quality == rave::BlockQuality::Fast)
+	{
+		unsigned char steps[16];
+		BC4Steps(values, high, low, steps);
+		for (unsigned int i = 0; i < 16; i++)
+			indices[i] = bc4StepIndices[steps[i]];
+		WriteBC4(a0, a1, indices, dst);
+		return;
+	}
+
+	int best = BC4Indices(values, a0, a1, indices);
+	unsigned char candidate[16];
+
+	// Least squares in the eight value mode, index k >= 2 holds (k - 1) / 7 of a1
+	float points[16][4] = {};
+	for (unsigned int i = 0; i < 16; i++)
+		points[i][0] = values[i];
+	float weights[8] = { 0.0f, 1.0f };
+	for (int k = 2; k < 8; k++)
+		weights[k] = (k - 1) / 7.0f;
+
+	memcpy(candidate, indices, 16);
+	for (int iteration = 0; iteration < 2; iteration++)
+	{
+		float e0, e1;
+		if (!SolveEndpoints<1>(points, allMembers, 16, candidate, weights, &e0, &e1))
+			break;
+		const int c0 = (int)(e0 + 0.5f);
+		const int c1 = (int)(e1 + 0.5f);
+		if (c0 <= c1)
+			break;
+
+		const int error = BC4Indices(values, c0, c1, candidate);
+		if (error < best)
+		{
+			best = error;
+			a0 = c0;
+			a1 = c1;
+			memcpy(indices, candidate, 16);
+		}
+	}
+
+	// The six value mode has 0 and 255 for free, so its endpoints only need to span the values between them
+	int innerLow = 255;
+	int innerHigh = 0;
+	for (unsigned int i = 0; i < 16; i++)
+	{
+		if (values[i] != 0 && values[i] != 255)
+		{
+			innerLow = std::min<int>(innerLow, values[i]);
+			innerHigh = std::max<int>(innerHigh, values[i]);
+		}
+	}
+	if (innerLow > innerHigh)
+		innerLow = innerHigh = 0;
+
+	const int error = BC4Indices(values, innerLow, innerHigh, candidate);
+	if (error < best)
+	{
+		a0 = innerLow;
+		a1 = innerHigh;
+		memcpy(indices, candidate, 16);
+	}
+
+	WriteBC4(a0, a1, indices, dst);
+}
+
+// BC7. Mode 6 is one subset of RGBA with 4 bit indices, mode 1 two subsets of RGB with 3 bit indices
+
+static int UnquantizeBC7(int value, int bits)
+{
+	value <<= 8 - bits;
+	return value | (value >> bits);
+}
+
+// 7 bit endpoint channels with a p-bit of their own, the p-bit that rounds best is kept
+static int QuantizeMode6(const float* endpoint, int* quantized)
+{
+	int bestError = 0x7FFFFFFF;
+	int bestBit = 0;
+	for (int bit = 0; bit < 2; bit++)
+	{
+		int error = 0;
+		int candidate[4];
+		for (int c = 0; c < 4; c++)
+		{
+			candidate[c] = Clamp((int)std::floor((endpoint[c] - bit) / 2.0f + 0.5f), 0, 127);
+			const int difference = (candidate[c] * 2 + bit) - (int)(endpoint[c] + 0.5f);
+			error += difference * difference;
+		}
+		if (error < bestError)
+		{
+			bestError = error;
+			bestBit = bit;
+			memcpy(quantized, candidate, sizeof(candidate));
+		}
+	}
+	return bestBit;
+}
+
+// 6 bit endpoint channels, one p-bit shared by both endpoints of the subset
+static int QuantizeMode1(const float* e0, const float* e1, int* q0, int* q1)
+{
+	int bestError = 0x7FFFFFFF;
+	int bestBit = 0;
+	for (int bit = 0; bit < 2; bit++)
+	{
+		int error = 0;
+		int candidate[2][3];
+		for (int e = 0; e < 2; e++)
+		{
+			const float* endpoint = e ? e1 : e0;
+			for (int c = 0; c < 3; c++)
+			{
+				candidate[e][c] = Clamp((int)std::floor((endpoint[c] - 2 * bit) / 4.0f + 0.5f), 0, 63);
+				const int difference = UnquantizeBC7((candidate[e][c] << 1) | bit, 7) - (int)(endpoint[c] + 0.5f);
+				error += difference * difference;
+			}
+		}
+		if (error < bestError)
+		{
+			bestError = error;
+			bestBit = bit;
+			memcpy(q0, candidate[0], sizeof(candidate[0]));
+			memcpy(q1, candidate[1], sizeof(candidate[1]));
+		}
+	}
+	return bestBit;
+}
+
+// Exact nearest entries between two 8 bit endpoints, returns the squared error
+template<int N>
+static int BC7Indices(const float (*points)[4], const unsigned char* members, unsigned int count, const int* e0, const int* e1, const int* weights, int levels, unsigned char* indices)
+{
+	int palette[16][N];
+	for (int k = 0; k < levels; k++)
+		for (int c = 0; c < N; c++)
+			palette[k][c] = ((64 - weights[k]) * e0[c] + weights[k] * e1[c] + 32) >> 6;
+
+	int error = 0;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		int best = 0x7FFFFFFF;
+		for (int k = 0; k < levels; k++)
+		{
+			int distance = 0;
+			for (int c = 0; c < N; c++)
+			{
+				const int difference = (int)points[members[i]][c] - palette[k][c];
+				distance += difference * difference;
+			}
+			if (distance < best)
+			{
+				best = distance;
+				indices[i] = (unsigned char)k;
+			}
+		}
+		error += best;
+	}
+	return error;
+}
+
+struct Mode6Block
+{
+	int q[2][4];
+	int bits[2];
+	unsigned char indices[16];
+	int error;
+};
+
+static void EncodeMode6(const float (*points)[4], const float* e0, const float* e1, Mode6Block& block)
+{
+	int expanded[2][4];
+	block.bits[0] = QuantizeMode6(e0, block.q[0]);
+	block.bits[1] = QuantizeMode6(e1, block.q[1]);
+	for (int e = 0; e < 2; e++)
+		for (int c = 0; c < 4; c++)
+			expanded[e][c] = block.q[e][c] * 2 + block.bits[e];
+
+	block.error = BC7Indices<4>(points, allMembers, 16, expanded[0], expanded[1], bc7Weights4, 16, block.indices);
+}
+
+static void WriteMode6(Mode6Block& block, unsigned char* dst)
+{
+	// Pixel 0 stores its index without the top bit, so the endpoints are swapped when that bit would be set
+	if (block.indices[0] >= 8)
+	{
+		std::swap(block.q[0], block.q[1]);
+		std::swap(block.bits[0], block.bits[1]);
+		for (unsigned int i = 0; i < 16; i++)
+			block.indices[i] = (unsigned char)(15 - block.indices[i]);
+	}
+
+	BlockWriter writer(dst);
+	writer.Write(1 << 6, 7);
+	for (int c = 0; c < 4; c++)
+	{
+		writer.Write(block.q[0][c], 7);
+		writer.Write(block.q[1][c], 7);
+	}
+	writer.Write(block.bits[0], 1);
+	writer.Write(block.bits[1], 1);
+	for (unsigned int i = 0; i < 16; i++)
+		writer.Write(block.indices[i], i == 0 ? 3 : 4);
+}
+
+struct Mode1Block
+{
+	unsigned int partition;
+	int q[2][2][3];
+	int bits[2];
+	unsigned char indices[16];
+	int error;
+};
+
+static void EncodeMode1(const float (*points)[4], unsigned int partition, Mode1Block& block)
+{
+	block.partition = partition;
+	block.error = 0;
+
+	for (int subset = 0; subset < 2; subset++)
+	{
+		unsigned char members[16];
+		unsigned int count = 0;
+		for (unsigned char i = 0; i < 16; i++)
+			if (((bc7Partitions2[partition] >> i) & 1) == subset)
+				members[count++] = i;
+
+		float e0[3], e1[3];
+		float weights[8];
+		for (int k = 0; k < 8; k++)
+			weights[k] = bc7Weights3[k] / 64.0f;
+		FitLine<3>(points, members, count, e0, e1);
+
+		int bestError = 0x7FFFFFFF;
+		unsigned char subsetIndices[16];
+		for (int iteration = 0; iteration < 2; iteration++)
+		{
+			int q0[3], q1[3];
+			int expanded[2][3];
+			const int bit = QuantizeMode1(e0, e1, q0, q1);
+			for (int c = 0; c < 3; c++)
+			{
+				expanded[0][c] = UnquantizeBC7((q0[c] << 1) | bit, 7);
+				expanded[1][c] = UnquantizeBC7((q1[c] << 1) | bit, 7);
+			}
+
+			const int error = BC7Indices<3>(points, members, count, expanded[0], expanded[1], bc7Weights3, 8, subsetIndices);
+			if (error < bestError)
+			{
+				bestError = error;
+				block.bits[subset] = bit;
+				memcpy(block.q[subset][0], q0, sizeof(q0));
+				memcpy(block.q[subset][1], q1, sizeof(q1));
+				for (unsigned int i = 0; i < count; i++)
+					block.indices[members[i]] = subsetIndices[i];
+			}
+
+			if (!SolveEndpoints<3>(points, members, count, subsetIndices, weights, e0, e1))
+				break;
+		}
+		block.error += bestError;
+	}
+}
+
+static void WriteMode1(Mode1Block& block, unsigned char* dst)
+{
+	// Both subsets store their anchor pixel's index without the top bit
+	const unsigned int anchors[2] = { 0, bc7Anchors2[block.partition] };
+	for (int subset = 0; subset < 2; subset++)
+	{
+		if (block.indices[anchors[subset]] < 4)
+			continue;
+
+		for (int c = 0; c < 3; c++)
+			std::swap(block.q[subset][0][c], block.q[subset][1][c]);
+		for (unsigned int i = 0; i < 16; i++)
+			if (((bc7Partitions2[block.partition] >> i) & 1) == subset)
+				block.indices[i] = (unsigned char)(7 - block.indices[i]);
+	}
+
+	BlockWriter writer(dst);
+	writer.Write(1 << 1, 2);
+	writer.Write(block.partition, 6);
+	for (int c = 0; c < 3; c++)
+		for (int subset = 0; subset < 2; subset++)
+			for (int e = 0; e < 2; e++)
+				writer.Write(block.q[subset][e][c], 6);
+	writer.Write(block.bits[0], 1);
+	writer.Write(block.bits[1], 1);
+	for (unsigned int i = 0; i < 16; i++)
+		writer.Write(block.indices[i], i == anchors[0] || i == anchors[1] ? 2 : 3);
+}
+
+// Squared distance of a subset's pixels from their best fitting line, taken from the covariance left after its largest eigenvalue
+static float LineResidual(const float (*points)[4], uint16_t mask, int subset)
+{
+	float sum[3] = {};
+	float products[3][3] = {};
+	unsigned int count = 0;
+	for (unsigned int i = 0; i < 16; i++)
+	{
+		if (((mask >> i) & 1) != subset)
+			continue;
+		count++;
+		for (int a = 0; a < 3; a++)
+		{
+			sum[a] += points[i][a];
+			for (int b = 0; b < 3; b++)
+				products[a][b] += points[i][a] * points[i][b];
+		}
+	}
+
+	float covariance[3][3];
+	for (int a = 0; a < 3; a++)
+		for (int b = 0; b < 3; b++)
+			covariance[a][b] = products[a][b] - sum[a] * sum[b] / count;
+
+	int widest = 0;
+	for (int c = 1; c < 3; c++)
+		if (covariance[c][c] > covariance[widest][widest])
+			widest = c;
+
+	float axis[3] = { covariance[widest][0], covariance[widest][1], covariance[widest][2] };
+	float eigenvalue = 0.0f;
+	for (int iteration = 0; iteration < 4; iteration++)
+	{
+		float next[3] = {};
+		for (int a = 0; a < 3; a++)
+			for (int b = 0; b < 3; b++)
+				next[a] += covariance[a][b] * axis[b];
+
+		const float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+		const float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+		if (length == 0.0f || axisLength == 0.0f)
+			break;
+		eigenvalue = length / axisLength;
+		for (int c = 0; c < 3; c++)
+			axis[c] = next[c] / length;
+	}
+
+	return covariance[0][0] + covariance[1][1] + covariance[2][2] - eigenvalue;
+}
+
+static void EncodeBC7(const rave::Color* block, rave::BlockQuality quality, unsigned char* dst)
+{
+	float points[16][4];
+	BlockToFloat(block, points);
+
+	float e0[4], e1[4];
+	Mode6Block best;
+	FitLine<4>(points, allMembers, 16, e0, e1);
+	EncodeMode6(points, e0, e1, best);
+
+	if (quality == rave::BlockQuality::Fast)
+	{
+		WriteMode6(best, dst);
+		return;
+	}
+
+	Mode6Block candidate;
+	float weights[16];
+	for (int k = 0; k < 16; k++)
+		weights[k] = bc7Weights4[k] / 64.0f;
+
+	candidate = best;
+	for (int iteration = 0; iteration < 3; iteration++)
+	{
+		if (!SolveEndpoints<4>(points, allMembers, 16, candidate.indices, weights, e0, e1))
+			break;
+		EncodeMode6(points, e0, e1, candidate);
+		if (candidate.error < best.error)
+			best = candidate;
+	}
+
+	// Mode 1 has no alpha, so it only competes on opaque blocks
+	bool opaque = true;
+	for (unsigned int i = 0; i < 16; i++)
+		opaque &= block[i].a == 255;
+
+	if (opaque && best.error > 0)
+	{
+		unsigned int ranked[bc7PartitionTries];
+		float residuals[bc7PartitionTries];
+		unsigned int rankedCount = 0;
+		for (unsigned int partition = 0; partition < 64; partition++)
+		{
+			const float residual = LineResidual(points, bc7Partitions2[partition], 0) + LineResidual(points, bc7Partitions2[partition], 1);
+			unsigned int slot = rankedCount;
+			while (slot > 0 && residuals[slot - 1] > residual)
+				slot--;
+			if (slot >= bc7PartitionTries)
+				continue;
+
+			for (unsigned int i = std::min(rankedCount, bc7PartitionTries - 1); i > slot; i--)
+			{
+				ranked[i] = ranked[i - 1];
+				residuals[i] = residuals[i - 1];
+			}
+			ranked[slot] = partition;
+			residuals[slot] = residual;
+			rankedCount = std::min(rankedCount + 1, bc7PartitionTries);
+		}
+
+		Mode1Block bestSplit;
+		bestSplit.error = 0x7FFFFFFF;
+		for (unsigned int i = 0; i < rankedCount; i++)
+		{
+			Mode1Block split;
+			EncodeMode1(points, ranked[i], split);
+			if (split.error < bestSplit.error)
+				bestSplit = split;
+		}
+
+		if (bestSplit.error < best.error)
+		{
+			WriteMode1(bestSplit, dst);
+			return;
+		}
+	}
+
+	WriteMode6(best, dst);
+}
+
+static void CompressBlock(const rave::Color* block, const rave::BlockOptions& options, unsigned char* dst)
+{
+	switch (options.format)
+	{
+	case rave::BlockFormat::BC1:
+		EncodeBC1(block, options.quality, dst);
+		break;
+	case rave::BlockFormat::BC3:
+		EncodeBC4(block, 3, options.quality, dst);
+		EncodeBC1(block, options.quality, dst + 8);
+		break;
+	case rave::BlockFormat::BC4:
+		EncodeBC4(block, 0, options.quality, dst);
+		break;
+	case rave::BlockFormat::BC5:
+		EncodeBC4(block, 0, options.quality, dst);
+		EncodeBC4(block, 1, options.quality, dst + 8);
+		break;
+	case rave::BlockFormat::BC7:
+		EncodeBC7(block, options.quality, dst);
+		break;
+	}
+}
+
+size_t rave::BlockBytes(BlockFormat format) noexcept
+{
+	return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16;
+}
+
+size_t rave::CompressedByteSize(const Size& size, BlockFormat format) noexcept
+{
+	return (size_t)((size.x + 3) / 4) * ((size.y + 3) / 4) * BlockBytes(format);
+}
+
+void rave::CompressBlocks(const Color* pixels, const Size& size, unsigned char* dst, const BlockOptions& options)
+{
+	if (!pixels || size.x == 0 || size.y == 0)
+		return;
+
+	const unsigned int blocksX = (size.x + 3) / 4;
+	const unsigned int blocksY = (size.y + 3) / 4;
+	const size_t blockBytes = BlockBytes(options.format);
+
+	auto compressRow = [&](size_t blockY)
+	{
+		Color block[16];
+		unsigned char* row = dst + blockY * blocksX * blockBytes;
+		for (unsigned int blockX = 0; blockX < blocksX; blockX++)
+		{
+			LoadBlock(pixels, size, blockX, (unsigned int)blockY, block);
+			CompressBlock(block, options, row + blockX * blockBytes);
+		}
+	};
+
+	// Serial on a worker of the pool it would split over, which then couldn't run the rows while this thread waits
+	ThreadPool* pPool = (size_t)blocksX * blocksY >= parallelBlocks ? ThreadPool::ForCaller(options.pPool) : nullptr;
+	if (pPool && pPool->GetThreadCount() > 1)
+	{
+		pPool->ParallelFor(blocksY, compressRow);
+		return;
+	}
+	for (size_t blockY = 0; blockY < blocksY; blockY++)
+		compressRow(blockY);
+}
+
+rave::CompressedTexture::CompressedTexture(const TextureBuffer<Color>& texture, const BlockOptions& options)
+{
+	if (texture.IsActive())
+		Compress(texture.Data(), texture.GetSize(), options);
+}
+
+rave::CompressedTexture::CompressedTexture(const MipChain& mips, const BlockOptions& options)
+{
+	Compress(mips, options);
+}
+
+void rave::CompressedTexture::Compress(const Color* pixels, const Size& size, const BlockOptions& options)
+{
+	Compress(pixels ? 1 : 0, &pixels, &size, options);
+}
+
+void rave::CompressedTexture::Compress(const MipChain& mips, const BlockOptions& options)
+{
+	std::vector<const Color*> levels(mips.GetLevelCount());
+	std::vector<Size> levelSizes(mips.GetLevelCount());
+	for (unsigned int i = 0; i < mips.GetLevelCount(); i++)
+	{
+		levels[i] = mips.GetLevel(i);
+		levelSizes[i] = mips.GetSize(i);
+	}
+	Compress(mips.GetLevelCount(), levels.data(), levelSizes.data(), options);
+}
+
+void rave::CompressedTexture::Compress(unsigned int levelCount, const Color* const* levels, const Size* levelSizes, const BlockOptions& options)
+{
+	format = options.format;
+	data.clear();
+	sizes.clear();
+	offsets.clear();
+	if (levelCount == 0 || levelSizes[0].x == 0 || levelSizes[0].y == 0)
+		return;
+
+	size_t length = 0;
+	for (unsigned int i = 0; i < levelCount; i++)
+	{
+		sizes.push_back(levelSizes[i]);
+		offsets.push_back(length);
+		length += CompressedByteSize(levelSizes[i], format);
+	}
+	data.resize(length);
+
+	for (unsigned int i = 0; i < levelCount; i++)
+		CompressBlocks(levels[i], levelSizes[i], data.data() + offsets[i], options);
+}
+
+rave::BlockFormat rave::CompressedTexture::GetFormat() const noexcept
+{
+	return format;
+}
+
+unsigned int rave::CompressedTexture::GetLevelCount() const noexcept
+{
+	return (unsigned int)sizes.size();
+}
+
+rave::Size rave::CompressedTexture::GetSize(unsigned int level) const noexcept
+{
+	return level < sizes.size() ? sizes[level] : Size(0, 0);
+}
+
+size_t rave::CompressedTexture::GetOffset(unsigned int level) const noexcept
+{
+	return level < offsets.size() ? offsets[level] : data.size();
+}
+
+const unsigned char* rave::CompressedTexture::GetLevel(unsigned int level) const noexcept
+{
+	return level < offsets.size() ? data.data() + offsets[level] : nullptr;
+}
+
+const unsigned char* rave::CompressedTexture::Data() const noexcept
+{
+	return data.data();
+}
+
+size_t rave::CompressedTexture::GetByteSize() const noexcept
+{
+	return data.size();
+}
\ No newline at end of file
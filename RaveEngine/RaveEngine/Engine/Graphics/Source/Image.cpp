@@ -1,4 +1,7 @@
 #include "Engine/Graphics/Include/Image.h"
+#include "Engine/Utilities/Include/FileMapping.h"
+#include "Engine/Utilities/Include/String.h"
+#include <filesystem>
 
 rave::Image::Image(const char* filename, const bool throws)
 {
@@ -16,22 +19,137 @@ rave::Image::Image(const int width, const int height, const Color& background)
 	Load(width, height, background);
 }
 
-rave::Result rave::Image::Load(const char* filename)
+rave::Result rave::Image::Load(const char* filename, const DecodeOptions& options, const TextureCacheSettings& cacheSettings)
 {
-	auto imgSize = ImageSize(filename);
-	if (imgSize.GetResult().Failed())
-		return imgSize.GetResult();
+	FileMapping file;
+	TextureSource source;
+	bool cached = false;
+	auto result = MapSource(filename, options, cacheSettings, file, source, cached);
+	if (result.Failed() || cached)
+		return result;
+
+	return DecodeSource(filename, options, cacheSettings, file, source);
+}
+
+rave::ImageLoadHandle rave::Image::LoadAsync(const char* filename, LoadPriority priority, const DecodeOptions& options, const TextureCacheSettings& cacheSettings)
+{
+	return ImageLoadQueue::GetDefault().Load(filename, priority, options, cacheSettings);
+}
+
+rave::Result rave::Image::MapSource(const char* filename, const DecodeOptions& options, const TextureCacheSettings& cacheSettings, FileMapping& file, TextureSource& source, bool& cached)
+{
+	cached = false;
+	cache.Close();
+	if (!cacheSettings.enabled)
+		return file.Open(filename);
+
+	auto stat = StatTextureSource(filename);
+	if (stat.GetResult().Failed())
+		return stat.GetResult();
+	source = stat.Get();
 
-	buffer.Load(imgSize.Get().x, imgSize.Get().y);
-	return ReadImageRaw(filename, buffer.Data());
+	auto result = file.Open(filename);
+	if (result.Failed())
+		return result;
+
+	const std::string cachePath = TextureCachePath(filename, cacheSettings.directory);
+	if (cache.Open(cachePath.c_str()).Succeeded() && cache.Matches(source, options, file.Data(), file.Size()))
+	{
+		buffer.Clear();
+		cached = true;
+		return RE_SUCCESS;
+	}
+	cache.Close();
+	return RE_SUCCESS;
+}
+
+rave::Result rave::Image::DecodeSource(const char* filename, const DecodeOptions& options, const TextureCacheSettings& cacheSettings, const FileMapping& file, TextureSource& source)
+{
+	auto result = LoadTexture(file.Data(), file.Size(), buffer, options);
+	if (result.Failed() || !cacheSettings.enabled)
+		return result;
+
+	// A failure to create it shows up as the failed write below
+	std::error_code error;
+	if (!cacheSettings.directory.empty())
+		std::filesystem::create_directories(cacheSettings.directory, error);
+
+	// A cache that can't be written, say in a read-only folder, only costs the next load a decode, so the image still loads
+	source.hash = HashTextureSource(file.Data(), file.Size());
+	result = WriteTextureCache(TextureCachePath(filename, cacheSettings.directory).c_str(), buffer.Data(), buffer.GetSize(), source, options);
+	if (result.Failed())
+		return Result((L"Image loaded, but its cache entry wasn't written: " + std::wstring(result.GetErrorMessage() ? result.GetErrorMessage() : L"")).c_str(), RE_WARNING, result.GetCode());
+	return RE_SUCCESS;
 }
 
 void rave::Image::Load(const int width, const int height)
 {
+	cache.Close();
 	buffer.Load(width, height);
 }
 
 void rave::Image::Load(const int width, const int height, const Color& background)
 {
+	cache.Close();
 	buffer.Load(width, height, background);
+}
+
+rave::Size rave::Image::GetSize() const noexcept
+{
+	return cache.IsOpen() ? cache.GetSize() : buffer.GetSize();
+}
+
+const rave::Color* rave::Image::Data() const noexcept
+{
+	return cache.IsOpen() ? cache.GetLevel() : buffer.Data();
+}
+
+rave::Result rave::LoadTexture(const char* filename, TextureBuffer<Color>& texture, const DecodeOptions& options)
+{
+	// Map the file once and use the same bytes for both the header and the pixels
+	FileMapping file;
+	auto result = file.Open(filename);
+	if (result.Failed())
+		return result;
+
+	return LoadTexture(file.Data(), file.Size(), texture, options);
+}
+
+rave::Result rave::LoadTexture(const void* bytes, size_t length, TextureBuffer<Color>& texture, const DecodeOptions& options)
+{
+	const ImageFormat format = DetectImageFormat(bytes, length);
+	auto imgSize = ImageSize(bytes, length, format, options);
+	if (imgSize.GetResult().Failed())
+		return imgSize.GetResult();
+
+	if (!texture.IsActive() || texture.GetSize() != imgSize.Get())
+		texture.Load(imgSize.Get().x, imgSize.Get().y);
+	return ReadImageRaw(bytes, length, format, texture.Data(), options);
+}
+
+std::vector<rave::Result> rave::LoadImages(array_view<const char* const> filenames, array_view<TextureBuffer<Color>> textures, ThreadPool& pool, const DecodeOptions& options)
+{
+	rave_assert_info(filenames.size() == textures.size(), L"Every file needs a texture to be loaded into");
+
+	std::vector<Result> results(filenames.size());
+	pool.ParallelFor(filenames.size(), [&](size_t i)
+	{
+		// Exceptions must not escape into the worker thread, they are reported like any other failure
+		try
+		{
+			results[i] = LoadTexture(filenames[i], textures[i], options);
+		}
+		catch (const std::exception& e)
+		{
+			results[i] = Result(Widen(e.what()).c_str(), RE_FAIL, RE_IMAGE_LOAD_FAIL);
+		}
+	});
+
+	return results;
+}
+
+std::vector<rave::Result> rave::LoadImages(array_view<const char* const> filenames, array_view<TextureBuffer<Color>> textures, size_t threadCount, const DecodeOptions& options)
+{
+	ThreadPool pool(std::min(threadCount ? threadCount : std::thread::hardware_concurrency(), std::max<size_t>(filenames.size(), 1)));
+	return LoadImages(filenames, textures, pool, options);
 }
\ No newline at end of file
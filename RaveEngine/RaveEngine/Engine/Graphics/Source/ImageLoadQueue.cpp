@@ -0,0 +1,309 @@
+#include "Engine/Graphics/Include/ImageLoadQueue.h"
+#include "Engine/Graphics/Include/Image.h"
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+
+enum LoadStage
+{
+	ReadStage,
+	DecodeStage,
+	StageCount
+};
+
+// Queue keys sort by priority first and arrival second
+using LoadKey = std::pair<int, uint64_t>;
+
+struct rave::ImageLoadCore
+{
+	std::mutex mutex;
+	std::condition_variable work[StageCount];
+	std::map<LoadKey, std::shared_ptr<ImageLoadState>> queues[StageCount];
+	uint64_t arrivals = 0;
+	bool stopping = false;
+};
+
+struct rave::ImageLoadState
+{
+	std::shared_ptr<ImageLoadCore> core;
+	std::string filename;
+	DecodeOptions options;
+	TextureCacheSettings cacheSettings;
+	std::atomic<bool> cancelled = false;
+
+	// Guarded by the core's mutex
+	LoadPriority priority = LoadPriority::Visible;
+	int queuedStage = -1;
+	LoadKey key;
+
+	// Handed from the read stage to the decode stage
+	FileMapping file;
+	TextureSource source;
+	Image image;
+
+	// Guarded by the state's own mutex
+	std::mutex mutex;
+	std::condition_variable done;
+	bool ready = false;
+	Result result;
+	std::vector<std::function<void(Image&, const Result&)>> continuations;
+};
+
+static rave::Result CancelledResult()
+{
+	return rave::Result(L"Image load was cancelled", rave::RE_FAIL, rave::RE_IMAGE_LOAD_FAIL);
+}
+
+static void RunContinuation(const std::function<void(rave::Image&, const rave::Result&)>& continuation, rave::Image& image, const rave::Result& result)
+{
+	// Exceptions must not escape into the worker thread, and there is nobody left to report them to
+	try
+	{
+		continuation(image, result);
+	}
+	catch (const std::exception&)
+	{
+	}
+}
+
+static void Finish(const std::shared_ptr<rave::ImageLoadState>& state, const rave::Result& result)
+{
+	state->file.Close();
+
+	std::vector<std::function<void(rave::Image&, const rave::Result&)>> continuations;
+	{
+		std::lock_guard<std::mutex> lock(state->mutex);
+		state->result = result;
+		state->ready = true;
+		continuations.swap(state->continuations);
+	}
+	state->done.notify_all();
+
+	for (const auto& continuation : continuations)
+		RunContinuation(continuation, state->image, result);
+}
+
+// Expects the core's mutex to be held
+static bool Enqueue(const std::shared_ptr<rave::ImageLoadState>& state, int stage)
+{
+	rave::ImageLoadCore& core = *state->core;
+	if (core.stopping)
+		return false;
+
+	state->queuedStage = stage;
+	state->key = LoadKey((int)state->priority, core.arrivals++);
+	core.queues[stage].emplace(state->key, state);
+	core.work[stage].notify_one();
+	return true;
+}
+
+void rave::ImageLoadQueue::RunRead(const std::shared_ptr<ImageLoadState>& state)
+{
+	if (state->cancelled)
+		return Finish(state, CancelledResult());
+
+	bool cached = false;
+	Result result;
+	try
+	{
+		result = state->image.MapSource(state->filename.c_str(), state->options, state->cacheSettings, state->file, state->source, cached);
+	}
+	catch (const std::exception& e)
+	{
+		result = Result(Widen(e.what()).c_str(), RE_FAIL, RE_IMAGE_LOAD_FAIL);
+	}
+	if (result.Failed() || cached)
+		return Finish(state, result);
+
+	bool queued;
+	{
+		std::lock_guard<std::mutex> lock(state->core->mutex);
+		queued = !state->cancelled && Enqueue(state, DecodeStage);
+	}
+	if (!queued)
+		Finish(state, CancelledResult());
+}
+
+void rave::ImageLoadQueue::RunDecode(const std::shared_ptr<ImageLoadState>& state)
+{
+	if (state->cancelled)
+		return Finish(state, CancelledResult());
+
+	Result result;
+	try
+	{
+		result = state->image.DecodeSource(state->filename.c_str(), state->options, state->cacheSettings, state->file, state->source);
+	}
+	catch (const std::exception& e)
+	{
+		result = Result(Widen(e.what()).c_str(), RE_FAIL, RE_IMAGE_LOAD_FAIL);
+	}
+
+	Finish(state, state->cancelled ? CancelledResult() : result);
+}
+
+rave::ImageLoadHandle::ImageLoadHandle(std::shared_ptr<ImageLoadState> state)
+	:
+	state(std::move(state))
+{
+}
+
+bool rave::ImageLoadHandle::IsValid() const noexcept
+{
+	return state != nullptr;
+}
+
+bool rave::ImageLoadHandle::IsReady() const
+{
+	std::lock_guard<std::mutex> lock(state->mutex);
+	return state->ready;
+}
+
+rave::Result rave::ImageLoadHandle::Wait() const
+{
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->done.wait(lock, [this]() { return state->ready; });
+	return state->result;
+}
+
+rave::Image& rave::ImageLoadHandle::GetImage() const
+{
+	rave_assert_info(IsReady(), L"The image is still loading");
+	return state->image;
+}
+
+void rave::ImageLoadHandle::Cancel() const
+{
+	state->cancelled = true;
+
+	bool dequeued = false;
+	{
+		std::lock_guard<std::mutex> lock(state->core->mutex);
+		if (state->queuedStage >= 0)
+		{
+			state->core->queues[state->queuedStage].erase(state->key);
+			state->queuedStage = -1;
+			dequeued = true;
+		}
+	}
+	if (dequeued)
+		Finish(state, CancelledResult());
+}
+
+void rave::ImageLoadHandle::SetPriority(LoadPriority priority) const
+{
+	std::lock_guard<std::mutex> lock(state->core->mutex);
+	state->priority = priority;
+	if (state->queuedStage >= 0 && state->key.first != (int)priority)
+	{
+		auto& queue = state->core->queues[state->queuedStage];
+		queue.erase(state->key);
+		state->key = LoadKey((int)priority, state->core->arrivals++);
+		queue.emplace(state->key, state);
+	}
+}
+
+void rave::ImageLoadHandle::Then(std::function<void(Image&, const Result&)> continuation) const
+{
+	{
+		std::lock_guard<std::mutex> lock(state->mutex);
+		if (!state->ready)
+		{
+			state->continuations.push_back(std::move(continuation));
+			return;
+		}
+	}
+	RunContinuation(continuation, state->image, state->result);
+}
+
+rave::ImageLoadQueue::ImageLoadQueue(size_t ioThreadCount, size_t decodeThreadCount)
+	:
+	core(std::make_shared<ImageLoadCore>())
+{
+	if (decodeThreadCount == 0)
+		decodeThreadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+	ioThreadCount = std::max<size_t>(ioThreadCount, 1);
+	threads.reserve(ioThreadCount + decodeThreadCount);
+	for (size_t i = 0; i < ioThreadCount; i++)
+		threads.emplace_back(&ImageLoadQueue::WorkerLoop, this, (int)ReadStage);
+	for (size_t i = 0; i < decodeThreadCount; i++)
+		threads.emplace_back(&ImageLoadQueue::WorkerLoop, this, (int)DecodeStage);
+}
+
+rave::ImageLoadQueue::~ImageLoadQueue()
+{
+	std::vector<std::shared_ptr<ImageLoadState>> dropped;
+	{
+		std::lock_guard<std::mutex> lock(core->mutex);
+		core->stopping = true;
+		for (auto& queue : core->queues)
+		{
+			for (auto& entry : queue)
+			{
+				entry.second->queuedStage = -1;
+				dropped.push_back(entry.second);
+			}
+			queue.clear();
+		}
+	}
+	for (auto& work : core->work)
+		work.notify_all();
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	for (const auto& state : dropped)
+		Finish(state, CancelledResult());
+}
+
+rave::ImageLoadHandle rave::ImageLoadQueue::Load(const char* filename, LoadPriority priority, const DecodeOptions& options, const TextureCacheSettings& cacheSettings)
+{
+	auto state = std::make_shared<ImageLoadState>();
+	state->core = core;
+	state->filename = filename;
+	state->options = options;
+	state->cacheSettings = cacheSettings;
+	state->priority = priority;
+
+	bool queued;
+	{
+		std::lock_guard<std::mutex> lock(core->mutex);
+		queued = Enqueue(state, ReadStage);
+	}
+	if (!queued)
+		Finish(state, CancelledResult());
+
+	return ImageLoadHandle(std::move(state));
+}
+
+rave::ImageLoadQueue& rave::ImageLoadQueue::GetDefault()
+{
+	static ImageLoadQueue queue;
+	return queue;
+}
+
+void rave::ImageLoadQueue::WorkerLoop(int stage)
+{
+	while (true)
+	{
+		std::shared_ptr<ImageLoadState> state;
+		{
+			std::unique_lock<std::mutex> lock(core->mutex);
+			core->work[stage].wait(lock, [&]() { return core->stopping || !core->queues[stage].empty(); });
+			if (core->stopping)
+				return;
+
+			auto next = core->queues[stage].begin();
+			state = std::move(next->second);
+			core->queues[stage].erase(next);
+			state->queuedStage = -1;
+		}
+
+		if (stage == ReadStage)
+			RunRead(state);
+		else
+			RunDecode(state);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,427 @@
+#include "Engine/Graphics/Include/ImageWriter.h"
+#include "Libraries/zlib/zlib.h"
+#include <memory>
+#include <stdio.h>
+#include <setjmp.h>
+#include "Libraries/libjpg/jpeglib.h"
+
+#define RETURN_ERROR(message) return rave::Result(message, rave::RE_FAIL, rave::RE_IMAGE_LOAD_FAIL)
+
+static_assert(sizeof(rave::Color) == 4, "Colors are written as RGBA8 rows");
+
+static constexpr size_t pngBytesPerPixel = 4;
+static constexpr size_t deflateWindow = 32768;
+// Far below the 2^31 - 1 a PNG chunk may hold
+static constexpr size_t maxIDATLength = 1 << 30;
+
+static unsigned char PaethPredictor(int a, int b, int c)
+{
+	const int p = a + b - c;
+	const int pa = abs(p - a);
+	const int pb = abs(p - b);
+	const int pc = abs(p - c);
+	if (pa <= pb && pa <= pc)
+		return (unsigned char)a;
+	return (unsigned char)(pb <= pc ? b : c);
+}
+
+// The row above the first one is all zeroes, as the PNG spec has it
+static void ApplyFilter(rave::PngFilter filter, const unsigned char* row, const unsigned char* prev, size_t length, unsigned char* out)
+{
+	switch (filter)
+	{
+		case rave::PngFilter::Sub:
+			for (size_t i = 0; i < pngBytesPerPixel; i++)
+				out[i] = row[i];
+			for (size_t i = pngBytesPerPixel; i < length; i++)
+				out[i] = row[i] - row[i - pngBytesPerPixel];
+			break;
+
+		case rave::PngFilter::Up:
+			for (size_t i = 0; i < length; i++)
+				out[i] = row[i] - prev[i];
+			break;
+
+		case rave::PngFilter::Average:
+			for (size_t i = 0; i < pngBytesPerPixel; i++)
+				out[i] = row[i] - (prev[i] >> 1);
+			for (size_t i = pngBytesPerPixel; i < length; i++)
+				out[i] = row[i] - (unsigned char)((row[i - pngBytesPerPixel] + prev[i]) >> 1);
+			break;
+
+		case rave::PngFilter::Paeth:
+			for (size_t i = 0; i < pngBytesPerPixel; i++)
+				out[i] = row[i] - prev[i];
+			for (size_t i = pngBytesPerPixel; i < length; i++)
+				out[i] = row[i] - PaethPredictor(row[i - pngBytesPerPixel], prev[i], prev[i - pngBytesPerPixel]);
+			break;
+
+		default:
+			memcpy(out, row, length);
+			break;
+	}
+}
+
+// Residuals near zero either way deflate best, so the bytes are scored as signed values
+static size_t FilterScore(const unsigned char* data, size_t length)
+{
+	size_t score = 0;
+	for (size_t i = 0; i < length; i++)
+		score += (size_t)abs((int)(signed char)data[i]);
+	return score;
+}
+
+// Writes the filter type byte followed by the filtered row
+static void FilterRow(rave::PngFilter filter, const unsigned char* row, const unsigned char* prev, size_t length, unsigned char* out, std::vector<unsigned char>& scratch)
+{
+	if (filter != rave::PngFilter::Adaptive)
+	{
+		out[0] = (unsigned char)filter;
+		ApplyFilter(filter, row, prev, length, out + 1);
+		return;
+	}
+
+	scratch.resize(length);
+	size_t bestScore = SIZE_MAX;
+	for (int candidate = (int)rave::PngFilter::None; candidate <= (int)rave::PngFilter::Paeth; candidate++)
+	{
+		ApplyFilter(rave::PngFilter(candidate), row, prev, length, scratch.data());
+		const size_t score = FilterScore(scratch.data(), length);
+		if (score < bestScore)
+		{
+			bestScore = score;
+			out[0] = (unsigned char)candidate;
+			memcpy(out + 1, scratch.data(), length);
+		}
+	}
+}
+
+// Deflates one chunk as raw deflate blocks. Every chunk but the last ends on a sync flush, so the chunks line up byte by byte
+static int DeflateChunk(const unsigned char* data, size_t length, const unsigned char* dictionary, size_t dictionaryLength, bool last, int level, int strategy, std::vector<unsigned char>& out)
+{
+	z_stream stream = {};
+	int status = deflateInit2(&stream, level, Z_DEFLATED, -15, 8, strategy);
+	if (status != Z_OK)
+		return status;
+
+	if (dictionaryLength)
+		status = deflateSetDictionary(&stream, dictionary, (uInt)dictionaryLength);
+
+	// The bound doesn't count the flush marker
+	out.resize(deflateBound(&stream, (uLong)length) + 16);
+	stream.next_in = const_cast<unsigned char*>(data);
+	stream.avail_in = (uInt)length;
+	stream.next_out = out.data();
+	stream.avail_out = (uInt)out.size();
+
+	while (status == Z_OK)
+	{
+		status = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+		if (status == Z_STREAM_END || (status == Z_OK && !last && stream.avail_out != 0))
+		{
+			status = Z_OK;
+			break;
+		}
+		if (status != Z_OK)
+			break;
+
+		// Out of room, carry on in a larger buffer
+		const size_t written = stream.total_out;
+		out.resize(out.size() * 2);
+		stream.next_out = out.data() + written;
+		stream.avail_out = (uInt)(out.size() - written);
+	}
+
+	out.resize(stream.total_out);
+	deflateEnd(&stream);
+	return status;
+}
+
+static void AppendBigEndian32(std::vector<unsigned char>& png, uint32_t value)
+{
+	png.push_back((unsigned char)(value >> 24));
+	png.push_back((unsigned char)(value >> 16));
+	png.push_back((unsigned char)(value >> 8));
+	png.push_back((unsigned char)value);
+}
+
+static void AppendChunk(std::vector<unsigned char>& png, const char* type, const unsigned char* data, size_t length)
+{
+	AppendBigEndian32(png, (uint32_t)length);
+	png.insert(png.end(), type, type + 4);
+	png.insert(png.end(), data, data + length);
+
+	uLong crc = crc32(0, reinterpret_cast<const Bytef*>(type), 4);
+	if (length)
+		crc = crc32(crc, data, (uInt)length);
+	AppendBigEndian32(png, (uint32_t)crc);
+}
+
+rave::Result rave::EncodePNG(const Color* pixels, const Size& size, std::vector<unsigned char>& png, int level, const PngWriteOptions& options)
+{
+	if (!pixels || size.x == 0 || size.y == 0)
+		RETURN_ERROR(L"Cannot encode an empty image");
+	if (level < 0 || level > 9)
+		RETURN_ERROR(L"PNG compression level must lie between 0 and 9");
+
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(pixels);
+	const size_t rowLength = (size_t)size.x * pngBytesPerPixel;
+	const size_t filteredRowLength = rowLength + 1;
+	const size_t rowsPerChunk = std::clamp<size_t>(std::min(options.chunkSize, maxIDATLength) / filteredRowLength, 1, size.y);
+	const size_t chunkCount = (size.y + rowsPerChunk - 1) / rowsPerChunk;
+	const size_t filteredLength = filteredRowLength * size.y;
+
+	// Small images only go to a pool they're given. Serial on a worker of the pool it would split over,
+	// which then couldn't run the chunks while this thread waits
+	const bool large = chunkCount >= 4 && filteredLength >= (1 << 20);
+	ThreadPool* pPool = options.pPool || large ? ThreadPool::ForCaller(options.pPool) : nullptr;
+	auto forEachChunk = [&](const std::function<void(size_t)>& job)
+	{
+		if (pPool && pPool->GetThreadCount() > 1 && chunkCount > 1)
+			pPool->ParallelFor(chunkCount, job);
+		else
+			for (size_t i = 0; i < chunkCount; i++)
+				job(i);
+	};
+
+	// Filtering first lets every chunk prime its deflate with the filtered bytes before it
+	std::vector<unsigned char> filtered(filteredLength);
+	const std::vector<unsigned char> zeroRow(rowLength, 0);
+	forEachChunk([&](size_t chunk)
+	{
+		std::vector<unsigned char> scratch;
+		const size_t end = std::min<size_t>((chunk + 1) * rowsPerChunk, size.y);
+		for (size_t y = chunk * rowsPerChunk; y < end; y++)
+		{
+			const unsigned char* prev = y ? bytes + (y - 1) * rowLength : zeroRow.data();
+			FilterRow(options.filter, bytes + y * rowLength, prev, rowLength, filtered.data() + y * filteredRowLength, scratch);
+		}
+	});
+
+	std::vector<std::vector<unsigned char>> compressed(chunkCount);
+	std::vector<uLong> checksums(chunkCount);
+	std::vector<int> statuses(chunkCount, Z_OK);
+	const int strategy = options.filter == PngFilter::None ? Z_DEFAULT_STRATEGY : Z_FILTERED;
+	forEachChunk([&](size_t chunk)
+	{
+		const size_t begin = chunk * rowsPerChunk * filteredRowLength;
+		const size_t end = std::min(begin + rowsPerChunk * filteredRowLength, filteredLength);
+		const size_t dictionaryLength = std::min(begin, deflateWindow);
+
+		statuses[chunk] = DeflateChunk(filtered.data() + begin, end - begin, filtered.data() + begin - dictionaryLength, dictionaryLength, chunk + 1 == chunkCount, level, strategy, compressed[chunk]);
+		checksums[chunk] = adler32(adler32(0, Z_NULL, 0), filtered.data() + begin, (uInt)(end - begin));
+	});
+
+	for (int status : statuses)
+		if (status != Z_OK)
+			RETURN_ERROR(L"Unable to deflate png data");
+
+	uLong checksum = checksums[0];
+	for (size_t chunk = 1; chunk < chunkCount; chunk++)
+	{
+		const size_t begin = chunk * rowsPerChunk * filteredRowLength;
+		const size_t end = std::min(begin + rowsPerChunk * filteredRowLength, filteredLength);
+		checksum = adler32_combine(checksum, checksums[chunk], (z_off_t)(end - begin));
+	}
+
+	// The chunks join into one zlib stream: a header before the first and the checksum of the whole after the last
+	const unsigned int levelFlag = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+	unsigned int zlibHeader = (0x78 << 8) | (levelFlag << 6);
+	zlibHeader += 31 - zlibHeader % 31;
+	compressed.front().insert(compressed.front().begin(), { (unsigned char)(zlibHeader >> 8), (unsigned char)zlibHeader });
+	for (int shift = 24; shift >= 0; shift -= 8)
+		compressed.back().push_back((unsigned char)(checksum >> shift));
+
+	size_t compressedLength = 0;
+	for (const auto& chunk : compressed)
+		compressedLength += chunk.size();
+
+	png.clear();
+	png.reserve(compressedLength + 12 * chunkCount + 64);
+	const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	png.insert(png.end(), signature, signature + sizeof(signature));
+
+	std::vector<unsigned char> header;
+	AppendBigEndian32(header, size.x);
+	AppendBigEndian32(header, size.y);
+	// 8 bit RGBA, deflate, adaptive filtering, no interlacing
+	header.insert(header.end(), { 8, 6, 0, 0, 0 });
+	AppendChunk(png, "IHDR", header.data(), header.size());
+
+	for (const auto& chunk : compressed)
+		for (size_t offset = 0; offset < chunk.size(); offset += maxIDATLength)
+			AppendChunk(png, "IDAT", chunk.data() + offset, std::min(chunk.size() - offset, maxIDATLength));
+
+	AppendChunk(png, "IEND", nullptr, 0);
+	return RE_SUCCESS;
+}
+
+static rave::Result WriteBytes(const std::vector<unsigned char>& bytes, const char* filename)
+{
+	FILE* file = fopen(filename, "wb");
+	if (!file)
+		return rave::Result((L"Unable to create file \"" + rave::Widen(std::string(filename)) + L"\"").c_str(), rave::RE_FAIL, rave::RE_FILE_NOT_FOUND);
+
+	bool written = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+	written = fclose(file) == 0 && written;
+	if (!written)
+		return rave::Result((L"Unable to write file \"" + rave::Widen(std::string(filename)) + L"\"").c_str(), rave::RE_FAIL, rave::RE_FILE_NOT_FOUND);
+	return rave::RE_SUCCESS;
+}
+
+rave::Result rave::WritePNG(const Color* pixels, const Size& size, const char* filename, int level, const PngWriteOptions& options)
+{
+	std::vector<unsigned char> png;
+	auto result = EncodePNG(pixels, size, png, level, options);
+	if (result.Failed())
+		return result;
+
+	return WriteBytes(png, filename);
+}
+
+rave::Result rave::WritePNG(const TextureBuffer<Color>& texture, const char* filename, int level, const PngWriteOptions& options)
+{
+	return WritePNG(texture.Data(), texture.GetSize(), filename, level, options);
+}
+
+std::future<rave::Result> rave::WritePNGAsync(TextureBuffer<Color> texture, std::string filename, int level, const PngWriteOptions& options)
+{
+	return std::async(std::launch::async, [texture = std::move(texture), filename = std::move(filename), level, options]()
+	{
+		return WritePNG(texture, filename.c_str(), level, options);
+	});
+}
+
+struct JpegWriteError
+{
+	jpeg_error_mgr manager;
+	jmp_buf jumpBuffer;
+};
+
+static void JpegWriteErrorExit(j_common_ptr cinfo)
+{
+	longjmp(reinterpret_cast<JpegWriteError*>(cinfo->err)->jumpBuffer, 1);
+}
+
+// Warnings can't happen while compressing from memory, the only thing they could say is dropped
+static void JpegWriteOutputMessage(j_common_ptr cinfo)
+{
+}
+
+// libjpeg destination appending to a vector, a buffer at a time
+struct JpegVectorDestination
+{
+	jpeg_destination_mgr manager;
+	std::vector<unsigned char>* pOutput;
+	JOCTET buffer[16 * 1024];
+};
+
+static void JpegInitDestination(j_compress_ptr cinfo)
+{
+	JpegVectorDestination* pDestination = reinterpret_cast<JpegVectorDestination*>(cinfo->dest);
+	pDestination->manager.next_output_byte = pDestination->buffer;
+	pDestination->manager.free_in_buffer = sizeof(pDestination->buffer);
+}
+
+static boolean JpegEmptyOutputBuffer(j_compress_ptr cinfo)
+{
+	JpegVectorDestination* pDestination = reinterpret_cast<JpegVectorDestination*>(cinfo->dest);
+	pDestination->pOutput->insert(pDestination->pOutput->end(), pDestination->buffer, pDestination->buffer + sizeof(pDestination->buffer));
+	JpegInitDestination(cinfo);
+	return TRUE;
+}
+
+static void JpegTermDestination(j_compress_ptr cinfo)
+{
+	JpegVectorDestination* pDestination = reinterpret_cast<JpegVectorDestination*>(cinfo->dest);
+	const size_t used = sizeof(pDestination->buffer) - pDestination->manager.free_in_buffer;
+	pDestination->pOutput->insert(pDestination->pOutput->end(), pDestination->buffer, pDestination->buffer + used);
+}
+
+rave::Result rave::EncodeJPEG(const Color* pixels, const Size& size, std::vector<unsigned char>& jpeg, const JpegWriteOptions& options)
+{
+	if (!pixels || size.x == 0 || size.y == 0)
+		RETURN_ERROR(L"Cannot encode an empty image");
+	if (size.x > JPEG_MAX_DIMENSION || size.y > JPEG_MAX_DIMENSION)
+		RETURN_ERROR(L"Image is too large for a JPEG");
+	if (options.quality < 1 || options.quality > 100)
+		RETURN_ERROR(L"JPEG quality must lie between 1 and 100");
+
+	jpeg.clear();
+	std::vector<JSAMPLE> row((size_t)size.x * 3);
+	auto destination = std::make_unique<JpegVectorDestination>();
+	destination->manager.init_destination = JpegInitDestination;
+	destination->manager.empty_output_buffer = JpegEmptyOutputBuffer;
+	destination->manager.term_destination = JpegTermDestination;
+	destination->pOutput = &jpeg;
+
+	jpeg_compress_struct cinfo;
+	JpegWriteError error;
+	cinfo.err = jpeg_std_error(&error.manager);
+	error.manager.error_exit = JpegWriteErrorExit;
+	error.manager.output_message = JpegWriteOutputMessage;
+	if (setjmp(error.jumpBuffer))
+	{
+		jpeg_destroy_compress(&cinfo);
+		RETURN_ERROR(L"Unable to encode jpeg data");
+	}
+
+	jpeg_create_compress(&cinfo);
+	cinfo.dest = &destination->manager;
+
+	cinfo.image_width = size.x;
+	cinfo.image_height = size.y;
+	cinfo.input_components = 3;
+	cinfo.in_color_space = JCS_RGB;
+	jpeg_set_defaults(&cinfo);
+	jpeg_set_quality(&cinfo, options.quality, TRUE);
+
+	// The defaults are 4:2:0
+	if (!options.subsampleChroma)
+	{
+		for (int i = 0; i < cinfo.num_components; i++)
+		{
+			cinfo.comp_info[i].h_samp_factor = 1;
+			cinfo.comp_info[i].v_samp_factor = 1;
+		}
+	}
+	cinfo.restart_in_rows = (int)std::min(options.restartRows, 65535u);
+
+	jpeg_start_compress(&cinfo, TRUE);
+	while (cinfo.next_scanline < cinfo.image_height)
+	{
+		const Color* src = pixels + (size_t)cinfo.next_scanline * size.x;
+		for (unsigned int x = 0; x < size.x; x++)
+		{
+			row[x * 3 + 0] = src[x].r;
+			row[x * 3 + 1] = src[x].g;
+			row[x * 3 + 2] = src[x].b;
+		}
+		JSAMPROW rowPointer = row.data();
+		jpeg_write_scanlines(&cinfo, &rowPointer, 1);
+	}
+	jpeg_finish_compress(&cinfo);
+	jpeg_destroy_compress(&cinfo);
+
+	return RE_SUCCESS;
+}
+
+rave::Result rave::WriteJPEG(const Color* pixels, const Size& size, const char* filename, const JpegWriteOptions& options)
+{
+	std::vector<unsigned char> jpeg;
+	auto result = EncodeJPEG(pixels, size, jpeg, options);
+	if (result.Failed())
+		return result;
+
+	return WriteBytes(jpeg, filename);
+}
+
+rave::Result rave::WriteJPEG(const TextureBuffer<Color>& texture, const char* filename, const JpegWriteOptions& options)
+{
+	return WriteJPEG(texture.Data(), texture.GetSize(), filename, options);
+}
+
+rave::Result rave::WriteQOI(const TextureBuffer<Color>& texture, const char* filename)
+{
+	return WriteQOI(texture.Data(), texture.GetSize(), filename);
+}
\ No newline at end of file
@@ -0,0 +1,394 @@
+#include "Engine/Graphics/Include/MipChain.h"
+#include "Engine/Utilities/Include/CpuFeatures.h"
+#include <stdint.h>
+#include <cmath>
+
+#if defined(RE_ARCH_X86)
+#include <immintrin.h>
+#elif defined(RE_ARCH_NEON)
+#include <arm_neon.h>
+#endif
+
+// Levels are filtered in float, one FColor per pixel, and every level is made from the float copy of the one above,
+// so rounding to 8 bits never compounds down the chain. Only the base level is read as Colors.
+
+static constexpr size_t fromLinearSize = 1 << 14;
+// Levels with fewer pixels than this aren't worth splitting over threads
+static constexpr size_t parallelPixels = 256 * 256;
+static constexpr size_t pixelsPerTask = 16 * 1024;
+static constexpr float sincRadius = 3.0f;
+static constexpr float kaiserAlpha = 4.0f;
+
+struct ColorTables
+{
+	float toLinear[256];
+	unsigned char fromLinear[fromLinearSize];
+};
+
+static float SRGBToLinear(float v)
+{
+	return v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+}
+
+static float LinearToSRGB(float v)
+{
+	return v <= 0.0031308f ? v * 12.92f : 1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f;
+}
+
+static ColorTables MakeTables(bool srgb)
+{
+	ColorTables tables;
+	for (size_t i = 0; i < 256; i++)
+		tables.toLinear[i] = srgb ? SRGBToLinear(i / 255.0f) : i / 255.0f;
+	for (size_t i = 0; i < fromLinearSize; i++)
+	{
+		const float v = i / float(fromLinearSize - 1);
+		tables.fromLinear[i] = (unsigned char)((srgb ? LinearToSRGB(v) : v) * 255.0f + 0.5f);
+	}
+	return tables;
+}
+
+static const ColorTables& GetTables(bool srgb)
+{
+	static const ColorTables srgbTables = MakeTables(true);
+	static const ColorTables linearTables = MakeTables(false);
+	return srgb ? srgbTables : linearTables;
+}
+
+// One pixel in a register, alpha included
+#if defined(RE_ARCH_X86)
+typedef __m128 Lanes;
+
+static Lanes LoadLanes(const rave::FColor& color) { return _mm_loadu_ps(&color.r); }
+static void StoreLanes(rave::FColor& color, Lanes v) { _mm_storeu_ps(&color.r, v); }
+static Lanes AddLanes(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+static Lanes ScaleLanes(Lanes v, float s) { return _mm_mul_ps(v, _mm_set1_ps(s)); }
+
+static void QuantizeLanes(Lanes v, int32_t* out)
+{
+	const __m128 scale = _mm_setr_ps(float(fromLinearSize - 1), float(fromLinearSize - 1), float(fromLinearSize - 1), 255.0f);
+	v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_cvtps_epi32(_mm_mul_ps(v, scale)));
+}
+#elif defined(RE_ARCH_NEON)
+typedef float32x4_t Lanes;
+
+static Lanes LoadLanes(const rave::FColor& color) { return vld1q_f32(&color.r); }
+static void StoreLanes(rave::FColor& color, Lanes v) { vst1q_f32(&color.r, v); }
+static Lanes AddLanes(Lanes a, Lanes b) { return vaddq_f32(a, b); }
+static Lanes ScaleLanes(Lanes v, float s) { return vmulq_n_f32(v, s); }
+
+static void QuantizeLanes(Lanes v, int32_t* out)
+{
+	const float scale[4] = { float(fromLinearSize - 1), float(fromLinearSize - 1), float(fromLinearSize - 1), 255.0f };
+	v = vminq_f32(vmaxq_f32(v, vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f));
+	vst1q_s32(out, vcvtq_s32_f32(vaddq_f32(vmulq_f32(v, vld1q_f32(scale)), vdupq_n_f32(0.5f))));
+}
+#else
+struct Lanes
+{
+	float v[4];
+};
+
+static Lanes LoadLanes(const rave::FColor& color) { return { { color.r, color.g, color.b, color.a } }; }
+static void StoreLanes(rave::FColor& color, Lanes v) { color = rave::FColor(v.v[0], v.v[1], v.v[2], v.v[3]); }
+static Lanes AddLanes(Lanes a, Lanes b) { return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; }
+static Lanes ScaleLanes(Lanes a, float s) { return { { a.v[0] * s, a.v[1] * s, a.v[2] * s, a.v[3] * s } }; }
+
+static void QuantizeLanes(Lanes v, int32_t* out)
+{
+	for (size_t i = 0; i < 4; i++)
+	{
+		const float scale = i == 3 ? 255.0f : float(fromLinearSize - 1);
+		out[i] = int32_t(std::min(std::max(v.v[i], 0.0f), 1.0f) * scale + 0.5f);
+	}
+}
+#endif
+
+static void RowToLinear(const rave::Color* src, rave::FColor* dst, unsigned int width, const ColorTables& tables)
+{
+	for (unsigned int x = 0; x < width; x++)
+		dst[x] = rave::FColor(tables.toLinear[src[x].r], tables.toLinear[src[x].g], tables.toLinear[src[x].b], src[x].a / 255.0f);
+}
+
+static void RowToColor(const rave::FColor* src, rave::Color* dst, unsigned int width, const ColorTables& tables)
+{
+	int32_t i[4];
+	for (unsigned int x = 0; x < width; x++)
+	{
+		QuantizeLanes(LoadLanes(src[x]), i);
+		dst[x] = rave::Color(tables.fromLinear[i[0]], tables.fromLinear[i[1]], tables.fromLinear[i[2]], (unsigned char)i[3]);
+	}
+}
+
+// Sizes halve rounding down, so an odd last row or column is dropped. A dimension of 1 clamps and reads itself twice
+static void BoxRow(const rave::FColor* row0, const rave::FColor* row1, rave::FColor* dst, unsigned int srcWidth, unsigned int dstWidth)
+{
+	for (unsigned int x = 0; x < dstWidth; x++)
+	{
+		const unsigned int x0 = std::min(2 * x, srcWidth - 1);
+		const unsigned int x1 = std::min(2 * x + 1, srcWidth - 1);
+		const Lanes top = AddLanes(LoadLanes(row0[x0]), LoadLanes(row0[x1]));
+		const Lanes bottom = AddLanes(LoadLanes(row1[x0]), LoadLanes(row1[x1]));
+		StoreLanes(dst[x], ScaleLanes(AddLanes(top, bottom), 0.25f));
+	}
+}
+
+static float Sinc(float x)
+{
+	if (x == 0.0f)
+		return 1.0f;
+	x *= 3.14159265358979f;
+	return std::sin(x) / x;
+}
+
+// Zeroth order modified Bessel function of the first kind
+static float BesselI0(float x)
+{
+	float sum = 1.0f;
+	float term = 1.0f;
+	for (int k = 1; k < 20; k++)
+	{
+		term *= (x / (2.0f * k)) * (x / (2.0f * k));
+		sum += term;
+	}
+	return sum;
+}
+
+static float FilterWeight(float x, rave::MipFilter filter)
+{
+	if (std::abs(x) >= sincRadius)
+		return 0.0f;
+
+	if (filter == rave::MipFilter::Lanczos)
+		return Sinc(x) * Sinc(x / sincRadius);
+
+	const float t = x / sincRadius;
+	return Sinc(x) * BesselI0(kaiserAlpha * std::sqrt(1.0f - t * t)) / BesselI0(kaiserAlpha);
+}
+
+// Every output pixel reads the same number of taps, indices are clamped to the edge
+struct FilterTaps
+{
+	unsigned int count = 0;
+	std::vector<unsigned int> indices;
+	std::vector<float> weights;
+};
+
+static FilterTaps MakeTaps(unsigned int srcLength, unsigned int dstLength, rave::MipFilter filter)
+{
+	FilterTaps taps;
+	if (srcLength == dstLength)
+	{
+		taps.count = 1;
+		taps.indices.resize(dstLength);
+		taps.weights.assign(dstLength, 1.0f);
+		for (unsigned int i = 0; i < dstLength; i++)
+			taps.indices[i] = i;
+		return taps;
+	}
+
+	const float ratio = float(srcLength) / float(dstLength);
+	const float support = sincRadius * ratio;
+	taps.count = (unsigned int)std::ceil(2.0f * support) + 1;
+	taps.indices.resize((size_t)dstLength * taps.count);
+	taps.weights.resize((size_t)dstLength * taps.count);
+
+	for (unsigned int i = 0; i < dstLength; i++)
+	{
+		const float center = (i + 0.5f) * ratio;
+		const int first = (int)std::floor(center - support);
+		unsigned int* indices = taps.indices.data() + (size_t)i * taps.count;
+		float* weights = taps.weights.data() + (size_t)i * taps.count;
+
+		float total = 0.0f;
+		for (unsigned int k = 0; k < taps.count; k++)
+		{
+			const int position = first + (int)k;
+			indices[k] = (unsigned int)std::min(std::max(position, 0), (int)srcLength - 1);
+			weights[k] = FilterWeight((position + 0.5f - center) / ratio, filter);
+			total += weights[k];
+		}
+		for (unsigned int k = 0; k < taps.count; k++)
+			weights[k] /= total;
+	}
+	return taps;
+}
+
+static Lanes ApplyTaps(const rave::FColor* src, size_t stride, const unsigned int* indices, const float* weights, unsigned int count)
+{
+	Lanes sum = ScaleLanes(LoadLanes(src[indices[0] * stride]), weights[0]);
+	for (unsigned int k = 1; k < count; k++)
+		sum = AddLanes(sum, ScaleLanes(LoadLanes(src[indices[k] * stride]), weights[k]));
+	return sum;
+}
+
+// Calls job(begin, end) over row ranges, on the pool when the level is large enough to be worth it
+static void ForRows(unsigned int rows, unsigned int width, rave::ThreadPool* pPool, const std::function<void(unsigned int, unsigned int)>& job)
+{
+	const unsigned int rowsPerTask = (unsigned int)std::max<size_t>(1, pixelsPerTask / std::max(width, 1u));
+	if (!pPool || pPool->GetThreadCount() < 2 || (size_t)rows * width < parallelPixels || rows <= rowsPerTask)
+	{
+		job(0, rows);
+		return;
+	}
+
+	const size_t taskCount = (rows + rowsPerTask - 1) / rowsPerTask;
+	pPool->ParallelFor(taskCount, [&](size_t task)
+	{
+		const unsigned int begin = (unsigned int)task * rowsPerTask;
+		job(begin, std::min(begin + rowsPerTask, rows));
+	});
+}
+
+rave::MipChain::MipChain(const TextureBuffer<Color>& texture, const MipOptions& options)
+{
+	if (texture.IsActive())
+		Generate(texture.Data(), texture.GetSize(), options);
+}
+
+void rave::MipChain::Generate(const Color* pixels, const Size& size, const MipOptions& options)
+{
+	data.clear();
+	sizes.clear();
+	offsets.clear();
+	if (!pixels || size.x == 0 || size.y == 0)
+		return;
+
+	// Lay the whole chain out first so it is allocated once
+	size_t length = 0;
+	for (Size level = size;; level = Size(std::max(level.x / 2, 1u), std::max(level.y / 2, 1u)))
+	{
+		sizes.push_back(level);
+		offsets.push_back(length);
+		length += (size_t)level.x * level.y;
+		if (level.x == 1 && level.y == 1)
+			break;
+	}
+	data.resize(length);
+	std::copy(pixels, pixels + (size_t)size.x * size.y, data.begin());
+
+	// Serial on a worker of the pool it would split over, which then couldn't run the rows while this thread waits
+	ThreadPool* pPool = ThreadPool::ForCaller(options.pPool);
+
+	const ColorTables& tables = GetTables(options.srgb);
+	std::vector<FColor> previous;
+	std::vector<FColor> current;
+	std::vector<FColor> horizontal;
+
+	for (unsigned int level = 1; level < GetLevelCount(); level++)
+	{
+		const Size src = sizes[level - 1];
+		const Size dst = sizes[level];
+		const bool keepFloat = level + 1 < GetLevelCount();
+		Color* out = data.data() + offsets[level];
+		current.resize(keepFloat ? (size_t)dst.x * dst.y : 0);
+
+		// The base level is converted a row at a time into scratch, the others are already linear
+		auto sourceRow = [&](unsigned int y, FColor* scratch) -> const FColor*
+		{
+			if (level > 1)
+				return previous.data() + (size_t)y * src.x;
+			RowToLinear(pixels + (size_t)y * src.x, scratch, src.x, tables);
+			return scratch;
+		};
+
+		if (options.filter == MipFilter::Box)
+		{
+			ForRows(dst.y, dst.x, pPool, [&](unsigned int begin, unsigned int end)
+			{
+				std::vector<FColor> scratch(level > 1 ? dst.x : (size_t)src.x * 2 + dst.x);
+				FColor* rowOut = level > 1 ? scratch.data() : scratch.data() + (size_t)src.x * 2;
+				for (unsigned int y = begin; y < end; y++)
+				{
+					const FColor* row0 = sourceRow(std::min(2 * y, src.y - 1), scratch.data());
+					const FColor* row1 = sourceRow(std::min(2 * y + 1, src.y - 1), scratch.data() + src.x);
+					FColor* target = keepFloat ? current.data() + (size_t)y * dst.x : rowOut;
+					BoxRow(row0, row1, target, src.x, dst.x);
+					RowToColor(target, out + (size_t)y * dst.x, dst.x, tables);
+				}
+			});
+		}
+		else
+		{
+			const FilterTaps tapsX = MakeTaps(src.x, dst.x, options.filter);
+			const FilterTaps tapsY = MakeTaps(src.y, dst.y, options.filter);
+			horizontal.resize((size_t)dst.x * src.y);
+
+			ForRows(src.y, dst.x, pPool, [&](unsigned int begin, unsigned int end)
+			{
+				std::vector<FColor> scratch(level > 1 ? 0 : src.x);
+				for (unsigned int y = begin; y < end; y++)
+				{
+					const FColor* row = sourceRow(y, scratch.data());
+					FColor* target = horizontal.data() + (size_t)y * dst.x;
+					for (unsigned int x = 0; x < dst.x; x++)
+					{
+						const size_t first = (size_t)x * tapsX.count;
+						StoreLanes(target[x], ApplyTaps(row, 1, &tapsX.indices[first], &tapsX.weights[first], tapsX.count));
+					}
+				}
+			});
+
+			ForRows(dst.y, dst.x, pPool, [&](unsigned int begin, unsigned int end)
+			{
+				std::vector<FColor> scratch(keepFloat ? 0 : dst.x);
+				for (unsigned int y = begin; y < end; y++)
+				{
+					const size_t first = (size_t)y * tapsY.count;
+					FColor* target = keepFloat ? current.data() + (size_t)y * dst.x : scratch.data();
+					for (unsigned int x = 0; x < dst.x; x++)
+						StoreLanes(target[x], ApplyTaps(horizontal.data() + x, dst.x, &tapsY.indices[first], &tapsY.weights[first], tapsY.count));
+					RowToColor(target, out + (size_t)y * dst.x, dst.x, tables);
+				}
+			});
+		}
+
+		previous.swap(current);
+	}
+}
+
+unsigned int rave::MipChain::GetLevelCount() const noexcept
+{
+	return (unsigned int)sizes.size();
+}
+
+rave::Size rave::MipChain::GetSize(unsigned int level) const noexcept
+{
+	return level < sizes.size() ? sizes[level] : Size(0, 0);
+}
+
+size_t rave::MipChain::GetOffset(unsigned int level) const noexcept
+{
+	return level < offsets.size() ? offsets[level] : data.size();
+}
+
+rave::Color* rave::MipChain::GetLevel(unsigned int level) noexcept
+{
+	return level < offsets.size() ? data.data() + offsets[level] : nullptr;
+}
+
+const rave::Color* rave::MipChain::GetLevel(unsigned int level) const noexcept
+{
+	return level < offsets.size() ? data.data() + offsets[level] : nullptr;
+}
+
+rave::Color* rave::MipChain::Data() noexcept
+{
+	return data.data();
+}
+
+const rave::Color* rave::MipChain::Data() const noexcept
+{
+	return data.data();
+}
+
+size_t rave::MipChain::GetLength() const noexcept
+{
+	return data.size();
+}
+
+rave::MipChain rave::GenerateMips(const TextureBuffer<Color>& texture, const MipOptions& options)
+{
+	return MipChain(texture, options);
+}
\ No newline at end of file
@@ -0,0 +1,261 @@
+#include "Engine/Graphics/Include/TextureAtlas.h"
+#include <climits>
+#include <numeric>
+#include <unordered_set>
+
+#define RETURN_ERROR(message) return rave::Result(message, rave::RE_FAIL, rave::RE_IMAGE_LOAD_FAIL)
+
+static unsigned int NextPowerOfTwo(unsigned int value)
+{
+	unsigned int power = 1;
+	while (power < value)
+		power <<= 1;
+	return power;
+}
+
+rave::TextureAtlas::TextureAtlas(const AtlasOptions& options)
+	:
+	options(options)
+{
+	this->options.pageSize = NextPowerOfTwo(std::max(options.pageSize, 1u));
+	this->options.maxPageSize = std::max(NextPowerOfTwo(options.maxPageSize), this->options.pageSize);
+}
+
+rave::Result rave::TextureAtlas::Insert(array_view<const AtlasSource> sources)
+{
+	// Check everything up front, so a bad image doesn't leave half of the batch inserted
+	std::unordered_set<std::string_view> names;
+	for (const AtlasSource& source : sources)
+	{
+		if (!source.pixels || source.size.x == 0 || source.size.y == 0)
+			RETURN_ERROR((L"Atlas image \"" + Widen(source.name) + L"\" is empty").c_str());
+		if (Contains(source.name) || !names.insert(source.name).second)
+			RETURN_ERROR((L"\"" + Widen(source.name) + L"\" is already in the atlas").c_str());
+		if (std::max(source.size.x, source.size.y) + 2 * options.padding > options.maxPageSize)
+			RETURN_ERROR((L"Atlas image \"" + Widen(source.name) + L"\" is larger than the largest page").c_str());
+	}
+
+	std::vector<size_t> order(sources.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+	{
+		const Size& sa = sources[a].size;
+		const Size& sb = sources[b].size;
+		if (std::max(sa.x, sa.y) != std::max(sb.x, sb.y))
+			return std::max(sa.x, sa.y) > std::max(sb.x, sb.y);
+		return (size_t)sa.x * sa.y > (size_t)sb.x * sb.y;
+	});
+
+	for (size_t i : order)
+	{
+		auto result = Insert(sources[i].name, sources[i].pixels, sources[i].size);
+		if (result.Failed())
+			return result;
+	}
+	return RE_SUCCESS;
+}
+
+rave::Result rave::TextureAtlas::Insert(const std::string& name, const Color* pixels, const Size& size)
+{
+	if (!pixels || size.x == 0 || size.y == 0)
+		RETURN_ERROR((L"Atlas image \"" + Widen(name) + L"\" is empty").c_str());
+	if (Contains(name))
+		RETURN_ERROR((L"\"" + Widen(name) + L"\" is already in the atlas").c_str());
+
+	const unsigned int width = size.x + 2 * options.padding;
+	const unsigned int height = size.y + 2 * options.padding;
+	if (std::max(width, height) > options.maxPageSize)
+		RETURN_ERROR((L"Atlas image \"" + Widen(name) + L"\" is larger than the largest page").c_str());
+
+	// Best short side fit over every page
+	Rect cell;
+	unsigned int pageIndex = 0;
+	unsigned int bestShortSide = UINT_MAX;
+	unsigned int bestLongSide = UINT_MAX;
+	bool found = false;
+	for (unsigned int i = 0; i < pages.size(); i++)
+	{
+		if (FindPosition(pages[i], width, height, cell, bestShortSide, bestLongSide))
+		{
+			pageIndex = i;
+			found = true;
+		}
+	}
+
+	if (!found)
+	{
+		pageIndex = (unsigned int)pages.size();
+		AddPage(std::max(options.pageSize, NextPowerOfTwo(std::max(width, height))));
+		FindPosition(pages.back(), width, height, cell, bestShortSide, bestLongSide);
+	}
+
+	Page& page = pages[pageIndex];
+	Place(page, cell);
+	Blit(page, cell, pixels, size);
+	page.revision++;
+
+	const float pageWidth = (float)page.pixels.GetSize().x;
+	const float pageHeight = (float)page.pixels.GetSize().y;
+	AtlasRect rect;
+	rect.page = pageIndex;
+	rect.position = Size(cell.x + options.padding, cell.y + options.padding);
+	rect.size = size;
+	rect.uvMin = Vector2(rect.position.x / pageWidth, rect.position.y / pageHeight);
+	rect.uvMax = Vector2((rect.position.x + size.x) / pageWidth, (rect.position.y + size.y) / pageHeight);
+	rects.emplace(name, rect);
+	return RE_SUCCESS;
+}
+
+rave::Result rave::TextureAtlas::Insert(const std::string& name, const TextureBuffer<Color>& texture)
+{
+	return Insert(name, texture.Data(), texture.GetSize());
+}
+
+rave::Result rave::TextureAtlas::InsertFile(const char* filename)
+{
+	std::vector<Color> data;
+	unsigned int width = 0;
+	unsigned int height = 0;
+	auto result = ReadImage(filename, data, &width, &height);
+	if (result.Failed())
+		return result;
+
+	return Insert(filename, data.data(), Size(width, height));
+}
+
+bool rave::TextureAtlas::Contains(const std::string& name) const
+{
+	return rects.find(name) != rects.end();
+}
+
+rave::OptionalResult<rave::AtlasRect> rave::TextureAtlas::Find(const std::string& name) const
+{
+	auto it = rects.find(name);
+	if (it == rects.end())
+		RETURN_ERROR((L"\"" + Widen(name) + L"\" is not in the atlas").c_str());
+	return it->second;
+}
+
+const std::unordered_map<std::string, rave::AtlasRect>& rave::TextureAtlas::GetRects() const noexcept
+{
+	return rects;
+}
+
+unsigned int rave::TextureAtlas::GetPageCount() const noexcept
+{
+	return (unsigned int)pages.size();
+}
+
+const rave::TextureBuffer<rave::Color>& rave::TextureAtlas::GetPage(unsigned int page) const noexcept
+{
+	return pages[page].pixels;
+}
+
+unsigned int rave::TextureAtlas::GetPageRevision(unsigned int page) const noexcept
+{
+	return pages[page].revision;
+}
+
+void rave::TextureAtlas::Clear() noexcept
+{
+	pages.clear();
+	rects.clear();
+}
+
+bool rave::TextureAtlas::FindPosition(const Page& page, unsigned int width, unsigned int height, Rect& best, unsigned int& bestShortSide, unsigned int& bestLongSide) const
+{
+	bool found = false;
+	for (const Rect& free : page.freeRects)
+	{
+		if (free.width < width || free.height < height)
+			continue;
+
+		const unsigned int shortSide = std::min(free.width - width, free.height - height);
+		const unsigned int longSide = std::max(free.width - width, free.height - height);
+		if (shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide))
+		{
+			best = { free.x, free.y, width, height };
+			bestShortSide = shortSide;
+			bestLongSide = longSide;
+			found = true;
+		}
+	}
+	return found;
+}
+
+void rave::TextureAtlas::Place(Page& page, const Rect& used)
+{
+	// Every free rectangle the new one overlaps is replaced by the up to four maximal rectangles around it
+	std::vector<Rect> created;
+	size_t kept = 0;
+	for (const Rect& free : page.freeRects)
+	{
+		if (used.x >= free.x + free.width || used.x + used.width <= free.x ||
+			used.y >= free.y + free.height || used.y + used.height <= free.y)
+		{
+			page.freeRects[kept++] = free;
+			continue;
+		}
+
+		if (used.x > free.x)
+			created.push_back({ free.x, free.y, used.x - free.x, free.height });
+		if (used.x + used.width < free.x + free.width)
+			created.push_back({ used.x + used.width, free.y, free.x + free.width - used.x - used.width, free.height });
+		if (used.y > free.y)
+			created.push_back({ free.x, free.y, free.width, used.y - free.y });
+		if (used.y + used.height < free.y + free.height)
+			created.push_back({ free.x, used.y + used.height, free.width, free.y + free.height - used.y - used.height });
+	}
+	page.freeRects.resize(kept);
+
+	// The untouched rectangles already didn't contain each other, and none of them can lie inside a piece of a split one.
+	// So only the new pieces need checking, against the untouched ones and each other, keeping the first of identical ones
+	auto contains = [](const Rect& outer, const Rect& inner)
+	{
+		return inner.x >= outer.x && inner.y >= outer.y &&
+			inner.x + inner.width <= outer.x + outer.width && inner.y + inner.height <= outer.y + outer.height;
+	};
+	for (size_t i = 0; i < created.size(); i++)
+	{
+		bool redundant = false;
+		for (size_t j = 0; j < kept && !redundant; j++)
+			redundant = contains(page.freeRects[j], created[i]);
+		for (size_t j = 0; j < created.size() && !redundant; j++)
+			redundant = j != i && contains(created[j], created[i]) && (j < i || !contains(created[i], created[j]));
+
+		if (!redundant)
+			page.freeRects.push_back(created[i]);
+	}
+}
+
+void rave::TextureAtlas::Blit(Page& page, const Rect& cell, const Color* pixels, const Size& size)
+{
+	const unsigned int padding = options.padding;
+	const unsigned int pageWidth = page.pixels.GetSize().x;
+
+	for (unsigned int y = 0; y < cell.height; y++)
+	{
+		const bool paddingRow = y < padding || y >= padding + size.y;
+		if (paddingRow && !options.edgeBleed)
+			continue;
+
+		const unsigned int sourceY = std::min(y < padding ? 0 : y - padding, size.y - 1);
+		const Color* source = pixels + (size_t)sourceY * size.x;
+		Color* target = page.pixels.Data() + (size_t)(cell.y + y) * pageWidth + cell.x;
+
+		if (options.edgeBleed)
+		{
+			std::fill(target, target + padding, source[0]);
+			std::fill(target + padding + size.x, target + cell.width, source[size.x - 1]);
+		}
+		std::copy(source, source + size.x, target + padding);
+	}
+}
+
+rave::TextureAtlas::Page& rave::TextureAtlas::AddPage(unsigned int size)
+{
+	Page& page = pages.emplace_back();
+	page.pixels.Load((int)size, (int)size, Color(0, 0, 0, 0));
+	page.freeRects.push_back({ 0, 0, size, size });
+	return page;
+}
\ No newline at end of file
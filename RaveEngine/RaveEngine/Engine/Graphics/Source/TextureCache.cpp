@@ -0,0 +1,221 @@
+#include "Engine/Graphics/Include/TextureCache.h"
+#include "Engine/Utilities/Include/String.h"
+#include <filesystem>
+#include <functional>
+#include <stdio.h>
+#include <string.h>
+
+#define RETURN_ERROR(message) return rave::Result(message, rave::RE_FAIL, rave::RE_IMAGE_LOAD_FAIL)
+
+static_assert(sizeof(rave::TextureCacheHeader) <= rave::TextureCacheHeader::pageSize, "The header has to fit in front of the first page");
+
+static uint64_t MixHash(uint64_t v)
+{
+	v ^= v >> 33;
+	v *= 0xFF51AFD7ED558CCDull;
+	v ^= v >> 33;
+	return v;
+}
+
+static rave::Size LevelSize(const rave::TextureCacheHeader& header, unsigned int level)
+{
+	rave::Size size(header.width, header.height);
+	for (unsigned int i = 0; i < level; i++)
+		size = rave::Size(std::max(size.x / 2, 1u), std::max(size.y / 2, 1u));
+	return size;
+}
+
+static uint32_t QualityFlags(const rave::DecodeOptions& options)
+{
+	return (uint32_t)options.dctMethod | (options.fancyUpsampling ? 0u : 0x100u) | (options.blockSmoothing ? 0u : 0x200u);
+}
+
+static rave::Result WriteLevels(const char* filename, unsigned int levelCount, const rave::Color* const* levels, const rave::Size* sizes, const rave::TextureSource& source, const rave::DecodeOptions& options)
+{
+	if (levelCount == 0 || levelCount > rave::TextureCacheHeader::maxLevels)
+		RETURN_ERROR(L"A texture cache holds between 1 and 32 levels");
+
+	rave::TextureCacheHeader header;
+	header.levelCount = levelCount;
+	header.width = sizes[0].x;
+	header.height = sizes[0].y;
+	header.maxWidth = options.maxSize.x;
+	header.maxHeight = options.maxSize.y;
+	header.scale = options.scale;
+	header.quality = QualityFlags(options);
+	header.sourceSize = source.size;
+	header.sourceTime = source.time;
+	header.sourceHash = source.hash;
+
+	uint64_t offset = rave::TextureCacheHeader::pageSize;
+	for (unsigned int i = 0; i < levelCount; i++)
+	{
+		header.levelOffsets[i] = offset;
+		offset += (uint64_t)sizes[i].x * sizes[i].y * sizeof(rave::Color);
+	}
+
+	// Several loads of the same image may be writing at once, each gets its own temporary file
+	const std::string temporary = std::string(filename) + '.' + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	FILE* file = fopen(temporary.c_str(), "wb");
+	if (!file)
+		return rave::Result((L"Unable to create file \"" + rave::Widen(temporary) + L"\"").c_str(), rave::RE_FAIL, rave::RE_FILE_NOT_FOUND);
+
+	const std::vector<unsigned char> padding(rave::TextureCacheHeader::pageSize - sizeof(header), 0);
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(padding.data(), 1, padding.size(), file) == padding.size();
+	for (unsigned int i = 0; i < levelCount && written; i++)
+	{
+		const size_t count = (size_t)sizes[i].x * sizes[i].y;
+		written = fwrite(levels[i], sizeof(rave::Color), count, file) == count;
+	}
+	written = fclose(file) == 0 && written;
+
+	std::error_code error;
+	if (written)
+		std::filesystem::rename(temporary, filename, error);
+	if (!written || error)
+	{
+		std::filesystem::remove(temporary, error);
+		return rave::Result((L"Unable to write texture cache \"" + rave::Widen(std::string(filename)) + L"\"").c_str(), rave::RE_FAIL, rave::RE_FILE_NOT_FOUND);
+	}
+	return rave::RE_SUCCESS;
+}
+
+rave::OptionalResult<rave::TextureSource> rave::StatTextureSource(const char* filename)
+{
+	std::error_code error;
+	TextureSource source;
+	source.size = std::filesystem::file_size(filename, error);
+	if (!error)
+		source.time = std::filesystem::last_write_time(filename, error).time_since_epoch().count();
+	if (error)
+		return Result((L"Unable to open file \"" + Widen(std::string(filename)) + L"\"").c_str(), RE_FAIL, RE_FILE_NOT_FOUND);
+	return source;
+}
+
+uint64_t rave::HashTextureSource(const void* bytes, size_t length) noexcept
+{
+	// Eight bytes per multiply, this has to stay far cheaper than the decode it saves
+	const unsigned char* data = static_cast<const unsigned char*>(bytes);
+	uint64_t hash = 0x9E3779B97F4A7C15ull ^ length;
+
+	size_t i = 0;
+	for (; i + 8 <= length; i += 8)
+	{
+		uint64_t word;
+		memcpy(&word, data + i, 8);
+		hash = (hash ^ MixHash(word)) * 0x87C37B91114253D5ull;
+	}
+	uint64_t tail = 0;
+	for (size_t shift = 0; i < length; i++, shift += 8)
+		tail |= (uint64_t)data[i] << shift;
+
+	return MixHash(hash ^ MixHash(tail));
+}
+
+std::string rave::TextureCachePath(const char* sourceFilename, const std::string& directory)
+{
+	if (directory.empty())
+		return std::string(sourceFilename) + ".rtex";
+
+	char pathHash[17];
+	snprintf(pathHash, sizeof(pathHash), "%016llx", (unsigned long long)HashTextureSource(sourceFilename, strlen(sourceFilename)));
+	const std::filesystem::path name = std::filesystem::path(sourceFilename).filename().string() + '.' + pathHash + ".rtex";
+	return (std::filesystem::path(directory) / name).string();
+}
+
+rave::Result rave::TextureCache::Open(const char* filename)
+{
+	Close();
+
+	auto result = file.Open(filename);
+	if (result.Failed())
+		return result;
+
+	const TextureCacheHeader* candidate = reinterpret_cast<const TextureCacheHeader*>(file.Data());
+	bool valid = file.Size() >= TextureCacheHeader::pageSize &&
+		candidate->magic == TextureCacheHeader::magicValue &&
+		candidate->version == TextureCacheHeader::currentVersion &&
+		candidate->format == TextureCacheFormat::RGBA8 &&
+		candidate->levelCount > 0 && candidate->levelCount <= TextureCacheHeader::maxLevels &&
+		candidate->width > 0 && candidate->height > 0;
+
+	for (unsigned int i = 0; valid && i < candidate->levelCount; i++)
+	{
+		const Size size = LevelSize(*candidate, i);
+		const uint64_t offset = candidate->levelOffsets[i];
+		valid = offset % sizeof(Color) == 0 && offset >= sizeof(TextureCacheHeader) && offset <= file.Size() &&
+			(uint64_t)size.x * size.y * sizeof(Color) <= file.Size() - offset;
+	}
+
+	if (!valid)
+	{
+		file.Close();
+		RETURN_ERROR((L"\"" + Widen(std::string(filename)) + L"\" is not a valid texture cache").c_str());
+	}
+
+	header = candidate;
+	return RE_SUCCESS;
+}
+
+void rave::TextureCache::Close() noexcept
+{
+	file.Close();
+	header = nullptr;
+}
+
+bool rave::TextureCache::IsOpen() const noexcept
+{
+	return header;
+}
+
+bool rave::TextureCache::Matches(const TextureSource& source, const DecodeOptions& options, const void* sourceBytes, size_t sourceLength) const noexcept
+{
+	if (!header)
+		return false;
+
+	if (header->maxWidth != options.maxSize.x || header->maxHeight != options.maxSize.y || header->scale != options.scale || header->quality != QualityFlags(options))
+		return false;
+	if (header->sourceSize != source.size)
+		return false;
+	if (header->sourceTime == source.time)
+		return true;
+
+	return sourceBytes && header->sourceHash == HashTextureSource(sourceBytes, sourceLength);
+}
+
+const rave::TextureCacheHeader& rave::TextureCache::GetHeader() const noexcept
+{
+	return *header;
+}
+
+unsigned int rave::TextureCache::GetLevelCount() const noexcept
+{
+	return header ? header->levelCount : 0;
+}
+
+rave::Size rave::TextureCache::GetSize(unsigned int level) const noexcept
+{
+	return level < GetLevelCount() ? LevelSize(*header, level) : Size(0, 0);
+}
+
+const rave::Color* rave::TextureCache::GetLevel(unsigned int level) const noexcept
+{
+	return level < GetLevelCount() ? reinterpret_cast<const Color*>(file.Data() + header->levelOffsets[level]) : nullptr;
+}
+
+rave::Result rave::WriteTextureCache(const char* filename, const MipChain& mips, const TextureSource& source, const DecodeOptions& options)
+{
+	std::vector<const Color*> levels(mips.GetLevelCount());
+	std::vector<Size> sizes(mips.GetLevelCount());
+	for (unsigned int i = 0; i < mips.GetLevelCount(); i++)
+	{
+		levels[i] = mips.GetLevel(i);
+		sizes[i] = mips.GetSize(i);
+	}
+	return WriteLevels(filename, mips.GetLevelCount(), levels.data(), sizes.data(), source, options);
+}
+
+rave::Result rave::WriteTextureCache(const char* filename, const Color* pixels, const Size& size, const TextureSource& source, const DecodeOptions& options)
+{
+	return WriteLevels(filename, 1, &pixels, &size, source, options);
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+#include "Engine/Include/ImageLoader.h"
+#include "Engine/Utilities/Include/FileMapping.h"
+
+namespace rave
+{
+	struct GifFrameRect
+	{
+		unsigned int x = 0;
+		unsigned int y = 0;
+		unsigned int width = 0;
+		unsigned int height = 0;
+	};
+
+	// Keeps an animated gif open between frames, so each frame only costs its own decode.
+	class GifStream
+	{
+	public:
+		GifStream() = default;
+		GifStream(const char* filename, const bool throws = false);
+		GifStream(const GifStream&) = delete;
+		GifStream(GifStream&& rhs) noexcept;
+
+		GifStream& operator= (const GifStream&) = delete;
+		GifStream& operator= (GifStream&& rhs) noexcept;
+
+		Result Open(const char* filename);
+		// The bytes are not copied and must outlive the stream
+		Result Open(const void* bytes, size_t length);
+		void Close() noexcept;
+		bool IsOpen() const noexcept;
+
+		// Decodes the next frame into GetFrame(), the value is false once the animation has ended
+		OptionalResult<bool> NextFrame();
+		void Rewind() noexcept;
+
+		// Decodes every frame into one contiguous array of frameCount * width * height pixels
+		Result DecodeAll(std::vector<Color>& frames, std::vector<unsigned int>* pDelays = nullptr);
+
+		Size GetSize() const noexcept;
+		const Color* GetFrame() const noexcept;
+		// Index of the frame in GetFrame(), -1 before the first call to NextFrame
+		int GetFrameIndex() const noexcept;
+		// Display time of the current frame, in hundredths of a second
+		unsigned int GetDelay() const noexcept;
+		// Part of the canvas the current frame drew to
+		GifFrameRect GetDirtyRect() const noexcept;
+		// 0 means the animation loops forever
+		unsigned int GetLoopCount() const noexcept;
+
+		~GifStream();
+
+	private:
+		Result Attach(const void* bytes, size_t length);
+		void RenderFrame();
+
+		FileMapping file;
+		gd_GIF* gif = nullptr;
+		std::vector<Color> frame;
+		int frameIndex = -1;
+	};
+}
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include "Engine/Utilities/Include/Result.h"
 #include "Engine/Utilities/Include/Color.h"
 #include "Engine/Utilities/Include/Vector.h"
+#include "Engine/Utilities/Include/ArrayView.h"
+#include "Engine/Utilities/Include/ThreadPool.h"
 #include <string_view>
 #include <vector>
 #include <setjmp.h>
@@ -13,23 +15,111 @@
 
 namespace rave
 {
+	enum class ImageFormat
+	{
+		Unknown,
+		PNG,
+		JPEG,
+		BMP,
+		GIF,
+		// Only RGBA8 textures go through the Color readers, KtxFile hands out every format as is
+		KTX2,
+		QOI
+	};
+
+	struct ImageInfo
+	{
+		ImageFormat format = ImageFormat::Unknown;
+		Size size = { 0, 0 };
+		unsigned int channels = 0;
+		unsigned int bitDepth = 0;
+		unsigned int frameCount = 0;
+	};
+
+	// Decode time settings, formats that can't honour one of them ignore it
+	struct DecodeOptions
+	{
+		// JPEG: decode straight to a smaller size with libjpeg's DCT scaling, which goes in steps of 1/8.
+		// The largest step whose output fits inside maxSize is used, 0 leaves a dimension unlimited
+		Size maxSize = { 0, 0 };
+		// JPEG: the smallest step of at least this scale is used. Scales that aren't positive numbers decode at full size
+		float scale = 1.0f;
+		// JPEG: JDCT_IFAST is quicker than the default but loses some precision, mostly visible in smooth gradients
+		J_DCT_METHOD dctMethod = JDCT_ISLOW;
+		// JPEG: interpolate subsampled chroma. Without it each chroma sample is repeated, slightly blockier but faster
+		bool fancyUpsampling = true;
+		// JPEG: hide the blocking of progressive files whose later scans are missing
+		bool blockSmoothing = true;
+		// PNG: check the chunk CRCs and zlib's adler32. Only turn it off for data whose integrity is checked elsewhere,
+		// like the contents of an already hashed package. Corrupt data then decodes to garbage instead of failing
+		bool verifyChecksums = true;
+		// JPEG: large files with restart markers are decoded in horizontal strips on this pool, or on the shared one without it.
+		// A decode running on a worker of that pool, or on any pool's worker when none is given, stays on its own thread
+		ThreadPool* pPool = nullptr;
+
+		// The defaults, full quality with every check
+		static DecodeOptions Accurate() noexcept;
+		// The same pixels as Accurate, without the PNG checksums
+		static DecodeOptions Trusted() noexcept;
+		// Fast IDCT and upsampling and no PNG checksums, for editor previews and hot reloading
+		static DecodeOptions FastPreview() noexcept;
+	};
+
+	ImageFormat ImageFormatFromExtension(std::string_view filename);
+	// Identifies the format from its signature bytes, the file name plays no part
+	ImageFormat DetectImageFormat(const void* bytes, size_t length);
+
+	// Everywhere a format is taken, ImageFormat::Unknown means it is detected from the bytes
+
+	// Reads only the header bytes, pixel data is never decompressed
+	OptionalResult<ImageInfo> ProbeImage(const void* bytes, size_t length, ImageFormat format = ImageFormat::Unknown);
+	OptionalResult<ImageInfo> ProbeImage(std::string_view filename);
+	std::vector<OptionalResult<ImageInfo>> ProbeImages(array_view<const char* const> filenames);
+
 	Result ReadGIF  (const char* filename, std::vector<Color>& data, unsigned int frame = 0, unsigned int* pWidth = nullptr, unsigned int* pHeight = nullptr);
 	Result ReadBMP  (const char* filename, std::vector<Color>& data, unsigned int* pWidth = nullptr, unsigned int* pHeight = nullptr);
-	Result ReadPNG  (const char* filename, std::vector<Color>& data, unsigned int* pWidth = nullptr, unsigned int* pHeight = nullptr);
-	Result ReadJPEG (const char* filename, std::vector<Color>& data, unsigned int* pWidth = nullptr, unsigned int* pHeight = nullptr);
-	Result ReadImage(std::string_view filename, std::vector<Color>& data, unsigned int* pWidth = nullptr, unsigned int* pHeight = nullptr);
+	Result ReadPNG  (const char* filename, std::vector<Color>& data, unsigned int* pWidth = nullptr, unsigned int* pHeight = nullptr, const DecodeOptions& options = {});
+	Result ReadJPEG (const char* filename, std::vector<Color>& data, unsigned int* pWidth = nullptr, unsigned int* pHeight = nullptr, const DecodeOptions& options = {});
+	Result ReadQOI  (const char* filename, std::vector<Color>& data, unsigned int* pWidth = nullptr, unsigned int* pHeight = nullptr);
+	Result ReadImage(std::string_view filename, std::vector<Color>& data, unsigned int* pWidth = nullptr, unsigned int* pHeight = nullptr, const DecodeOptions& options = {});
+	Result ReadImage(const void* bytes, size_t length, ImageFormat format, std::vector<Color>& data, unsigned int* pWidth = nullptr, unsigned int* pHeight = nullptr, const DecodeOptions& options = {});
+	Result ReadImage(const void* bytes, size_t length, std::vector<Color>& data, unsigned int* pWidth = nullptr, unsigned int* pHeight = nullptr, const DecodeOptions& options = {});
 
 	OptionalResult<Size> ImageSizeGIF (const char* filename);
 	OptionalResult<Size> ImageSizeBMP (const char* filename);
 	OptionalResult<Size> ImageSizePNG (const char* filename);
 	OptionalResult<Size> ImageSizeJPEG(const char* filename);
+	OptionalResult<Size> ImageSizeQOI (const char* filename);
 	OptionalResult<Size> ImageSize(std::string_view filename);
 
+	OptionalResult<Size> ImageSizeGIF (const void* bytes, size_t length);
+	OptionalResult<Size> ImageSizeBMP (const void* bytes, size_t length);
+	OptionalResult<Size> ImageSizePNG (const void* bytes, size_t length);
+	OptionalResult<Size> ImageSizeJPEG(const void* bytes, size_t length, const DecodeOptions& options = {});
+	OptionalResult<Size> ImageSizeQOI (const void* bytes, size_t length);
+	// Size of the image ReadImageRaw produces with the same options
+	OptionalResult<Size> ImageSize(const void* bytes, size_t length, ImageFormat format = ImageFormat::Unknown, const DecodeOptions& options = {});
+
 	Result ReadGIFRaw  (const char* filename, Color*, unsigned int frame = 0);
 	Result ReadBMPRaw  (const char* filename, Color*);
-	Result ReadPNGRaw  (const char* filename, Color*);
-	Result ReadJPEGRaw (const char* filename, Color*);
-	Result ReadImageRaw(std::string_view  filename, Color* data);
+	Result ReadPNGRaw  (const char* filename, Color*, const DecodeOptions& options = {});
+	Result ReadJPEGRaw (const char* filename, Color*, const DecodeOptions& options = {});
+	Result ReadQOIRaw  (const char* filename, Color*);
+	Result ReadImageRaw(std::string_view  filename, Color* data, const DecodeOptions& options = {});
+
+	Result ReadGIFRaw  (const void* bytes, size_t length, Color*, unsigned int frame = 0);
+	Result ReadBMPRaw  (const void* bytes, size_t length, Color*);
+	Result ReadPNGRaw  (const void* bytes, size_t length, Color*, const DecodeOptions& options = {});
+	Result ReadJPEGRaw (const void* bytes, size_t length, Color*, const DecodeOptions& options = {});
+	// Level 0 of the first layer and face
+	Result ReadKTX2Raw (const void* bytes, size_t length, Color*);
+	Result ReadQOIRaw  (const void* bytes, size_t length, Color*);
+	Result ReadImageRaw(const void* bytes, size_t length, ImageFormat format, Color* data, const DecodeOptions& options = {});
+	Result ReadImageRaw(const void* bytes, size_t length, Color* data, const DecodeOptions& options = {});
+
+	// QOI is lossless and several times faster than PNG both ways, for frame dumps and intermediate caches
+	Result EncodeQOI(const Color* pixels, const Size& size, std::vector<unsigned char>& qoi);
+	Result WriteQOI (const Color* pixels, const Size& size, const char* filename);
 
 	static void JpegErrorExit(j_common_ptr cinfo);
 	static void JpegOutputMessage(j_common_ptr cinfo);
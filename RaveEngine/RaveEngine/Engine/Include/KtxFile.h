@@ -0,0 +1,88 @@
+#pragma once
+#include "Engine/Include/ImageLoader.h"
+#include "Engine/Utilities/Include/FileMapping.h"
+#include "Engine/Utilities/Include/ThreadPool.h"
+#include <stdint.h>
+
+namespace rave
+{
+	enum class KtxSupercompression : uint32_t
+	{
+		None = 0,
+		BasisLZ = 1,
+		Zstandard = 2,
+		Zlib = 3
+	};
+
+	// One mip level, holding every layer, face and depth slice of it in the order the GPU expects them
+	struct KtxLevel
+	{
+		const unsigned char* data = nullptr;
+		size_t length = 0;
+		Size size = { 0, 0 };
+		unsigned int depth = 1;
+	};
+
+	// Reads the level index of a KTX2 file and hands out the bytes of each level as they are, without converting pixels.
+	// Levels without supercompression point straight into the file, zlib supercompressed levels are inflated on first use
+	class KtxFile
+	{
+	public:
+		KtxFile() = default;
+		KtxFile(const char* filename, const bool throws = false);
+		KtxFile(const KtxFile&) = delete;
+		KtxFile(KtxFile&& rhs) noexcept;
+
+		KtxFile& operator= (const KtxFile&) = delete;
+		KtxFile& operator= (KtxFile&& rhs) noexcept;
+
+		Result Open(const char* filename);
+		// The bytes are not copied and must outlive the file
+		Result Open(const void* bytes, size_t length);
+		void Close() noexcept;
+		bool IsOpen() const noexcept;
+
+		// A VkFormat, VK_FORMAT_UNDEFINED for Basis Universal payloads
+		uint32_t GetVkFormat() const noexcept;
+		// BCn, ETC2, EAC or ASTC
+		bool IsBlockCompressed() const noexcept;
+		KtxSupercompression GetSupercompression() const noexcept;
+
+		Size GetSize() const noexcept;
+		unsigned int GetDepth() const noexcept;
+		unsigned int GetLayerCount() const noexcept;
+		unsigned int GetFaceCount() const noexcept;
+		unsigned int GetLevelCount() const noexcept;
+
+		// Two threads may only ask for the same supercompressed level at once after InflateAll
+		OptionalResult<KtxLevel> GetLevel(unsigned int level);
+		// Inflates every supercompressed level up front, one level per job when there is a pool
+		Result InflateAll(ThreadPool* pPool = nullptr);
+
+	private:
+		struct LevelIndex
+		{
+			uint64_t offset = 0;
+			uint64_t length = 0;
+			uint64_t uncompressedLength = 0;
+		};
+
+		Result Attach(const void* bytes, size_t length);
+		// The most bytes any format could need for every slice, layer and face of the level
+		uint64_t MaxLevelLength(unsigned int level) const noexcept;
+		Result Inflate(unsigned int level);
+
+		FileMapping file;
+		const unsigned char* bytes = nullptr;
+		size_t length = 0;
+
+		uint32_t vkFormat = 0;
+		KtxSupercompression supercompression = KtxSupercompression::None;
+		Size size = { 0, 0 };
+		unsigned int depth = 0;
+		unsigned int layerCount = 0;
+		unsigned int faceCount = 0;
+		std::vector<LevelIndex> levels;
+		std::vector<std::vector<unsigned char>> inflated;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+#include "Engine/Include/ImageLoader.h"
+#include <functional>
+
+namespace rave
+{
+	// Push style png decoder: feed it the file in chunks of any size as they arrive,
+	// finished rows are handed to the callback in RGBA before the rest of the file is there.
+	class PngStreamDecoder
+	{
+	public:
+		// The row only stays valid during the call
+		typedef std::function<void(unsigned int y, const Color* row)> RowCallback;
+		typedef std::function<void(const Size& size)> HeaderCallback;
+
+		PngStreamDecoder(RowCallback onRow, HeaderCallback onHeader = nullptr);
+		PngStreamDecoder(const PngStreamDecoder&) = delete;
+		PngStreamDecoder& operator= (const PngStreamDecoder&) = delete;
+
+		Result Push(const void* bytes, size_t length);
+
+		bool IsHeaderRead() const noexcept;
+		bool IsFinished() const noexcept;
+		// Zero until the header has been read
+		Size GetSize() const noexcept;
+
+		~PngStreamDecoder();
+
+	private:
+		static void InfoCallback(png_structp png, png_infop info);
+		static void RowCallbackThunk(png_structp png, png_bytep row, png_uint_32 y, int pass);
+		static void EndCallback(png_structp png, png_infop info);
+
+		void EmitRow(unsigned int y);
+
+		png_structp png = nullptr;
+		png_infop info = nullptr;
+		RowCallback onRow;
+		HeaderCallback onHeader;
+		Size size = { 0, 0 };
+		bool headerRead = false;
+		bool finished = false;
+		bool failed = false;
+
+		// Interlaced images are assembled here, a row is only handed out once its last pass is in
+		std::vector<Color> image;
+		std::vector<bool> emitted;
+	};
+}
\ No newline at end of file
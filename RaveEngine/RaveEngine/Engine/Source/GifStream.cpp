@@ -0,0 +1,195 @@
+#include "Engine/Include/GifStream.h"
+#include "Engine/Utilities/Include/PixelConvert.h"
+
+#define RETURN_ERROR(message) return rave::Result(message, rave::RE_FAIL, rave::RE_IMAGE_LOAD_FAIL)
+
+rave::GifStream::GifStream(const char* filename, const bool throws)
+{
+	auto result = Open(filename);
+	if (throws)
+		result.Throw();
+}
+
+rave::GifStream::GifStream(GifStream&& rhs) noexcept
+	:
+	file(std::move(rhs.file)),
+	gif(rhs.gif),
+	frame(std::move(rhs.frame)),
+	frameIndex(rhs.frameIndex)
+{
+	rhs.gif = nullptr;
+	rhs.frameIndex = -1;
+}
+
+rave::GifStream& rave::GifStream::operator=(GifStream&& rhs) noexcept
+{
+	if (this != &rhs)
+	{
+		Close();
+		file = std::move(rhs.file);
+		gif = rhs.gif;
+		frame = std::move(rhs.frame);
+		frameIndex = rhs.frameIndex;
+		rhs.gif = nullptr;
+		rhs.frameIndex = -1;
+	}
+	return *this;
+}
+
+rave::Result rave::GifStream::Open(const char* filename)
+{
+	Close();
+
+	auto result = file.Open(filename);
+	if (result.Failed())
+		return result;
+
+	return Attach(file.Data(), file.Size());
+}
+
+rave::Result rave::GifStream::Open(const void* bytes, size_t length)
+{
+	Close();
+	return Attach(bytes, length);
+}
+
+void rave::GifStream::Close() noexcept
+{
+	if (gif)
+		gd_close_gif(gif);
+
+	gif = nullptr;
+	frame.clear();
+	frameIndex = -1;
+	file.Close();
+}
+
+bool rave::GifStream::IsOpen() const noexcept
+{
+	return gif;
+}
+
+rave::OptionalResult<bool> rave::GifStream::NextFrame()
+{
+	if (!gif)
+		RETURN_ERROR(L"No gif is open");
+
+	const int status = gd_get_frame(gif);
+	if (status == -1)
+		RETURN_ERROR(L"Corrupt gif frame");
+	if (status == 0)
+		return false;
+
+	frameIndex++;
+	RenderFrame();
+	return true;
+}
+
+void rave::GifStream::Rewind() noexcept
+{
+	if (!gif)
+		return;
+
+	gd_rewind(gif);
+	frameIndex = -1;
+}
+
+rave::Result rave::GifStream::DecodeAll(std::vector<Color>& frames, std::vector<unsigned int>* pDelays)
+{
+	if (!gif)
+		RETURN_ERROR(L"No gif is open");
+
+	Rewind();
+
+	// Count the frames up front so the output is allocated exactly once
+	auto info = ProbeImage(gif->data, gif->size, ImageFormat::GIF);
+	if (info.GetResult().Failed())
+		return info.GetResult();
+
+	const size_t pixelCount = frame.size();
+	frames.clear();
+	frames.reserve(pixelCount * info.Get().frameCount);
+	if (pDelays)
+	{
+		pDelays->clear();
+		pDelays->reserve(info.Get().frameCount);
+	}
+
+	while (true)
+	{
+		auto next = NextFrame();
+		if (next.GetResult().Failed())
+			return next.GetResult();
+		if (!next.Get())
+			break;
+
+		frames.insert(frames.end(), frame.begin(), frame.end());
+		if (pDelays)
+			pDelays->push_back(GetDelay());
+	}
+
+	Rewind();
+	return RE_SUCCESS;
+}
+
+rave::Size rave::GifStream::GetSize() const noexcept
+{
+	return gif ? Size(gif->width, gif->height) : Size(0, 0);
+}
+
+const rave::Color* rave::GifStream::GetFrame() const noexcept
+{
+	return frame.data();
+}
+
+int rave::GifStream::GetFrameIndex() const noexcept
+{
+	return frameIndex;
+}
+
+unsigned int rave::GifStream::GetDelay() const noexcept
+{
+	return gif ? gif->gce.delay : 0;
+}
+
+rave::GifFrameRect rave::GifStream::GetDirtyRect() const noexcept
+{
+	if (!gif)
+		return {};
+
+	return { gif->fx, gif->fy, gif->fw, gif->fh };
+}
+
+unsigned int rave::GifStream::GetLoopCount() const noexcept
+{
+	return gif ? gif->loop_count : 0;
+}
+
+rave::GifStream::~GifStream()
+{
+	Close();
+}
+
+rave::Result rave::GifStream::Attach(const void* bytes, size_t length)
+{
+	gif = gd_open_gif_memory(bytes, length);
+	if (!gif)
+	{
+		Close();
+		RETURN_ERROR(L"Unrecognized file format");
+	}
+
+	frame.resize((size_t)gif->width * (size_t)gif->height);
+	return RE_SUCCESS;
+}
+
+void rave::GifStream::RenderFrame()
+{
+	// Same in-place expansion as ReadGIFRaw, so a frame here is identical to reading it directly
+	const size_t pixelCount = frame.size();
+	unsigned char* rgb = reinterpret_cast<unsigned char*>(frame.data()) + pixelCount;
+	gd_render_frame(gif, rgb);
+
+	const unsigned char* bg = &gif->palette->colors[gif->bgindex * 3];
+	ConvertRGBToRGBAKeyed(rgb, frame.data(), pixelCount, Color(bg[0], bg[1], bg[2]));
+}
\ No newline at end of file
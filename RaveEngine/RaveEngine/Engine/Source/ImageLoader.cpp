@@ -1,15 +1,19 @@
 #include "Engine/Include/ImageLoader.h"
-#include <fstream>
+#include "Engine/Include/KtxFile.h"
+#include "Engine/Utilities/Include/Arena.h"
+#include "Engine/Utilities/Include/FileMapping.h"
+#include "Engine/Utilities/Include/PixelConvert.h"
 #include <vector>
 #include <stdexcept>
 #include <iostream>
 #include <stdio.h>
 #include <stdint.h>
+#include <algorithm>
+#include <cmath>
 
 
-#define rave_bail_png() return rave::Result((std::wstring(L"Something went wrong while trying to read png file \"") + Widen(filename) + L"\"").c_str(), RE_FAIL, RE_IMAGE_LOAD_FAIL)
-#define RETURN_ERROR(message) return rave::Result(message, RE_FAIL, RE_IMAGE_LOAD_FAIL)
-#define RETURN_FNF() return rave::Result((L"Unable to open file \"" + rave::Widen(std::string(filename)) + L"\"").c_str(), RE_FAIL, RE_FILE_NOT_FOUND)
+#define RETURN_ERROR(message) return rave::Result(message, rave::RE_FAIL, rave::RE_IMAGE_LOAD_FAIL)
+#define RETURN_PNG_FAIL() RETURN_ERROR(L"Something went wrong while trying to read png data")
 
 struct JpegErrorManager
 {
@@ -79,11 +83,6 @@ uint32_t make_stride_aligned(const uint32_t align_stride, const uint32_t row_str
 	return new_stride;
 }
 
-struct ColorRGB
-{
-	unsigned char r, g, b;
-};
-
 void rave::JpegErrorExit(j_common_ptr cinfo)
 {
 	// cinfo->err is actually a pointer to my_error_mgr.defaultErrorManager, since pub
@@ -100,306 +99,763 @@ void rave::JpegOutputMessage(j_common_ptr cinfo)
 	rave_throw_message(Widen(buffer).c_str());
 }
 
-rave::Result rave::ReadImage(std::string_view filename, std::vector<Color>& data, unsigned int* pWidth, unsigned int* pHeight)
+struct PngMemoryReader
 {
-	size_t dotpos = filename.rfind('.');
-	if (dotpos == filename.npos)
-		return L"Invalid file name";
-	std::string_view formatstr = filename.substr(dotpos);
+	const png_byte* data;
+	size_t length;
+	size_t offset;
+};
 
-	if (!FileExists(filename.data()))
-		RETURN_FNF();
+static void PngReadMemory(png_structp png, png_bytep out, png_size_t count)
+{
+	PngMemoryReader* pReader = static_cast<PngMemoryReader*>(png_get_io_ptr(png));
+	if (count > pReader->length - pReader->offset)
+		png_error(png, "Unexpected end of png data");
 
-	switch (HashString(formatstr.data()))
+	memcpy(out, pReader->data + pReader->offset, count);
+	pReader->offset += count;
+}
+
+// Each thread keeps one arena for the libpng and libjpeg state of the image it is decoding,
+// so a batch of similar images stops touching the heap after the first one
+struct DecoderContext
+{
+	rave::Arena arena = rave::Arena(256 * 1024);
+	bool busy = false;
+};
+
+// Beyond this the arena is released instead of kept around, one huge image shouldn't pin memory on every thread
+static constexpr size_t maxRetainedDecoderMemory = 16 * 1024 * 1024;
+
+// Lends the calling thread's decoder arena out for one image and resets it afterwards
+class DecoderScope
+{
+public:
+	DecoderScope()
 	{
-		case HashString(".png"):  return ReadPNG(filename.data(), data, pWidth, pHeight);
-		case HashString(".bmp"):  return ReadBMP(filename.data(), data, pWidth, pHeight);
-		case HashString(".jpg"):
-		case HashString(".jpe"):
-		case HashString(".jpeg"): return ReadJPEG(filename.data(), data, pWidth, pHeight);
-		case HashString(".gif"):  return ReadGIF(filename.data(), data, 0, pWidth, pHeight);
+		static thread_local DecoderContext context;
 
-		default: return L"File format not recognised";
+		// A decode nested inside another one on the same thread gets an arena of its own
+		if (context.busy)
+		{
+			local = std::make_unique<rave::Arena>();
+			return;
+		}
+		context.busy = true;
+		shared = &context;
 	}
+	DecoderScope(const DecoderScope&) = delete;
+	DecoderScope& operator= (const DecoderScope&) = delete;
+
+	rave::Arena& GetArena() noexcept
+	{
+		return shared ? shared->arena : *local;
+	}
+
+	~DecoderScope()
+	{
+		if (!shared)
+			return;
+
+		if (shared->arena.GetCapacity() > maxRetainedDecoderMemory)
+			shared->arena.Release();
+		else
+			shared->arena.Reset();
+		shared->busy = false;
+	}
+
+private:
+	DecoderContext* shared = nullptr;
+	std::unique_ptr<rave::Arena> local;
+};
+
+// The arena frees everything at once, the libraries' own frees are no-ops
+static png_voidp PngArenaAllocate(png_structp png, png_alloc_size_t size)
+{
+	return static_cast<rave::Arena*>(png_get_mem_ptr(png))->Allocate(size);
+}
+static void PngArenaFree(png_structp png, png_voidp pointer)
+{
+}
+static void* JpegArenaAllocate(void* opaque, size_t size)
+{
+	return static_cast<rave::Arena*>(opaque)->Allocate(size);
+}
+static void JpegArenaFree(void* opaque, void* object)
+{
 }
 
-rave::OptionalResult<rave::Size> rave::ImageSizeGIF(const char* filename)
+// Sends libjpeg's allocations on this thread to an arena while it lives
+class JpegMemoryScope
 {
-	gd_GIF* pGif = gd_open_gif(filename);
-	if (!pGif)
-		RETURN_FNF();
+public:
+	JpegMemoryScope(rave::Arena& arena)
+		:
+		hooks{ JpegArenaAllocate, JpegArenaFree, &arena },
+		previous(jpeg_set_memory_hooks(&hooks))
+	{
+	}
+	JpegMemoryScope(const JpegMemoryScope&) = delete;
+	JpegMemoryScope& operator= (const JpegMemoryScope&) = delete;
 
-	Size size = Size(pGif->width, pGif->height);
-	gd_close_gif(pGif);
+	~JpegMemoryScope()
+	{
+		jpeg_set_memory_hooks(previous);
+	}
+
+private:
+	jpeg_memory_hooks hooks;
+	const jpeg_memory_hooks* previous;
+};
+
+static rave::Result ReadMappedImage(const char* filename, rave::ImageFormat format, std::vector<rave::Color>& data, unsigned int* pWidth, unsigned int* pHeight, const rave::DecodeOptions& options = {})
+{
+	rave::FileMapping file;
+	auto result = file.Open(filename);
+	if (result.Failed())
+		return result;
 
-	return size;
+	return rave::ReadImage(file.Data(), file.Size(), format, data, pWidth, pHeight, options);
 }
-rave::OptionalResult<rave::Size> rave::ImageSizeBMP(const char* filename)
+
+static rave::Result ReadMappedImageRaw(const char* filename, rave::ImageFormat format, rave::Color* data, const rave::DecodeOptions& options = {})
 {
-	BMPFileHeader file_header;
-	BMPInfoHeader bmp_info_header;
-	BMPColorHeader bmp_color_header;
+	rave::FileMapping file;
+	auto result = file.Open(filename);
+	if (result.Failed())
+		return result;
 
-	std::ifstream inp{ filename, std::ios_base::binary };
-	if (!inp)
-		RETURN_FNF();
+	return rave::ReadImageRaw(file.Data(), file.Size(), format, data, options);
+}
 
-	inp.read((char*)&file_header, sizeof(file_header));
-	if (file_header.file_type != 0x4D42)
+static rave::OptionalResult<rave::Size> MappedImageSize(const char* filename, rave::ImageFormat format)
+{
+	rave::FileMapping file;
+	auto result = file.Open(filename);
+	if (result.Failed())
+		return result;
+
+	return rave::ImageSize(file.Data(), file.Size(), format);
+}
+
+static rave::Size ScaledJpegSize(const rave::Size& size, unsigned int eighths)
+{
+	// Same rounding as jpeg_calc_output_dimensions
+	return rave::Size((size.x * eighths + 7) / 8, (size.y * eighths + 7) / 8);
+}
+
+// The scale libjpeg should decode at, in eighths
+static unsigned int JpegScale(const rave::Size& size, const rave::DecodeOptions& options)
+{
+	// Clamped while still a float, converting a negative or NaN scale to unsigned is undefined
+	const float scale = std::isfinite(options.scale) && options.scale > 0.0f ? std::min(options.scale, 1.0f) : 1.0f;
+	unsigned int eighths = std::clamp((unsigned int)std::ceil(scale * 8.0f), 1u, 8u);
+
+	auto fits = [&options](const rave::Size& scaled)
 	{
+		return (options.maxSize.x == 0 || scaled.x <= options.maxSize.x) && (options.maxSize.y == 0 || scaled.y <= options.maxSize.y);
+	};
+	while (eighths > 1 && !fits(ScaledJpegSize(size, eighths)))
+		eighths--;
+
+	return eighths;
+}
+
+static uint32_t ReadBigEndian32(const unsigned char* p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static uint16_t ReadBigEndian16(const unsigned char* p)
+{
+	return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint16_t ReadLittleEndian16(const unsigned char* p)
+{
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static rave::OptionalResult<rave::ImageInfo> ProbePNG(const unsigned char* bytes, size_t length)
+{
+	static constexpr unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+	// Signature followed by the IHDR chunk, which must come first
+	if (length < 33 || memcmp(bytes, signature, sizeof(signature)) != 0 || memcmp(bytes + 12, "IHDR", 4) != 0)
 		RETURN_ERROR(L"Unrecognized file format");
+
+	rave::ImageInfo info;
+	info.format = rave::ImageFormat::PNG;
+	info.size = rave::Size(ReadBigEndian32(bytes + 16), ReadBigEndian32(bytes + 20));
+	info.bitDepth = bytes[24];
+	info.frameCount = 1;
+
+	switch (bytes[25])
+	{
+		case PNG_COLOR_TYPE_GRAY:		info.channels = 1; break;
+		case PNG_COLOR_TYPE_GRAY_ALPHA:	info.channels = 2; break;
+		case PNG_COLOR_TYPE_RGB:		info.channels = 3; break;
+		case PNG_COLOR_TYPE_PALETTE:	info.channels = 3; break;
+		case PNG_COLOR_TYPE_RGB_ALPHA:	info.channels = 4; break;
+		default: RETURN_ERROR(L"Unrecognized png color type");
 	}
-	inp.read((char*)&bmp_info_header, sizeof(bmp_info_header));
 
-	return Size(bmp_info_header.width, bmp_info_header.height);
+	// Walk the chunk headers up to the image data, looking for transparency and animation info
+	size_t offset = 33;
+	while (offset + 8 <= length)
+	{
+		const uint32_t chunkLength = ReadBigEndian32(bytes + offset);
+		const unsigned char* type = bytes + offset + 4;
+
+		if (memcmp(type, "IDAT", 4) == 0 || memcmp(type, "IEND", 4) == 0)
+			break;
+		if (memcmp(type, "tRNS", 4) == 0 && (info.channels == 1 || info.channels == 3))
+			info.channels++;
+		if (memcmp(type, "acTL", 4) == 0 && chunkLength >= 8 && offset + 12 <= length)
+			info.frameCount = ReadBigEndian32(bytes + offset + 8);
+
+		// Length, type, data and crc
+		offset += (size_t)chunkLength + 12;
+	}
+
+	return info;
 }
-rave::OptionalResult<rave::Size> rave::ImageSizePNG(const char* filename)
+
+// Offset of the frame header just past its marker, where the segment length is, or 0 when there is none before the first scan
+static size_t FindJpegFrameHeader(const unsigned char* bytes, size_t length)
 {
-	FILE* fp = fopen(filename, "rb");
+	// Skip from marker segment to marker segment until a start of frame
+	size_t offset = 2;
+	while (offset + 4 <= length)
+	{
+		if (bytes[offset] != 0xFF)
+			return 0;
 
-	png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-	if (!png) RETURN_FNF();
+		const unsigned char marker = bytes[offset + 1];
+		offset += 2;
 
-	png_infop info = png_create_info_struct(png);
-	if (!info) { png_destroy_read_struct(&png, NULL, NULL); fclose(fp); rave_bail_png(); }
+		// Fill bytes and markers without a payload
+		if (marker == 0xFF)
+		{
+			offset--;
+			continue;
+		}
+		if (marker == 0x01 || marker == 0xD8 || (marker >= 0xD0 && marker <= 0xD7))
+			continue;
+		if (marker == 0xD9 || marker == 0xDA)
+			return 0;
 
-	if (setjmp(png_jmpbuf(png))) { png_destroy_read_struct(&png, NULL, NULL); fclose(fp); rave_bail_png(); }
+		const uint16_t segmentLength = ReadBigEndian16(bytes + offset);
 
-	png_init_io(png, fp);
+		// SOF0-SOF15, except DHT, JPG and DAC which share the range
+		if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+			return segmentLength >= 8 && offset + 8 <= length ? offset : 0;
 
-	png_read_info(png, info);
+		offset += segmentLength;
+	}
+	return 0;
+}
 
-	unsigned int width = png_get_image_width(png, info);
-	unsigned int height = png_get_image_height(png, info);
+static rave::OptionalResult<rave::ImageInfo> ProbeJPEG(const unsigned char* bytes, size_t length)
+{
+	if (length < 4 || bytes[0] != 0xFF || bytes[1] != 0xD8)
+		RETURN_ERROR(L"Unrecognized file format");
 
-	fclose(fp);
-	png_destroy_read_struct(&png, &info, NULL);
+	const size_t offset = FindJpegFrameHeader(bytes, length);
+	if (offset == 0)
+		RETURN_ERROR(L"No frame header found in jpeg data");
+
+	rave::ImageInfo info;
+	info.format = rave::ImageFormat::JPEG;
+	info.bitDepth = bytes[offset + 2];
+	info.size = rave::Size(ReadBigEndian16(bytes + offset + 5), ReadBigEndian16(bytes + offset + 3));
+	info.channels = bytes[offset + 7];
+	info.frameCount = 1;
+	return info;
+}
+
+static rave::OptionalResult<rave::ImageInfo> ProbeBMP(const unsigned char* bytes, size_t length)
+{
+	BMPFileHeader file_header;
+	BMPInfoHeader bmp_info_header;
 
-	return Size(width, height);
+	if (length < sizeof(file_header) + sizeof(bmp_info_header))
+		RETURN_ERROR(L"Unrecognized file format");
+
+	memcpy(&file_header, bytes, sizeof(file_header));
+	if (file_header.file_type != 0x4D42)
+		RETURN_ERROR(L"Unrecognized file format");
+	memcpy(&bmp_info_header, bytes + sizeof(file_header), sizeof(bmp_info_header));
+
+	rave::ImageInfo info;
+	info.format = rave::ImageFormat::BMP;
+	info.size = rave::Size(abs(bmp_info_header.width), abs(bmp_info_header.height));
+	info.bitDepth = bmp_info_header.bit_count;
+	info.channels = bmp_info_header.bit_count == 32 ? 4 : 3;
+	info.frameCount = 1;
+	return info;
 }
-rave::OptionalResult<rave::Size> rave::ImageSizeJPEG(const char* filename)
+
+static void SkipGIFSubBlocks(const unsigned char* bytes, size_t length, size_t& offset)
 {
-	jpeg_decompress_struct cinfo;
-	JpegErrorManager errorManager;
+	while (offset < length)
+	{
+		const unsigned char size = bytes[offset++];
+		if (size == 0)
+			return;
+		offset += size;
+	}
+}
 
-	FILE* pFile = fopen(filename, "rb");
-	if (!pFile)
-		RETURN_FNF();
+static rave::OptionalResult<rave::ImageInfo> ProbeGIF(const unsigned char* bytes, size_t length)
+{
+	if (length < 13 || (memcmp(bytes, "GIF87a", 6) != 0 && memcmp(bytes, "GIF89a", 6) != 0))
+		RETURN_ERROR(L"Unrecognized file format");
 
-	// set our custom error handler
-	cinfo.err = jpeg_std_error(&errorManager.defaultErrorManager);
-	errorManager.defaultErrorManager.error_exit = JpegErrorExit;
-	errorManager.defaultErrorManager.output_message = JpegOutputMessage;
-	if (setjmp(errorManager.jumpBuffer))
+	// Logical screen descriptor
+	const unsigned char flags = bytes[10];
+
+	rave::ImageInfo info;
+	info.format = rave::ImageFormat::GIF;
+	info.size = rave::Size(ReadLittleEndian16(bytes + 6), ReadLittleEndian16(bytes + 8));
+	info.bitDepth = (flags & 0x07) + 1;
+	info.channels = 3;
+
+	size_t offset = 13;
+	if (flags & 0x80)
+		offset += 3 * ((size_t)1 << info.bitDepth);
+
+	// Count the image descriptors, skipping their data without decoding it
+	while (offset < length)
 	{
-		// We jump here on errors
-		jpeg_destroy_decompress(&cinfo);
-		fclose(pFile);
-		RETURN_ERROR(L"Error occurred trying to read jpeg file");
+		const unsigned char separator = bytes[offset++];
+		if (separator == 0x2C)
+		{
+			if (offset + 9 > length)
+				break;
+			const unsigned char descriptorFlags = bytes[offset + 8];
+			offset += 9;
+			if (descriptorFlags & 0x80)
+				offset += 3 * ((size_t)1 << ((descriptorFlags & 0x07) + 1));
+			// LZW minimum code size
+			offset++;
+			SkipGIFSubBlocks(bytes, length, offset);
+			info.frameCount++;
+		}
+		else if (separator == 0x21)
+		{
+			if (offset + 1 > length)
+				break;
+			const unsigned char label = bytes[offset++];
+			// Graphic control extension with the transparency flag set
+			if (label == 0xF9 && offset + 2 <= length && (bytes[offset + 1] & 0x01))
+				info.channels = 4;
+			SkipGIFSubBlocks(bytes, length, offset);
+		}
+		else
+		{
+			break;
+		}
 	}
 
-	jpeg_create_decompress(&cinfo);
-	jpeg_stdio_src(&cinfo, pFile);
-	jpeg_read_header(&cinfo, TRUE);
-	jpeg_start_decompress(&cinfo);
+	return info;
+}
 
-	unsigned int width = cinfo.image_width;
-	unsigned int height = cinfo.image_height;
+static bool IsKTX2RGBA8(uint32_t vkFormat)
+{
+	// VK_FORMAT_R8G8B8A8_UNORM and VK_FORMAT_R8G8B8A8_SRGB
+	return vkFormat == 37 || vkFormat == 43;
+}
 
-	jpeg_finish_decompress(&cinfo);
-	jpeg_destroy_decompress(&cinfo);
-	fclose(pFile);
+static rave::OptionalResult<rave::ImageInfo> ProbeKTX2(const unsigned char* bytes, size_t length)
+{
+	// Opening only reads the header and level index
+	rave::KtxFile file;
+	auto result = file.Open(bytes, length);
+	if (result.Failed())
+		return result;
+
+	rave::ImageInfo info;
+	info.format = rave::ImageFormat::KTX2;
+	info.size = file.GetSize();
+	info.channels = IsKTX2RGBA8(file.GetVkFormat()) ? 4 : 0;
+	info.bitDepth = IsKTX2RGBA8(file.GetVkFormat()) ? 8 : 0;
+	info.frameCount = file.GetLayerCount() * file.GetFaceCount();
+	return info;
+}
 
-	return Size(width, height);
+// QOI ops, the two 8 bit tags take precedence over the 2 bit ones
+static constexpr unsigned char qoiOpIndex = 0x00;
+static constexpr unsigned char qoiOpDiff  = 0x40;
+static constexpr unsigned char qoiOpLuma  = 0x80;
+static constexpr unsigned char qoiOpRun   = 0xC0;
+static constexpr unsigned char qoiOpRGB   = 0xFE;
+static constexpr unsigned char qoiOpRGBA  = 0xFF;
+static constexpr size_t qoiHeaderLength = 14;
+static constexpr unsigned char qoiPadding[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+static unsigned int QoiHash(const unsigned char* pixel)
+{
+	return (pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11) & 63;
 }
-rave::OptionalResult<rave::Size> rave::ImageSize(std::string_view filename)
+
+static rave::OptionalResult<rave::ImageInfo> ProbeQOI(const unsigned char* bytes, size_t length)
+{
+	if (length < qoiHeaderLength + sizeof(qoiPadding) || memcmp(bytes, "qoif", 4) != 0)
+		RETURN_ERROR(L"Unrecognized file format");
+
+	const unsigned int width  = ((unsigned int)bytes[4] << 24) | ((unsigned int)bytes[5] << 16) | ((unsigned int)bytes[6]  << 8) | bytes[7];
+	const unsigned int height = ((unsigned int)bytes[8] << 24) | ((unsigned int)bytes[9] << 16) | ((unsigned int)bytes[10] << 8) | bytes[11];
+	if (width == 0 || height == 0 || (bytes[12] != 3 && bytes[12] != 4) || bytes[13] > 1)
+		RETURN_ERROR(L"Invalid QOI header");
+
+	rave::ImageInfo info;
+	info.format = rave::ImageFormat::QOI;
+	info.size = rave::Size(width, height);
+	info.channels = bytes[12];
+	info.bitDepth = 8;
+	info.frameCount = 1;
+	return info;
+}
+
+rave::DecodeOptions rave::DecodeOptions::Accurate() noexcept
+{
+	return DecodeOptions();
+}
+
+rave::DecodeOptions rave::DecodeOptions::Trusted() noexcept
+{
+	DecodeOptions options;
+	options.verifyChecksums = false;
+	return options;
+}
+
+rave::DecodeOptions rave::DecodeOptions::FastPreview() noexcept
+{
+	DecodeOptions options;
+	options.dctMethod = JDCT_IFAST;
+	options.fancyUpsampling = false;
+	options.blockSmoothing = false;
+	options.verifyChecksums = false;
+	return options;
+}
+
+rave::ImageFormat rave::ImageFormatFromExtension(std::string_view filename)
 {
 	size_t dotpos = filename.rfind('.');
 	if (dotpos == filename.npos)
-		RETURN_ERROR(L"Invalid file name");
-	std::string_view formatstr = filename.substr(dotpos);
-
-	if (!FileExists(filename.data()))
-		RETURN_FNF();
+		return ImageFormat::Unknown;
 
-	switch (HashString(formatstr.data()))
+	switch (HashString(filename.substr(dotpos)))
 	{
-		case HashString(".png"):  return ImageSizePNG(filename.data());
-		case HashString(".bmp"):  return ImageSizeBMP(filename.data());
+		case HashString(".png"):  return ImageFormat::PNG;
+		case HashString(".bmp"):  return ImageFormat::BMP;
 		case HashString(".jpg"):
 		case HashString(".jpe"):
-		case HashString(".jpeg"): return ImageSizeJPEG(filename.data());
-		case HashString(".gif"):  return ImageSizeGIF(filename.data());
+		case HashString(".jpeg"): return ImageFormat::JPEG;
+		case HashString(".gif"):  return ImageFormat::GIF;
+		case HashString(".ktx2"): return ImageFormat::KTX2;
+		case HashString(".qoi"):  return ImageFormat::QOI;
 
-		default: RETURN_ERROR( L"File format not recognised" );
+		default: return ImageFormat::Unknown;
 	}
 }
 
-rave::Result rave::ReadGIFRaw(const char* filename, Color* data, unsigned int frame)
+rave::ImageFormat rave::DetectImageFormat(const void* bytes, size_t length)
 {
-	gd_GIF* pGif = gd_open_gif(filename);
-	if (!pGif)
-		RETURN_FNF();
+	const unsigned char* pBytes = static_cast<const unsigned char*>(bytes);
+
+	if (length >= 8 && memcmp(pBytes, "\x89PNG\r\n\x1A\n", 8) == 0)
+		return ImageFormat::PNG;
+	if (length >= 3 && pBytes[0] == 0xFF && pBytes[1] == 0xD8 && pBytes[2] == 0xFF)
+		return ImageFormat::JPEG;
+	if (length >= 4 && memcmp(pBytes, "GIF8", 4) == 0)
+		return ImageFormat::GIF;
+	if (length >= 2 && pBytes[0] == 'B' && pBytes[1] == 'M')
+		return ImageFormat::BMP;
+	if (length >= 12 && memcmp(pBytes, "\xABKTX 20\xBB\r\n\x1A\n", 12) == 0)
+		return ImageFormat::KTX2;
+	if (length >= 4 && memcmp(pBytes, "qoif", 4) == 0)
+		return ImageFormat::QOI;
+
+	return ImageFormat::Unknown;
+}
 
-	std::vector<ColorRGB> intermediate((size_t)pGif->width * (size_t)pGif->height);
+rave::OptionalResult<rave::ImageInfo> rave::ProbeImage(const void* bytes, size_t length, ImageFormat format)
+{
+	const unsigned char* pBytes = static_cast<const unsigned char*>(bytes);
 
-	for (unsigned int i = 0; i < frame + 1 && gd_get_frame(pGif); i++);
+	if (format == ImageFormat::Unknown)
+		format = DetectImageFormat(bytes, length);
 
-	gd_render_frame(pGif, reinterpret_cast<unsigned char*>(intermediate.data()));
-	for (const auto& color : intermediate)
+	switch (format)
 	{
-		data->r = color.r;
-		data->g = color.g;
-		data->b = color.b;
-		data->a = gd_is_bgcolor(pGif, reinterpret_cast<const unsigned char*>(&color)) ? 0 : 255;
+		case ImageFormat::PNG:  return ProbePNG (pBytes, length);
+		case ImageFormat::BMP:  return ProbeBMP (pBytes, length);
+		case ImageFormat::JPEG: return ProbeJPEG(pBytes, length);
+		case ImageFormat::GIF:  return ProbeGIF (pBytes, length);
+		case ImageFormat::KTX2: return ProbeKTX2(pBytes, length);
+		case ImageFormat::QOI:  return ProbeQOI (pBytes, length);
 
-		data++;
+		default: RETURN_ERROR( L"File format not recognised" );
 	}
+}
 
-	gd_close_gif(pGif);
+rave::OptionalResult<rave::ImageInfo> rave::ProbeImage(std::string_view filename)
+{
+	// Mapping is lazy, so only the pages holding the headers are actually read
+	FileMapping file;
+	auto result = file.Open(std::string(filename).c_str());
+	if (result.Failed())
+		return result;
+
+	return ProbeImage(file.Data(), file.Size(), ImageFormat::Unknown);
+}
+
+std::vector<rave::OptionalResult<rave::ImageInfo>> rave::ProbeImages(array_view<const char* const> filenames)
+{
+	std::vector<OptionalResult<ImageInfo>> infos;
+	infos.reserve(filenames.size());
+
+	for (const char* filename : filenames)
+		infos.push_back(ProbeImage(filename));
+
+	return infos;
+}
+
+rave::Result rave::ReadImage(std::string_view filename, std::vector<Color>& data, unsigned int* pWidth, unsigned int* pHeight, const DecodeOptions& options)
+{
+	return ReadMappedImage(std::string(filename).c_str(), ImageFormat::Unknown, data, pWidth, pHeight, options);
+}
+
+rave::Result rave::ReadImage(const void* bytes, size_t length, std::vector<Color>& data, unsigned int* pWidth, unsigned int* pHeight, const DecodeOptions& options)
+{
+	return ReadImage(bytes, length, ImageFormat::Unknown, data, pWidth, pHeight, options);
+}
+
+rave::Result rave::ReadImage(const void* bytes, size_t length, ImageFormat format, std::vector<Color>& data, unsigned int* pWidth, unsigned int* pHeight, const DecodeOptions& options)
+{
+	if (format == ImageFormat::Unknown)
+		format = DetectImageFormat(bytes, length);
+
+	auto imgSize = ImageSize(bytes, length, format, options);
+	if (imgSize.GetResult().Failed())
+		return imgSize.GetResult();
+
+	const Size size = imgSize.Get();
+	data.resize((size_t)size.x * (size_t)size.y);
+
+	auto result = ReadImageRaw(bytes, length, format, data.data(), options);
+	if (result.Failed())
+		return result;
+
+	if (pWidth)
+		*pWidth = size.x;
+	if (pHeight)
+		*pHeight = size.y;
 
 	return RE_SUCCESS;
 }
+
+rave::OptionalResult<rave::Size> rave::ImageSizeGIF(const char* filename)
+{
+	return MappedImageSize(filename, ImageFormat::GIF);
+}
+rave::OptionalResult<rave::Size> rave::ImageSizeBMP(const char* filename)
+{
+	return MappedImageSize(filename, ImageFormat::BMP);
+}
+rave::OptionalResult<rave::Size> rave::ImageSizePNG(const char* filename)
+{
+	return MappedImageSize(filename, ImageFormat::PNG);
+}
+rave::OptionalResult<rave::Size> rave::ImageSizeJPEG(const char* filename)
+{
+	return MappedImageSize(filename, ImageFormat::JPEG);
+}
+rave::OptionalResult<rave::Size> rave::ImageSizeQOI(const char* filename)
+{
+	return MappedImageSize(filename, ImageFormat::QOI);
+}
+rave::OptionalResult<rave::Size> rave::ImageSize(std::string_view filename)
+{
+	return MappedImageSize(std::string(filename).c_str(), ImageFormat::Unknown);
+}
+
+rave::OptionalResult<rave::Size> rave::ImageSizeGIF(const void* bytes, size_t length)
+{
+	return ImageSize(bytes, length, ImageFormat::GIF);
+}
+rave::OptionalResult<rave::Size> rave::ImageSizeBMP(const void* bytes, size_t length)
+{
+	return ImageSize(bytes, length, ImageFormat::BMP);
+}
+rave::OptionalResult<rave::Size> rave::ImageSizePNG(const void* bytes, size_t length)
+{
+	return ImageSize(bytes, length, ImageFormat::PNG);
+}
+rave::OptionalResult<rave::Size> rave::ImageSizeJPEG(const void* bytes, size_t length, const DecodeOptions& options)
+{
+	return ImageSize(bytes, length, ImageFormat::JPEG, options);
+}
+rave::OptionalResult<rave::Size> rave::ImageSizeQOI(const void* bytes, size_t length)
+{
+	return ImageSize(bytes, length, ImageFormat::QOI);
+}
+rave::OptionalResult<rave::Size> rave::ImageSize(const void* bytes, size_t length, ImageFormat format, const DecodeOptions& options)
+{
+	auto info = ProbeImage(bytes, length, format);
+	if (info.GetResult().Failed())
+		return info.GetResult();
+
+	if (info.Get().format == ImageFormat::JPEG)
+		return ScaledJpegSize(info.Get().size, JpegScale(info.Get().size, options));
+
+	return info.Get().size;
+}
+
+rave::Result rave::ReadGIFRaw(const char* filename, Color* data, unsigned int frame)
+{
+	FileMapping file;
+	auto result = file.Open(filename);
+	if (result.Failed())
+		return result;
+
+	return ReadGIFRaw(file.Data(), file.Size(), data, frame);
+}
 rave::Result rave::ReadBMPRaw(const char* filename, Color* data)
 {
-	std::ifstream inp{ filename, std::ios_base::binary };
-	if (inp)
-	{
-		BMPFileHeader file_header;
-		BMPInfoHeader bmp_info_header;
-		BMPColorHeader bmp_color_header;
+	return ReadMappedImageRaw(filename, ImageFormat::BMP, data);
+}
+rave::Result rave::ReadPNGRaw(const char* filename, Color* data, const DecodeOptions& options)
+{
+	return ReadMappedImageRaw(filename, ImageFormat::PNG, data, options);
+}
+rave::Result rave::ReadJPEGRaw(const char* filename, Color* data, const DecodeOptions& options)
+{
+	return ReadMappedImageRaw(filename, ImageFormat::JPEG, data, options);
+}
+rave::Result rave::ReadQOIRaw(const char* filename, Color* data)
+{
+	return ReadMappedImageRaw(filename, ImageFormat::QOI, data);
+}
+rave::Result rave::ReadImageRaw(std::string_view filename, Color* data, const DecodeOptions& options)
+{
+	return ReadMappedImageRaw(std::string(filename).c_str(), ImageFormat::Unknown, data, options);
+}
 
-		inp.read((char*)&file_header, sizeof(file_header));
-		if (file_header.file_type != 0x4D42)
-		{
-			RETURN_ERROR(L"Unrecognized file format");
-		}
-		inp.read((char*)&bmp_info_header, sizeof(bmp_info_header));
+rave::Result rave::ReadGIFRaw(const void* bytes, size_t length, Color* data, unsigned int frame)
+{
+	gd_GIF* pGif = gd_open_gif_memory(bytes, length);
+	if (!pGif)
+		RETURN_ERROR(L"Unrecognized file format");
 
-		// The BMPColorHeader is used only for transparent images
-		if (bmp_info_header.bit_count == 32)
-		{
-			// Check if the file has bit mask color information
-			if (bmp_info_header.size >= (sizeof(BMPInfoHeader) + sizeof(BMPColorHeader)))
-			{
-				inp.read((char*)&bmp_color_header, sizeof(bmp_color_header));
-				// Check if the pixel data is stored as BGRA and if the color space type is sRGB
-				check_color_header(bmp_color_header);
-			}
-			else
-			{
-				RETURN_ERROR(L"Unrecognized file format");
-			}
-		}
+	const size_t pixelCount = (size_t)pGif->width * (size_t)pGif->height;
 
-		// Jump to the pixel data location
-		inp.seekg(file_header.offset_data, inp.beg);
+	for (unsigned int i = 0; i < frame + 1 && gd_get_frame(pGif); i++);
 
-		// Adjust the header fields for output.
-		// Some editors will put extra info in the image file, we only save the headers and the data.
-		if (bmp_info_header.bit_count == 32)
-		{
-			bmp_info_header.size = sizeof(BMPInfoHeader) + sizeof(BMPColorHeader);
-			file_header.offset_data = sizeof(BMPFileHeader) + sizeof(BMPInfoHeader) + sizeof(BMPColorHeader);
-		}
-		else
-		{
-			bmp_info_header.size = sizeof(BMPInfoHeader);
-			file_header.offset_data = sizeof(BMPFileHeader) + sizeof(BMPInfoHeader);
-		}
-		file_header.file_size = file_header.offset_data;
+	// Render the RGB frame into the last 3/4 of the output and expand it in place
+	unsigned char* rgb = reinterpret_cast<unsigned char*>(data) + pixelCount;
+	gd_render_frame(pGif, rgb);
 
-		if (bmp_info_header.height < 0)
-		{
-			RETURN_ERROR(L"The program can treat only BMP images with the origin in the bottom left corner!");
-		}
+	const unsigned char* bg = &pGif->palette->colors[pGif->bgindex * 3];
+	ConvertRGBToRGBAKeyed(rgb, data, pixelCount, Color(bg[0], bg[1], bg[2]));
 
-		// Here we check if we need to take into account row padding
-		if (bmp_info_header.bit_count == 32)
-		{
-			if (bmp_info_header.width % 4 == 0)
-			{
-				unsigned int row_stride = (unsigned int)bmp_info_header.width * (unsigned int)bmp_info_header.bit_count / 8;
+	gd_close_gif(pGif);
 
-				for (int y = bmp_info_header.height - 1; y >= 0; --y)
-				{
-					inp.read((char*)(&data[(size_t)bmp_info_header.width * (size_t)y]), row_stride);
-				}
-			}
-			else
-			{
-				unsigned int row_stride = (unsigned int)bmp_info_header.width * (unsigned int)bmp_info_header.bit_count / 8;
-				uint32_t new_stride = make_stride_aligned(4, row_stride);
-				std::vector<uint8_t> padding_row(new_stride - row_stride);
+	return RE_SUCCESS;
+}
+rave::Result rave::ReadBMPRaw(const void* bytes, size_t length, Color* data)
+{
+	const unsigned char* pBytes = static_cast<const unsigned char*>(bytes);
 
-				for (int y = bmp_info_header.height - 1; y >= 0; --y)
-				{
-					inp.read((char*)(&data[(size_t)bmp_info_header.width * (size_t)y]), row_stride);
-					inp.read((char*)padding_row.data(), padding_row.size());
-				}
-			}
-			for (int i = 0; i < bmp_info_header.width * bmp_info_header.height; i++)
-			{
-				const auto temp = data[i];
-				data[i].r = temp.b;
-				data[i].b = temp.r;
-			}
-		}
-		else
-		{
-			std::vector<ColorRGB> intermed((size_t)bmp_info_header.width * (size_t)bmp_info_header.height);
-			if (bmp_info_header.width % 4 == 0)
-			{
-				unsigned int row_stride = (unsigned int)bmp_info_header.width * (unsigned int)bmp_info_header.bit_count / 8;
+	BMPFileHeader file_header;
+	BMPInfoHeader bmp_info_header;
+	BMPColorHeader bmp_color_header;
 
-				for (int y = bmp_info_header.height - 1; y >= 0; --y)
-				{
-					inp.read((char*)(&intermed[(size_t)bmp_info_header.width * (size_t)y]), row_stride);
-				}
-			}
-			else
-			{
-				unsigned int row_stride = (unsigned int)bmp_info_header.width * (unsigned int)bmp_info_header.bit_count / 8;
-				uint32_t new_stride = make_stride_aligned(4, row_stride);
-				std::vector<uint8_t> padding_row(new_stride - row_stride);
+	if (length < sizeof(file_header) + sizeof(bmp_info_header))
+		RETURN_ERROR(L"Unrecognized file format");
 
-				for (int y = bmp_info_header.height - 1; y >= 0; --y)
-				{
-					inp.read((char*)(&data[(size_t)bmp_info_header.width * (size_t)y]), row_stride);
-					inp.read((char*)padding_row.data(), padding_row.size());
-				}
-			}
-			for (const auto& color : intermed)
-			{
-				data->r = color.b;
-				data->g = color.g;
-				data->b = color.r;
-				data->a = 255;
+	memcpy(&file_header, pBytes, sizeof(file_header));
+	if (file_header.file_type != 0x4D42)
+	{
+		RETURN_ERROR(L"Unrecognized file format");
+	}
+	memcpy(&bmp_info_header, pBytes + sizeof(file_header), sizeof(bmp_info_header));
 
-				data++;
-			}
+	// The BMPColorHeader is used only for transparent images
+	if (bmp_info_header.bit_count == 32)
+	{
+		// Check if the file has bit mask color information
+		if (bmp_info_header.size >= (sizeof(BMPInfoHeader) + sizeof(BMPColorHeader)) &&
+			length >= sizeof(file_header) + sizeof(bmp_info_header) + sizeof(bmp_color_header))
+		{
+			memcpy(&bmp_color_header, pBytes + sizeof(file_header) + sizeof(bmp_info_header), sizeof(bmp_color_header));
+			// Check if the pixel data is stored as BGRA and if the color space type is sRGB
+			check_color_header(bmp_color_header);
+		}
+		else
+		{
+			RETURN_ERROR(L"Unrecognized file format");
 		}
+	}
+	else if (bmp_info_header.bit_count != 24)
+	{
+		RETURN_ERROR(L"Only 24 and 32 bit BMP images are supported");
+	}
 
-		return RE_SUCCESS;
+	if (bmp_info_header.height < 0)
+	{
+		RETURN_ERROR(L"The program can treat only BMP images with the origin in the bottom left corner!");
 	}
-	else
+
+	const size_t width = (size_t)bmp_info_header.width;
+	const size_t height = (size_t)bmp_info_header.height;
+	const size_t row_stride = width * bmp_info_header.bit_count / 8;
+	const size_t padded_stride = make_stride_aligned(4, (uint32_t)row_stride);
+
+	// Rows are padded to 4 bytes, except that the last one doesn't need its padding to be present
+	if (height > 0 && (file_header.offset_data > length || (length - file_header.offset_data) < padded_stride * (height - 1) + row_stride))
+	{
+		RETURN_ERROR(L"BMP pixel data is truncated");
+	}
+
+	// Rows are stored bottom-up
+	for (size_t y = 0; y < height; y++)
 	{
-		RETURN_FNF();
+		const unsigned char* src = pBytes + file_header.offset_data + (height - 1 - y) * padded_stride;
+		Color* dst = data + width * y;
+
+		if (bmp_info_header.bit_count == 32)
+			ConvertBGRAToRGBA(src, dst, width);
+		else
+			ConvertBGRToRGBA(src, dst, width);
 	}
+
+	return RE_SUCCESS;
 }
-rave::Result rave::ReadPNGRaw(const char* filename, Color* data)
+rave::Result rave::ReadPNGRaw(const void* bytes, size_t length, Color* data, const DecodeOptions& options)
 {
-	FILE* fp = fopen(filename, "rb");
+	PngMemoryReader reader = { static_cast<const png_byte*>(bytes), length, 0 };
+	DecoderScope scope;
+	rave::Arena& arena = scope.GetArena();
 
-	png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-	if (!png) RETURN_FNF();
+	png_structp png = png_create_read_struct_2(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL, &arena, PngArenaAllocate, PngArenaFree);
+	if (!png) RETURN_PNG_FAIL();
 
 	png_infop info = png_create_info_struct(png);
-	if (!info) { png_destroy_read_struct(&png, NULL, NULL); fclose(fp); rave_bail_png(); }
+	if (!info) { png_destroy_read_struct(&png, NULL, NULL); RETURN_PNG_FAIL(); }
+
+	if (setjmp(png_jmpbuf(png))) { png_destroy_read_struct(&png, &info, NULL); RETURN_PNG_FAIL(); }
 
-	if (setjmp(png_jmpbuf(png))) { png_destroy_read_struct(&png, NULL, NULL); fclose(fp); rave_bail_png(); }
+	png_set_read_fn(png, &reader, PngReadMemory);
 
-	png_init_io(png, fp);
+	if (!options.verifyChecksums)
+	{
+		// QUIET_USE skips computing the CRCs, not only the check. Adler32 is a separate option
+		png_set_crc_action(png, PNG_CRC_QUIET_USE, PNG_CRC_QUIET_USE);
+		png_set_option(png, PNG_IGNORE_ADLER32, PNG_OPTION_ON);
+	}
 
 	png_read_info(png, info);
 
@@ -434,411 +890,516 @@ rave::Result rave::ReadPNGRaw(const char* filename, Color* data)
 		color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
 		png_set_gray_to_rgb(png);
 
+	png_set_interlace_handling(png);
+
 	png_read_update_info(png, info);
 
-	std::vector<png_bytep> row_pointers(height);
+	png_bytep* row_pointers = static_cast<png_bytep*>(arena.Allocate(sizeof(png_bytep) * height));
+	if (!row_pointers) { png_destroy_read_struct(&png, &info, NULL); RETURN_PNG_FAIL(); }
 	for (unsigned int y = 0; y < height; y++)
 	{
 		row_pointers[y] = reinterpret_cast<png_bytep>(&data[(size_t)y * (size_t)width]);
 	}
 
-	png_read_image(png, row_pointers.data());
-	fclose(fp);
+	png_read_image(png, row_pointers);
 	png_destroy_read_struct(&png, &info, NULL);
 
 	return RE_SUCCESS;
 }
-rave::Result rave::ReadJPEGRaw(const char* filename, Color* data)
+static void InitJpegErrors(jpeg_decompress_struct& cinfo, JpegErrorManager& errorManager)
 {
-	jpeg_decompress_struct cinfo;
-	JpegErrorManager errorManager;
-
-	FILE* pFile = fopen(filename, "rb");
-	if (!pFile)
-		RETURN_FNF();
-
-	// set our custom error handler
 	cinfo.err = jpeg_std_error(&errorManager.defaultErrorManager);
-	errorManager.defaultErrorManager.error_exit = JpegErrorExit;
-	errorManager.defaultErrorManager.output_message = JpegOutputMessage;
-	if (setjmp(errorManager.jumpBuffer))
-	{
-		// We jump here on errors
-		jpeg_destroy_decompress(&cinfo);
-		fclose(pFile);
-		RETURN_ERROR(L"Error occurred trying to read jpeg file");
-	}
+	errorManager.defaultErrorManager.error_exit = rave::JpegErrorExit;
+	errorManager.defaultErrorManager.output_message = rave::JpegOutputMessage;
+}
 
-	jpeg_create_decompress(&cinfo);
-	jpeg_stdio_src(&cinfo, pFile);
-	jpeg_read_header(&cinfo, TRUE);
+static void ConfigureJpegDecode(jpeg_decompress_struct& cinfo, const rave::DecodeOptions& options, unsigned int eighths)
+{
+	// Grayscale is expanded to RGB by libjpeg, so every 3 component image arrives as packed RGB
+	if (cinfo.num_components != 4)
+		cinfo.out_color_space = JCS_RGB;
+
+	// Scaling happens in the IDCT, so a smaller output is also a faster decode
+	cinfo.scale_num = eighths;
+	cinfo.scale_denom = 8;
+	cinfo.dct_method = options.dctMethod;
+	cinfo.do_fancy_upsampling = options.fancyUpsampling ? TRUE : FALSE;
+	cinfo.do_block_smoothing = options.blockSmoothing ? TRUE : FALSE;
+}
+
+static void ReadJpegScanlines(jpeg_decompress_struct& cinfo, rave::Color* data)
+{
 	jpeg_start_decompress(&cinfo);
 
-	unsigned int width = cinfo.image_width;
-	unsigned int height = cinfo.image_height;
-	unsigned int colorchanels = cinfo.num_components;
+	const size_t width = cinfo.output_width;
 
-	if (colorchanels != 4)
+	if (cinfo.out_color_components == 3)
 	{
-		std::vector<ColorRGB> d((size_t)width * (size_t)height);
-
-		while (cinfo.output_scanline < cinfo.image_height)
+		// Decode each scanline into the last 3/4 of its own output row and expand it in place
+		while (cinfo.output_scanline < cinfo.output_height)
 		{
-			uint8_t* p = (uint8_t*)d.data() + (size_t)cinfo.output_scanline * (size_t)cinfo.image_width * (size_t)cinfo.num_components;
+			rave::Color* row = data + (size_t)cinfo.output_scanline * width;
+			uint8_t* p = reinterpret_cast<uint8_t*>(row) + width;
 			jpeg_read_scanlines(&cinfo, &p, 1);
-		}
-
-		for (const auto& color : d)
-		{
-			data->r = color.r;
-			data->g = color.g;
-			data->b = color.b;
-			data->a = 255;
-
-			data++;
+			rave::ConvertRGBToRGBA(p, row, width);
 		}
 	}
 	else
 	{
-		while (cinfo.output_scanline < cinfo.image_height)
+		while (cinfo.output_scanline < cinfo.output_height)
 		{
-			uint8_t* p = (uint8_t*)data + (size_t)cinfo.output_scanline * (size_t)cinfo.image_width * (size_t)cinfo.num_components;
+			uint8_t* p = reinterpret_cast<uint8_t*>(data + (size_t)cinfo.output_scanline * width);
 			jpeg_read_scanlines(&cinfo, &p, 1);
 		}
 	}
 
 	jpeg_finish_decompress(&cinfo);
-	jpeg_destroy_decompress(&cinfo);
-	fclose(pFile);
-
-	return RE_SUCCESS;
 }
-rave::Result rave::ReadImageRaw(std::string_view filename, Color* data)
-{
-	size_t dotpos = filename.rfind('.');
-	if (dotpos == filename.npos)
-		RETURN_ERROR(L"Invalid file name");
-	std::string_view formatstr = filename.substr(dotpos);
 
-	if (!FileExists(filename.data()))
-		RETURN_FNF();
+// Images with fewer output pixels than this aren't worth splitting over threads
+static constexpr size_t parallelJpegPixels = 1024 * 1024;
+
+// Restart intervals that start on an MCU row, up to the next strip. Rows are those of the full size image
+struct JpegStrip
+{
+	size_t begin;
+	size_t end;
+	unsigned int firstInterval;
+	unsigned int firstRow;
+	unsigned int rowCount;
+};
 
-	switch (HashString(formatstr.data()))
+// Every block of a sequential scan decodes on its own, upsampling included, and the entropy coder starts over at
+// each restart marker. So a run of intervals beginning on an MCU row is a complete JPEG once it gets the file's
+// tables and a frame header with its own height. Anything else, like a second scan, leaves the plan empty
+static std::vector<JpegStrip> PlanJpegStrips(const unsigned char* bytes, size_t length, const jpeg_decompress_struct& cinfo, size_t stripCount)
+{
+	if (cinfo.restart_interval == 0 || cinfo.progressive_mode || cinfo.comps_in_scan != cinfo.num_components || cinfo.block_size != DCTSIZE)
+		return {};
+
+	// Interleaved MCUs cover the largest sampling factors, a single component is coded a block at a time
+	const unsigned int mcuWidth = cinfo.comps_in_scan > 1 ? cinfo.max_h_samp_factor * DCTSIZE : DCTSIZE * cinfo.max_h_samp_factor / cinfo.cur_comp_info[0]->h_samp_factor;
+	const unsigned int mcuHeight = cinfo.comps_in_scan > 1 ? cinfo.max_v_samp_factor * DCTSIZE : DCTSIZE * cinfo.max_v_samp_factor / cinfo.cur_comp_info[0]->v_samp_factor;
+	const unsigned int mcusPerRow = (cinfo.image_width + mcuWidth - 1) / mcuWidth;
+	const unsigned int mcuRows = (cinfo.image_height + mcuHeight - 1) / mcuHeight;
+	const unsigned int rowsPerStrip = (unsigned int)std::max<size_t>(1, (mcuRows + stripCount - 1) / stripCount);
+
+	// jpeg_read_header stops right after the start of scan, the entropy coded data follows
+	std::vector<JpegStrip> strips;
+	strips.push_back({ length - cinfo.src->bytes_in_buffer, 0, 0, 0, 0 });
+
+	unsigned int interval = 0;
+	const unsigned char* p = bytes + strips.back().begin;
+	const unsigned char* const end = bytes + length;
+	while (true)
 	{
-		case HashString(".png"):  return ReadPNGRaw(filename.data(), data);
-		case HashString(".bmp"):  return ReadBMPRaw(filename.data(), data);
-		case HashString(".jpg"):
-		case HashString(".jpe"):
-		case HashString(".jpeg"): return ReadJPEGRaw(filename.data(), data);
-		case HashString(".gif"):  return ReadGIFRaw (filename.data(), data, 0);
+		p = static_cast<const unsigned char*>(memchr(p, 0xFF, end - p));
+		if (!p || p + 1 >= end)
+			return {};
 
-		default: RETURN_ERROR( L"File format not recognised" );
+		// 0xFF 0x00 is a stuffed data byte, 0xFF 0xFF a fill byte before a marker
+		const unsigned char marker = p[1];
+		if (marker == 0x00 || marker == 0xFF)
+		{
+			p++;
+			continue;
+		}
+		if (marker == 0xD9)
+			break;
+		if (marker != 0xD0 + interval % 8)
+			return {};
+
+		interval++;
+		const size_t mcu = (size_t)interval * cinfo.restart_interval;
+		const size_t row = mcu / mcusPerRow;
+		if (mcu % mcusPerRow == 0 && row < mcuRows && row - strips.back().firstRow >= rowsPerStrip)
+		{
+			strips.back().end = p - bytes;
+			strips.push_back({ (size_t)(p + 2 - bytes), 0, interval, (unsigned int)row, 0 });
+		}
+		p += 2;
 	}
-}
 
-rave::Result rave::ReadGIF(const char* filename, std::vector<Color>& data, unsigned int frame, unsigned int* pWidth, unsigned int* pHeight)
-{
-	gd_GIF* pGif = gd_open_gif(filename);
-	if(!pGif)
-		RETURN_FNF();
+	if (strips.size() < 2)
+		return {};
 
-	std::vector<ColorRGB> intermediate((size_t)pGif->width * (size_t)pGif->height);
+	strips.back().end = p - bytes;
+	for (JpegStrip& strip : strips)
+		strip.firstRow *= mcuHeight;
+	for (size_t i = 0; i + 1 < strips.size(); i++)
+		strips[i].rowCount = strips[i + 1].firstRow - strips[i].firstRow;
+	strips.back().rowCount = cinfo.image_height - strips.back().firstRow;
+	return strips;
+}
 
-	data.resize((size_t)pGif->width * (size_t)pGif->height);
-	for (unsigned int i = 0; i < frame + 1 && gd_get_frame(pGif); i++);
+// The file's headers with the strip's height, its intervals with the restart markers numbered from 0, and an end of image
+static void BuildJpegStrip(const unsigned char* bytes, size_t headerLength, size_t frameHeader, const JpegStrip& strip, std::vector<unsigned char>& jpeg)
+{
+	jpeg.assign(bytes, bytes + headerLength);
+	jpeg[frameHeader + 3] = (unsigned char)(strip.rowCount >> 8);
+	jpeg[frameHeader + 4] = (unsigned char)strip.rowCount;
+	jpeg.insert(jpeg.end(), bytes + strip.begin, bytes + strip.end);
 
-	gd_render_frame(pGif, reinterpret_cast<unsigned char*>(intermediate.data()));
-	auto it = data.begin();
-	for (const auto& color : intermediate)
+	if (strip.firstInterval % 8 != 0)
 	{
-		it->r = color.r;
-		it->g = color.g;
-		it->b = color.b;
-		it->a = gd_is_bgcolor(pGif, reinterpret_cast<const unsigned char*>(&color)) ? 0 : 255;
-
-		it++;
+		unsigned char* p = jpeg.data() + headerLength;
+		unsigned char* const end = jpeg.data() + jpeg.size();
+		while ((p = static_cast<unsigned char*>(memchr(p, 0xFF, end - p))) && p + 1 < end)
+		{
+			if (p[1] >= 0xD0 && p[1] <= 0xD7)
+				p[1] = (unsigned char)(0xD0 + (p[1] - 0xD0 + 8 - strip.firstInterval % 8) % 8);
+			p += p[1] == 0xFF ? 1 : 2;
+		}
 	}
 
-	if (pWidth)
-		*pWidth = pGif->width;
-	if (pHeight)
-		*pHeight = pGif->height;
+	jpeg.insert(jpeg.end(), { 0xFF, 0xD9 });
+}
 
-	gd_close_gif(pGif);
+// Decodes one strip on the calling thread, into the rows the strip covers
+static bool ReadJpegStrip(const std::vector<unsigned char>& jpeg, rave::Color* data, const rave::DecodeOptions& options, unsigned int eighths)
+{
+	jpeg_decompress_struct cinfo;
+	JpegErrorManager errorManager;
+	DecoderScope scope;
+	JpegMemoryScope memoryScope(scope.GetArena());
 
-	return RE_SUCCESS;
+	InitJpegErrors(cinfo, errorManager);
+	if (setjmp(errorManager.jumpBuffer))
+	{
+		jpeg_destroy_decompress(&cinfo);
+		return false;
+	}
+
+	jpeg_create_decompress(&cinfo);
+	jpeg_mem_src(&cinfo, const_cast<unsigned char*>(jpeg.data()), (unsigned long)jpeg.size());
+	jpeg_read_header(&cinfo, TRUE);
+	ConfigureJpegDecode(cinfo, options, eighths);
+	ReadJpegScanlines(cinfo, data);
+	jpeg_destroy_decompress(&cinfo);
+	return true;
 }
-rave::Result rave::ReadBMP(const char* filename, std::vector<Color>& data, unsigned int* pWidth, unsigned int* pHeight)
-{
-    std::ifstream inp{ filename, std::ios_base::binary };
-    if (inp) 
-    {
-        BMPFileHeader file_header;
-        BMPInfoHeader bmp_info_header;
-        BMPColorHeader bmp_color_header;
-
-        inp.read((char*)&file_header, sizeof(file_header));
-        if (file_header.file_type != 0x4D42) 
-        {
-            RETURN_ERROR(L"Unrecognized file format");
-        }
-        inp.read((char*)&bmp_info_header, sizeof(bmp_info_header));
-
-        // The BMPColorHeader is used only for transparent images
-        if (bmp_info_header.bit_count == 32) 
-        {
-            // Check if the file has bit mask color information
-            if (bmp_info_header.size >= (sizeof(BMPInfoHeader) + sizeof(BMPColorHeader))) 
-            {
-                inp.read((char*)&bmp_color_header, sizeof(bmp_color_header));
-                // Check if the pixel data is stored as BGRA and if the color space type is sRGB
-                check_color_header(bmp_color_header);
-            }
-            else 
-            {
-				RETURN_ERROR(L"Unrecognized file format");
-            }
-        }
-
-        // Jump to the pixel data location
-        inp.seekg(file_header.offset_data, inp.beg);
-
-        // Adjust the header fields for output.
-        // Some editors will put extra info in the image file, we only save the headers and the data.
-        if (bmp_info_header.bit_count == 32) 
-        {
-            bmp_info_header.size = sizeof(BMPInfoHeader) + sizeof(BMPColorHeader);
-            file_header.offset_data = sizeof(BMPFileHeader) + sizeof(BMPInfoHeader) + sizeof(BMPColorHeader);
-        }
-        else 
-        {
-            bmp_info_header.size = sizeof(BMPInfoHeader);
-            file_header.offset_data = sizeof(BMPFileHeader) + sizeof(BMPInfoHeader);
-        }
-        file_header.file_size = file_header.offset_data;
-
-        if (bmp_info_header.height < 0) 
-        {
-			RETURN_ERROR(L"The program can treat only BMP images with the origin in the bottom left corner!");
-        }
-
-        data.resize((size_t)bmp_info_header.width * (size_t)bmp_info_header.height);
-
-        // Here we check if we need to take into account row padding
-		if (bmp_info_header.bit_count == 32)
-		{
-			if (bmp_info_header.width % 4 == 0)
-			{
-				unsigned int row_stride = (unsigned int)bmp_info_header.width * (unsigned int)bmp_info_header.bit_count / 8;
 
-				for (int y = bmp_info_header.height - 1; y >= 0; --y)
-				{
-					inp.read((char*)(&data[(size_t)bmp_info_header.width * (size_t)y]), row_stride);
-				}
-			}
-			else
-			{
-				unsigned int row_stride = (unsigned int)bmp_info_header.width * (unsigned int)bmp_info_header.bit_count / 8;
-				uint32_t new_stride = make_stride_aligned(4, row_stride);
-				std::vector<uint8_t> padding_row(new_stride - row_stride);
+rave::Result rave::ReadJPEGRaw(const void* bytes, size_t length, Color* data, const DecodeOptions& options)
+{
+	const unsigned char* pBytes = static_cast<const unsigned char*>(bytes);
+	jpeg_decompress_struct cinfo;
+	JpegErrorManager errorManager;
+	DecoderScope scope;
+	JpegMemoryScope memoryScope(scope.GetArena());
+	std::vector<JpegStrip> strips;
 
-				for (int y = bmp_info_header.height - 1; y >= 0; --y)
-				{
-					inp.read((char*)(&data[(size_t)bmp_info_header.width * (size_t)y]), row_stride);
-					inp.read((char*)padding_row.data(), padding_row.size());
-				}
-			}
-			for (auto& color : data)
-			{
-				const auto temp = color;
-				color.r = temp.b;
-				color.b = temp.r;
-			}
-		}
-		else
-		{
-			std::vector<ColorRGB> intermed((size_t)bmp_info_header.width * (size_t)bmp_info_header.height);
-			if (bmp_info_header.width % 4 == 0)
-			{
-				unsigned int row_stride = (unsigned int)bmp_info_header.width * (unsigned int)bmp_info_header.bit_count / 8;
+	InitJpegErrors(cinfo, errorManager);
+	if (setjmp(errorManager.jumpBuffer))
+	{
+		// We jump here on errors
+		jpeg_destroy_decompress(&cinfo);
+		RETURN_ERROR(L"Error occurred trying to read jpeg file");
+	}
 
-				for (int y = bmp_info_header.height - 1; y >= 0; --y)
-				{
-					inp.read((char*)(&intermed[(size_t)bmp_info_header.width * (size_t)y]), row_stride);
-				}
-			}
-			else
-			{
-				unsigned int row_stride = (unsigned int)bmp_info_header.width * (unsigned int)bmp_info_header.bit_count / 8;
-				uint32_t new_stride = make_stride_aligned(4, row_stride);
-				std::vector<uint8_t> padding_row(new_stride - row_stride);
+	jpeg_create_decompress(&cinfo);
+	jpeg_mem_src(&cinfo, (unsigned char*)bytes, (unsigned long)length);
+	jpeg_read_header(&cinfo, TRUE);
 
-				for (int y = bmp_info_header.height - 1; y >= 0; --y)
-				{
-					inp.read((char*)(&data[(size_t)bmp_info_header.width * (size_t)y]), row_stride);
-					inp.read((char*)padding_row.data(), padding_row.size());
-				}
-			}
-			auto it = data.begin();
-			for (const auto& color : intermed)
-			{
-				it->r = color.b;
-				it->g = color.g;
-				it->b = color.r;
-				it->a = 255;
+	const Size imageSize = Size(cinfo.image_width, cinfo.image_height);
+	const unsigned int eighths = JpegScale(imageSize, options);
+	const Size outputSize = ScaledJpegSize(imageSize, eighths);
+	// Decodes on a worker of the pool they'd split over stay serial, in release builds as well
+	ThreadPool* pPool = ThreadPool::ForCaller(options.pPool);
+	const size_t threadCount = pPool ? pPool->GetThreadCount() : 1;
 
-				it++;
-			}
-		}
-		if (pWidth)
-			*pWidth = (unsigned int)bmp_info_header.width;
-		if (pHeight)
-			*pHeight = (unsigned int)bmp_info_header.height;
+	// A few strips per thread so the ones that finish early pick up the rest
+	if (threadCount > 1 && (size_t)outputSize.x * outputSize.y >= parallelJpegPixels)
+		strips = PlanJpegStrips(pBytes, length, cinfo, threadCount * 4);
 
+	const size_t headerLength = length - cinfo.src->bytes_in_buffer;
+	const size_t frameHeader = strips.empty() ? 0 : FindJpegFrameHeader(pBytes, headerLength);
+	if (frameHeader == 0)
+	{
+		ConfigureJpegDecode(cinfo, options, eighths);
+		ReadJpegScanlines(cinfo, data);
+		jpeg_destroy_decompress(&cinfo);
 		return RE_SUCCESS;
-    }
-    else
-    {
-        RETURN_FNF();
-    }
+	}
+	jpeg_destroy_decompress(&cinfo);
+
+	// libjpeg reports warnings by throwing, ParallelFor passes the first one on to this thread
+	std::vector<char> decoded(strips.size(), 0);
+	pPool->ParallelFor(strips.size(), [&](size_t i)
+	{
+		std::vector<unsigned char> jpeg;
+		BuildJpegStrip(pBytes, headerLength, frameHeader, strips[i], jpeg);
+		decoded[i] = ReadJpegStrip(jpeg, data + (size_t)strips[i].firstRow * eighths / 8 * outputSize.x, options, eighths);
+	});
+
+	for (char stripDecoded : decoded)
+		if (!stripDecoded)
+			RETURN_ERROR(L"Error occurred trying to read jpeg file");
+	return RE_SUCCESS;
 }
-rave::Result rave::ReadPNG(const char* filename, std::vector<Color>& data, unsigned int* pWidth, unsigned int* pHeight)
+rave::Result rave::ReadKTX2Raw(const void* bytes, size_t length, Color* data)
 {
-	FILE* fp = fopen(filename, "rb");
+	KtxFile file;
+	auto result = file.Open(bytes, length);
+	if (result.Failed())
+		return result;
 
-	png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-	if (!png) RETURN_FNF();
+	if (!IsKTX2RGBA8(file.GetVkFormat()))
+		RETURN_ERROR(L"Only R8G8B8A8 KTX2 textures can be read as colors, use KtxFile to upload the others as they are");
 
-	png_infop info = png_create_info_struct(png);
-	if (!info) { png_destroy_read_struct(&png, NULL, NULL); fclose(fp); rave_bail_png(); }
+	auto level = file.GetLevel(0);
+	if (level.GetResult().Failed())
+		return level.GetResult();
 
-	if (setjmp(png_jmpbuf(png))) { png_destroy_read_struct(&png, NULL, NULL); fclose(fp); rave_bail_png(); }
+	const size_t byteSize = (size_t)level.Get().size.x * level.Get().size.y * sizeof(Color);
+	if (level.Get().length < byteSize)
+		RETURN_ERROR(L"KTX2 level is too short for its size");
 
-	png_init_io(png, fp);
+	memcpy(static_cast<void*>(data), level.Get().data, byteSize);
+	return RE_SUCCESS;
+}
+rave::Result rave::ReadQOIRaw(const void* bytes, size_t length, Color* data)
+{
+	const unsigned char* pBytes = static_cast<const unsigned char*>(bytes);
+	auto info = ProbeQOI(pBytes, length);
+	if (info.GetResult().Failed())
+		return info.GetResult();
 
-	png_read_info(png, info);
+	// Every op is at most 5 bytes, so checking the start of each against the padding keeps all reads inside the data
+	const unsigned char* p = pBytes + qoiHeaderLength;
+	const unsigned char* const end = pBytes + length - sizeof(qoiPadding);
+	unsigned char* out = reinterpret_cast<unsigned char*>(data);
+	unsigned char* const outEnd = out + (size_t)info.Get().size.x * info.Get().size.y * 4;
 
-	unsigned int width = png_get_image_width(png, info);
-	unsigned int height = png_get_image_height(png, info);
-	unsigned int color_type = png_get_color_type(png, info);
-	unsigned int bit_depth = png_get_bit_depth(png, info);
+	unsigned char index[64][4] = {};
+	unsigned char pixel[4] = { 0, 0, 0, 255 };
 
-	// Read any color_type into 8bit depth, RGBA format.
-	// See http://www.libpng.org/pub/png/libpng-manual.txt
+	while (out < outEnd)
+	{
+		if (p >= end)
+			RETURN_ERROR(L"QOI data ends early");
 
-	if (bit_depth == 16)
-		png_set_strip_16(png);
+		const unsigned char op = *p++;
+		if (op == qoiOpRGB)
+		{
+			pixel[0] = p[0];
+			pixel[1] = p[1];
+			pixel[2] = p[2];
+			p += 3;
+		}
+		else if (op == qoiOpRGBA)
+		{
+			memcpy(pixel, p, 4);
+			p += 4;
+		}
+		else if ((op & 0xC0) == qoiOpIndex)
+		{
+			memcpy(pixel, index[op], 4);
+		}
+		else if ((op & 0xC0) == qoiOpDiff)
+		{
+			pixel[0] += ((op >> 4) & 3) - 2;
+			pixel[1] += ((op >> 2) & 3) - 2;
+			pixel[2] += ( op       & 3) - 2;
+		}
+		else if ((op & 0xC0) == qoiOpLuma)
+		{
+			const int dg = (op & 0x3F) - 32;
+			pixel[0] += dg - 8 + (*p >> 4);
+			pixel[1] += dg;
+			pixel[2] += dg - 8 + (*p & 0x0F);
+			p++;
+		}
+		else
+		{
+			// Only the starting pixel can be missing from the index here
+			const size_t run = std::min<size_t>((op & 0x3F) + 1, (outEnd - out) / 4);
+			for (size_t i = 0; i < run; i++, out += 4)
+				memcpy(out, pixel, 4);
+			memcpy(index[QoiHash(pixel)], pixel, 4);
+			continue;
+		}
 
-	if (color_type == PNG_COLOR_TYPE_PALETTE)
-		png_set_palette_to_rgb(png);
+		memcpy(index[QoiHash(pixel)], pixel, 4);
+		memcpy(out, pixel, 4);
+		out += 4;
+	}
 
-	// PNG_COLOR_TYPE_GRAY_ALPHA is always 8 or 16bit depth.
-	if (color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8)
-		png_set_expand_gray_1_2_4_to_8(png);
+	return RE_SUCCESS;
+}
+rave::Result rave::ReadImageRaw(const void* bytes, size_t length, Color* data, const DecodeOptions& options)
+{
+	return ReadImageRaw(bytes, length, ImageFormat::Unknown, data, options);
+}
+rave::Result rave::ReadImageRaw(const void* bytes, size_t length, ImageFormat format, Color* data, const DecodeOptions& options)
+{
+	if (format == ImageFormat::Unknown)
+		format = DetectImageFormat(bytes, length);
 
-	if (png_get_valid(png, info, PNG_INFO_tRNS))
-		png_set_tRNS_to_alpha(png);
+	switch (format)
+	{
+		case ImageFormat::PNG:  return ReadPNGRaw (bytes, length, data, options);
+		case ImageFormat::BMP:  return ReadBMPRaw (bytes, length, data);
+		case ImageFormat::JPEG: return ReadJPEGRaw(bytes, length, data, options);
+		case ImageFormat::GIF:  return ReadGIFRaw (bytes, length, data, 0);
+		case ImageFormat::KTX2: return ReadKTX2Raw(bytes, length, data);
+		case ImageFormat::QOI:  return ReadQOIRaw (bytes, length, data);
 
-	// These color_type don't have an alpha channel then fill it with 0xff.
-	if (color_type == PNG_COLOR_TYPE_RGB ||
-		color_type == PNG_COLOR_TYPE_GRAY ||
-		color_type == PNG_COLOR_TYPE_PALETTE)
-		png_set_filler(png, 0xFF, PNG_FILLER_AFTER);
+		default: RETURN_ERROR( L"File format not recognised" );
+	}
+}
 
-	if (color_type == PNG_COLOR_TYPE_GRAY ||
-		color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
-		png_set_gray_to_rgb(png);
+rave::Result rave::ReadGIF(const char* filename, std::vector<Color>& data, unsigned int frame, unsigned int* pWidth, unsigned int* pHeight)
+{
+	FileMapping file;
+	auto result = file.Open(filename);
+	if (result.Failed())
+		return result;
 
-	png_read_update_info(png, info);
+	auto imgSize = ImageSizeGIF(file.Data(), file.Size());
+	if (imgSize.GetResult().Failed())
+		return imgSize.GetResult();
 
-	data.resize((size_t)width * (size_t)height);
-	std::vector<png_bytep> row_pointers(height);
-	for (unsigned int y = 0; y < height; y++)
-	{
-		row_pointers[y] = reinterpret_cast<png_bytep>(&data[(size_t)y * (size_t)width]);
-	}
+	const Size size = imgSize.Get();
+	data.resize((size_t)size.x * (size_t)size.y);
 
-	png_read_image(png, row_pointers.data());
-	fclose(fp);
-	png_destroy_read_struct(&png, &info, NULL);
+	result = ReadGIFRaw(file.Data(), file.Size(), data.data(), frame);
+	if (result.Failed())
+		return result;
 
 	if (pWidth)
-		*pWidth = width;
+		*pWidth = size.x;
 	if (pHeight)
-		*pHeight = height;
+		*pHeight = size.y;
 
 	return RE_SUCCESS;
 }
-rave::Result rave::ReadJPEG(const char* filename, std::vector<Color>& data, unsigned int* pWidth, unsigned int* pHeight)
+rave::Result rave::ReadBMP(const char* filename, std::vector<Color>& data, unsigned int* pWidth, unsigned int* pHeight)
 {
-	jpeg_decompress_struct cinfo;
-	JpegErrorManager errorManager;
+	return ReadMappedImage(filename, ImageFormat::BMP, data, pWidth, pHeight);
+}
+rave::Result rave::ReadPNG(const char* filename, std::vector<Color>& data, unsigned int* pWidth, unsigned int* pHeight, const DecodeOptions& options)
+{
+	return ReadMappedImage(filename, ImageFormat::PNG, data, pWidth, pHeight, options);
+}
+rave::Result rave::ReadJPEG(const char* filename, std::vector<Color>& data, unsigned int* pWidth, unsigned int* pHeight, const DecodeOptions& options)
+{
+	return ReadMappedImage(filename, ImageFormat::JPEG, data, pWidth, pHeight, options);
+}
+rave::Result rave::ReadQOI(const char* filename, std::vector<Color>& data, unsigned int* pWidth, unsigned int* pHeight)
+{
+	return ReadMappedImage(filename, ImageFormat::QOI, data, pWidth, pHeight);
+}
+
+rave::Result rave::EncodeQOI(const Color* pixels, const Size& size, std::vector<unsigned char>& qoi)
+{
+	if (!pixels || size.x == 0 || size.y == 0)
+		RETURN_ERROR(L"Cannot encode an empty image");
 
-	FILE* pFile = fopen(filename, "rb");
-	if (!pFile)
-		RETURN_FNF();
+	const size_t count = (size_t)size.x * size.y;
+	// The worst case is an RGBA op for every pixel
+	qoi.resize(qoiHeaderLength + count * 5 + sizeof(qoiPadding));
+	unsigned char* out = qoi.data();
 
-	// set our custom error handler
-	cinfo.err = jpeg_std_error(&errorManager.defaultErrorManager);
-	errorManager.defaultErrorManager.error_exit = JpegErrorExit;
-	errorManager.defaultErrorManager.output_message = JpegOutputMessage;
-	if (setjmp(errorManager.jumpBuffer))
+	memcpy(out, "qoif", 4);
+	for (int i = 0; i < 4; i++)
 	{
-		// We jump here on errors
-		jpeg_destroy_decompress(&cinfo);
-		fclose(pFile);
-		RETURN_ERROR(L"Error occurred trying to read jpeg file");
+		out[4 + i] = (unsigned char)(size.x >> (24 - 8 * i));
+		out[8 + i] = (unsigned char)(size.y >> (24 - 8 * i));
 	}
+	// RGBA, sRGB colour with linear alpha
+	out[12] = 4;
+	out[13] = 0;
+	out += qoiHeaderLength;
 
-	jpeg_create_decompress(&cinfo);
-	jpeg_stdio_src(&cinfo, pFile);
-	jpeg_read_header(&cinfo, TRUE);
-	jpeg_start_decompress(&cinfo);
-
-	unsigned int width = cinfo.image_width;
-	unsigned int height = cinfo.image_height;
-	unsigned int colorchanels = cinfo.num_components;
+	const unsigned char* in = reinterpret_cast<const unsigned char*>(pixels);
+	unsigned char index[64][4] = {};
+	unsigned char previous[4] = { 0, 0, 0, 255 };
+	unsigned int run = 0;
 
-	data.resize((size_t)width * (size_t)height);
-
-	if (colorchanels != 4)
+	for (size_t i = 0; i < count; i++, in += 4)
 	{
-		std::vector<ColorRGB> d((size_t)width * (size_t)height);
-
-		while (cinfo.output_scanline < cinfo.image_height)
+		if (memcmp(in, previous, 4) == 0)
 		{
-			uint8_t* p = (uint8_t*)d.data() + (size_t)cinfo.output_scanline * (size_t)cinfo.image_width * (size_t)cinfo.num_components;
-			jpeg_read_scanlines(&cinfo, &p, 1);
+			// Runs of 63 and 64 would collide with the RGB and RGBA tags
+			if (++run == 62)
+			{
+				*out++ = qoiOpRun | (unsigned char)(run - 1);
+				run = 0;
+			}
+			continue;
 		}
 
-		auto it = data.begin();
-		for (const auto& color : d)
+		if (run)
 		{
-			it->r = color.r;
-			it->g = color.g;
-			it->b = color.b;
-			it->a = 255;
-
-			it++;
+			*out++ = qoiOpRun | (unsigned char)(run - 1);
+			run = 0;
 		}
-	}
-	else
-	{
-		while (cinfo.output_scanline < cinfo.image_height)
+
+		const unsigned int hash = QoiHash(in);
+		if (memcmp(index[hash], in, 4) == 0)
 		{
-			uint8_t* p = (uint8_t*)data.data() + (size_t)cinfo.output_scanline * (size_t)cinfo.image_width * (size_t)cinfo.num_components;
-			jpeg_read_scanlines(&cinfo, &p, 1);
+			*out++ = qoiOpIndex | (unsigned char)hash;
 		}
-	}
+		else
+		{
+			memcpy(index[hash], in, 4);
 
-	jpeg_finish_decompress(&cinfo);
-	jpeg_destroy_decompress(&cinfo);
-	fclose(pFile);
+			if (in[3] == previous[3])
+			{
+				const signed char dr = (signed char)(in[0] - previous[0]);
+				const signed char dg = (signed char)(in[1] - previous[1]);
+				const signed char db = (signed char)(in[2] - previous[2]);
+				const int drg = dr - dg;
+				const int dbg = db - dg;
 
-	if (pWidth)
-		*pWidth = width;
-	if (pHeight)
-		*pHeight = height;
+				if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+				{
+					*out++ = qoiOpDiff | (unsigned char)(((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+				}
+				else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7)
+				{
+					*out++ = qoiOpLuma | (unsigned char)(dg + 32);
+					*out++ = (unsigned char)(((drg + 8) << 4) | (dbg + 8));
+				}
+				else
+				{
+					*out++ = qoiOpRGB;
+					memcpy(out, in, 3);
+					out += 3;
+				}
+			}
+			else
+			{
+				*out++ = qoiOpRGBA;
+				memcpy(out, in, 4);
+				out += 4;
+			}
+		}
+		memcpy(previous, in, 4);
+	}
+	if (run)
+		*out++ = qoiOpRun | (unsigned char)(run - 1);
 
+	memcpy(out, qoiPadding, sizeof(qoiPadding));
+	out += sizeof(qoiPadding);
+	qoi.resize(out - qoi.data());
 	return RE_SUCCESS;
 }
+
+rave::Result rave::WriteQOI(const Color* pixels, const Size& size, const char* filename)
+{
+	std::vector<unsigned char> qoi;
+	auto result = EncodeQOI(pixels, size, qoi);
+	if (result.Failed())
+		return result;
+
+	FILE* file = fopen(filename, "wb");
+	if (!file)
+		return Result((L"Unable to create file \"" + Widen(std::string(filename)) + L"\"").c_str(), RE_FAIL, RE_FILE_NOT_FOUND);
+
+	bool written = fwrite(qoi.data(), 1, qoi.size(), file) == qoi.size();
+	written = fclose(file) == 0 && written;
+	if (!written)
+		return Result((L"Unable to write file \"" + Widen(std::string(filename)) + L"\"").c_str(), RE_FAIL, RE_FILE_NOT_FOUND);
+	return RE_SUCCESS;
+}
\ No newline at end of file
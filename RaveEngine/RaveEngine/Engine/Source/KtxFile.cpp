@@ -0,0 +1,276 @@
+#include "Engine/Include/KtxFile.h"
+#include "Libraries/zlib/zlib.h"
+#include <limits>
+#include <new>
+
+#define RETURN_ERROR(message) return rave::Result(message, rave::RE_FAIL, rave::RE_IMAGE_LOAD_FAIL)
+
+static constexpr unsigned char ktxIdentifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+// Identifier, nine 32 bit header fields, then the data format, key/value and supercompression index
+static constexpr size_t ktxHeaderLength = 80;
+static constexpr size_t ktxLevelIndexLength = 24;
+// Deflate can't pack more than 258 bytes into one 2 bit match, so no stream inflates to more than 1032 times its length
+static constexpr uint64_t maxDeflateRatio = 1032;
+// R64G64B64A64 has the largest texels, and no block compressed format spends more than 16 bytes on a 4x4 block
+static constexpr uint64_t maxTexelBytes = 32;
+static constexpr uint64_t maxBlockBytes = 16;
+
+static uint32_t ReadLittleEndian32(const unsigned char* p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t ReadLittleEndian64(const unsigned char* p)
+{
+	return (uint64_t)ReadLittleEndian32(p) | ((uint64_t)ReadLittleEndian32(p + 4) << 32);
+}
+
+rave::KtxFile::KtxFile(const char* filename, const bool throws)
+{
+	auto result = Open(filename);
+	if (throws)
+		result.Throw();
+}
+
+rave::KtxFile::KtxFile(KtxFile&& rhs) noexcept
+{
+	*this = std::move(rhs);
+}
+
+rave::KtxFile& rave::KtxFile::operator=(KtxFile&& rhs) noexcept
+{
+	if (this != &rhs)
+	{
+		Close();
+		file = std::move(rhs.file);
+		bytes = rhs.bytes;
+		length = rhs.length;
+		vkFormat = rhs.vkFormat;
+		supercompression = rhs.supercompression;
+		size = rhs.size;
+		depth = rhs.depth;
+		layerCount = rhs.layerCount;
+		faceCount = rhs.faceCount;
+		levels = std::move(rhs.levels);
+		inflated = std::move(rhs.inflated);
+		rhs.Close();
+	}
+	return *this;
+}
+
+rave::Result rave::KtxFile::Open(const char* filename)
+{
+	Close();
+
+	auto result = file.Open(filename);
+	if (result.Failed())
+		return result;
+
+	result = Attach(file.Data(), file.Size());
+	if (result.Failed())
+		Close();
+	return result;
+}
+
+rave::Result rave::KtxFile::Open(const void* bytes, size_t length)
+{
+	Close();
+
+	auto result = Attach(bytes, length);
+	if (result.Failed())
+		Close();
+	return result;
+}
+
+void rave::KtxFile::Close() noexcept
+{
+	file.Close();
+	bytes = nullptr;
+	length = 0;
+	vkFormat = 0;
+	supercompression = KtxSupercompression::None;
+	size = { 0, 0 };
+	depth = 0;
+	layerCount = 0;
+	faceCount = 0;
+	levels.clear();
+	inflated.clear();
+}
+
+bool rave::KtxFile::IsOpen() const noexcept
+{
+	return bytes;
+}
+
+rave::Result rave::KtxFile::Attach(const void* data, size_t dataLength)
+{
+	const unsigned char* p = static_cast<const unsigned char*>(data);
+	if (!p || dataLength < ktxHeaderLength || memcmp(p, ktxIdentifier, sizeof(ktxIdentifier)) != 0)
+		RETURN_ERROR(L"Not a KTX2 file");
+
+	vkFormat = ReadLittleEndian32(p + 12);
+	size = Size(ReadLittleEndian32(p + 20), std::max(ReadLittleEndian32(p + 24), 1u));
+	depth = std::max(ReadLittleEndian32(p + 28), 1u);
+	layerCount = std::max(ReadLittleEndian32(p + 32), 1u);
+	faceCount = ReadLittleEndian32(p + 36);
+	const uint32_t levelCount = std::max(ReadLittleEndian32(p + 40), 1u);
+	supercompression = KtxSupercompression(ReadLittleEndian32(p + 44));
+
+	if (size.x == 0 || (faceCount != 1 && faceCount != 6) || levelCount > 32)
+		RETURN_ERROR(L"Invalid KTX2 header");
+	if (supercompression != KtxSupercompression::None && supercompression != KtxSupercompression::Zlib)
+		RETURN_ERROR(L"Only KTX2 files without supercompression or with zlib supercompression are supported");
+	if (ktxHeaderLength + (size_t)levelCount * ktxLevelIndexLength > dataLength)
+		RETURN_ERROR(L"KTX2 level index is truncated");
+
+	levels.resize(levelCount);
+	for (uint32_t i = 0; i < levelCount; i++)
+	{
+		const unsigned char* entry = p + ktxHeaderLength + (size_t)i * ktxLevelIndexLength;
+		levels[i].offset = ReadLittleEndian64(entry);
+		levels[i].length = ReadLittleEndian64(entry + 8);
+		levels[i].uncompressedLength = ReadLittleEndian64(entry + 16);
+
+		if (levels[i].offset > dataLength || levels[i].length > dataLength - levels[i].offset)
+			RETURN_ERROR(L"KTX2 level lies outside the file");
+	}
+	inflated.resize(levelCount);
+
+	bytes = p;
+	length = dataLength;
+	return RE_SUCCESS;
+}
+
+uint64_t rave::KtxFile::MaxLevelLength(unsigned int level) const noexcept
+{
+	const uint64_t width = std::max(size.x >> level, 1u);
+	const uint64_t height = std::max(size.y >> level, 1u);
+	const uint64_t slices = (uint64_t)std::max(depth >> level, 1u) * layerCount * faceCount;
+	const uint64_t units = IsBlockCompressed() ? ((width + 3) / 4) * ((height + 3) / 4) : width * height;
+	const uint64_t unitBytes = IsBlockCompressed() ? maxBlockBytes : maxTexelBytes;
+
+	// Width and height are below 2^32, so only the slices and bytes can overflow
+	if (units > std::numeric_limits<uint64_t>::max() / unitBytes / slices)
+		return std::numeric_limits<uint64_t>::max();
+	return units * unitBytes * slices;
+}
+
+rave::Result rave::KtxFile::Inflate(unsigned int level)
+{
+	// The length in the index is only trusted as far as the level's dimensions and the deflate ratio allow,
+	// so a crafted file can't make us allocate more than its pixels could ever take
+	const LevelIndex& index = levels[level];
+	if (index.uncompressedLength > MaxLevelLength(level) || index.uncompressedLength / maxDeflateRatio > index.length)
+		RETURN_ERROR(L"KTX2 level claims more bytes than it can hold");
+	if (index.uncompressedLength > std::numeric_limits<uLongf>::max() || index.length > std::numeric_limits<uLong>::max())
+		RETURN_ERROR(L"KTX2 level is too large to inflate");
+
+	std::vector<unsigned char> buffer;
+	try
+	{
+		buffer.resize((size_t)index.uncompressedLength);
+	}
+	catch (const std::bad_alloc&)
+	{
+		RETURN_ERROR(L"Out of memory inflating KTX2 level");
+	}
+	uLongf inflatedLength = (uLongf)buffer.size();
+	if (uncompress(buffer.data(), &inflatedLength, bytes + index.offset, (uLong)index.length) != Z_OK || inflatedLength != buffer.size())
+		RETURN_ERROR(L"Unable to inflate KTX2 level");
+
+	inflated[level] = std::move(buffer);
+	return RE_SUCCESS;
+}
+
+uint32_t rave::KtxFile::GetVkFormat() const noexcept
+{
+	return vkFormat;
+}
+
+bool rave::KtxFile::IsBlockCompressed() const noexcept
+{
+	// VK_FORMAT_BC1_RGB_UNORM_BLOCK up to VK_FORMAT_ASTC_12x12_SRGB_BLOCK
+	return vkFormat >= 131 && vkFormat <= 184;
+}
+
+rave::KtxSupercompression rave::KtxFile::GetSupercompression() const noexcept
+{
+	return supercompression;
+}
+
+rave::Size rave::KtxFile::GetSize() const noexcept
+{
+	return size;
+}
+
+unsigned int rave::KtxFile::GetDepth() const noexcept
+{
+	return depth;
+}
+
+unsigned int rave::KtxFile::GetLayerCount() const noexcept
+{
+	return layerCount;
+}
+
+unsigned int rave::KtxFile::GetFaceCount() const noexcept
+{
+	return faceCount;
+}
+
+unsigned int rave::KtxFile::GetLevelCount() const noexcept
+{
+	return (unsigned int)levels.size();
+}
+
+rave::OptionalResult<rave::KtxLevel> rave::KtxFile::GetLevel(unsigned int level)
+{
+	if (level >= levels.size())
+		RETURN_ERROR(L"KTX2 level out of range");
+
+	KtxLevel out;
+	out.size = Size(std::max(size.x >> level, 1u), std::max(size.y >> level, 1u));
+	out.depth = std::max(depth >> level, 1u);
+
+	if (supercompression == KtxSupercompression::Zlib)
+	{
+		if (inflated[level].size() != levels[level].uncompressedLength)
+		{
+			auto result = Inflate(level);
+			if (result.Failed())
+				return result;
+		}
+		out.data = inflated[level].data();
+		out.length = inflated[level].size();
+	}
+	else
+	{
+		out.data = bytes + levels[level].offset;
+		out.length = (size_t)levels[level].length;
+	}
+	return out;
+}
+
+rave::Result rave::KtxFile::InflateAll(ThreadPool* pPool)
+{
+	if (supercompression != KtxSupercompression::Zlib)
+		return RE_SUCCESS;
+
+	std::vector<Result> results(levels.size());
+	auto inflateLevel = [&](size_t level)
+	{
+		if (inflated[level].size() != levels[level].uncompressedLength)
+			results[level] = Inflate((unsigned int)level);
+	};
+
+	if (pPool)
+		pPool->ParallelFor(levels.size(), inflateLevel);
+	else
+		for (size_t level = 0; level < levels.size(); level++)
+			inflateLevel(level);
+
+	for (const Result& result : results)
+		if (result.Failed())
+			return result;
+	return RE_SUCCESS;
+}
\ No newline at end of file
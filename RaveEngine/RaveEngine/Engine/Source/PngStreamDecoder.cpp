@@ -0,0 +1,148 @@
+#include "Engine/Include/PngStreamDecoder.h"
+
+#define RETURN_ERROR(message) return rave::Result(message, rave::RE_FAIL, rave::RE_IMAGE_LOAD_FAIL)
+
+rave::PngStreamDecoder::PngStreamDecoder(RowCallback onRow, HeaderCallback onHeader)
+	:
+	onRow(std::move(onRow)),
+	onHeader(std::move(onHeader))
+{
+	png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	if (png)
+		info = png_create_info_struct(png);
+
+	if (!png || !info)
+	{
+		failed = true;
+		return;
+	}
+
+	png_set_progressive_read_fn(png, this, InfoCallback, RowCallbackThunk, EndCallback);
+}
+
+rave::Result rave::PngStreamDecoder::Push(const void* bytes, size_t length)
+{
+	if (failed)
+		RETURN_ERROR(L"Something went wrong while trying to read png data");
+	if (finished || length == 0)
+		return RE_SUCCESS;
+
+	if (setjmp(png_jmpbuf(png)))
+	{
+		failed = true;
+		RETURN_ERROR(L"Something went wrong while trying to read png data");
+	}
+
+	png_process_data(png, info, static_cast<png_bytep>(const_cast<void*>(bytes)), length);
+	return RE_SUCCESS;
+}
+
+bool rave::PngStreamDecoder::IsHeaderRead() const noexcept
+{
+	return headerRead;
+}
+
+bool rave::PngStreamDecoder::IsFinished() const noexcept
+{
+	return finished;
+}
+
+rave::Size rave::PngStreamDecoder::GetSize() const noexcept
+{
+	return size;
+}
+
+rave::PngStreamDecoder::~PngStreamDecoder()
+{
+	if (png)
+		png_destroy_read_struct(&png, info ? &info : NULL, NULL);
+}
+
+void rave::PngStreamDecoder::InfoCallback(png_structp png, png_infop info)
+{
+	PngStreamDecoder* pDecoder = static_cast<PngStreamDecoder*>(png_get_progressive_ptr(png));
+
+	const unsigned int color_type = png_get_color_type(png, info);
+	const unsigned int bit_depth = png_get_bit_depth(png, info);
+
+	// Same conversion to 8 bit RGBA as ReadPNGRaw
+	if (bit_depth == 16)
+		png_set_strip_16(png);
+
+	if (color_type == PNG_COLOR_TYPE_PALETTE)
+		png_set_palette_to_rgb(png);
+
+	if (color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8)
+		png_set_expand_gray_1_2_4_to_8(png);
+
+	if (png_get_valid(png, info, PNG_INFO_tRNS))
+		png_set_tRNS_to_alpha(png);
+
+	if (color_type == PNG_COLOR_TYPE_RGB ||
+		color_type == PNG_COLOR_TYPE_GRAY ||
+		color_type == PNG_COLOR_TYPE_PALETTE)
+		png_set_filler(png, 0xFF, PNG_FILLER_AFTER);
+
+	if (color_type == PNG_COLOR_TYPE_GRAY ||
+		color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
+		png_set_gray_to_rgb(png);
+
+	const int passes = png_set_interlace_handling(png);
+
+	png_read_update_info(png, info);
+
+	pDecoder->size = Size(png_get_image_width(png, info), png_get_image_height(png, info));
+	pDecoder->headerRead = true;
+
+	if (passes > 1)
+	{
+		pDecoder->image.resize((size_t)pDecoder->size.x * (size_t)pDecoder->size.y);
+		pDecoder->emitted.assign(pDecoder->size.y, false);
+	}
+
+	if (pDecoder->onHeader)
+		pDecoder->onHeader(pDecoder->size);
+}
+
+void rave::PngStreamDecoder::RowCallbackThunk(png_structp png, png_bytep row, png_uint_32 y, int pass)
+{
+	PngStreamDecoder* pDecoder = static_cast<PngStreamDecoder*>(png_get_progressive_ptr(png));
+
+	if (pDecoder->image.empty())
+	{
+		// Not interlaced: every row arrives exactly once and is final
+		if (row)
+			pDecoder->onRow(y, reinterpret_cast<const Color*>(row));
+		return;
+	}
+
+	Color* dst = pDecoder->image.data() + (size_t)y * pDecoder->size.x;
+	if (row)
+		png_progressive_combine_row(png, reinterpret_cast<png_bytep>(dst), row);
+
+	// Nothing is added to a row after the seventh pass has reached it
+	if (pass == 6)
+		pDecoder->EmitRow(y);
+}
+
+void rave::PngStreamDecoder::EndCallback(png_structp png, png_infop info)
+{
+	PngStreamDecoder* pDecoder = static_cast<PngStreamDecoder*>(png_get_progressive_ptr(png));
+
+	// Small interlaced images can have an empty last pass
+	for (unsigned int y = 0; y < pDecoder->emitted.size(); y++)
+		pDecoder->EmitRow(y);
+
+	pDecoder->finished = true;
+	pDecoder->image.clear();
+	pDecoder->image.shrink_to_fit();
+}
+
+void rave::PngStreamDecoder::EmitRow(unsigned int y)
+{
+	if (emitted[y])
+		return;
+
+	emitted[y] = true;
+	onRow(y, image.data() + (size_t)y * size.x);
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace rave
+{
+	// Bump allocator for short lived work, like the decoder state of a single image.
+	// Individual allocations are never freed, Reset hands everything back at once.
+	class Arena
+	{
+	public:
+		Arena(size_t blockSize = 64 * 1024);
+		Arena(const Arena&) = delete;
+		Arena& operator= (const Arena&) = delete;
+
+		// Returns nullptr instead of throwing, so it can be handed to C libraries
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t)) noexcept;
+		// Invalidates every allocation. When the last round spilled into several blocks they are merged into one,
+		// so a following round of the same size doesn't touch the heap at all
+		void Reset() noexcept;
+		// Reset and give the memory back to the system
+		void Release() noexcept;
+
+		size_t GetUsedBytes() const noexcept;
+		size_t GetCapacity() const noexcept;
+
+	private:
+		struct Block
+		{
+			std::unique_ptr<unsigned char[]> data;
+			size_t size = 0;
+		};
+
+		bool AddBlock(size_t size) noexcept;
+
+		std::vector<Block> blocks;
+		size_t blockSize;
+		size_t offset = 0;
+		size_t used = 0;
+	};
+}
\ No newline at end of file
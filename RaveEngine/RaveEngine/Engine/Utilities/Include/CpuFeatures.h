@@ -0,0 +1,30 @@
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define RE_ARCH_X86
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define RE_ARCH_NEON
+#endif
+
+// MSVC lets any function use any intrinsic, gcc and clang need the instruction set enabled per function
+#if defined(_MSC_VER) && !defined(__clang__)
+#define RE_TARGET(features)
+#else
+#define RE_TARGET(features) __attribute__((target(features)))
+#endif
+
+namespace rave
+{
+	struct CpuFeatures
+	{
+		bool sse2 = false;
+		bool ssse3 = false;
+		bool sse41 = false;
+		bool avx2 = false;
+		bool pclmul = false;
+		bool neon = false;
+	};
+
+	// Queried once, on first use
+	const CpuFeatures& GetCpuFeatures() noexcept;
+}
\ No newline at end of file
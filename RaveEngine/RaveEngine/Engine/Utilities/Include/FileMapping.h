@@ -0,0 +1,32 @@
+#pragma once
+#include "Engine/Utilities/Include/Result.h"
+
+namespace rave
+{
+	// Read-only view of a whole file, backed by a memory mapping.
+	// The file is opened exactly once; every reader can then work on the same bytes.
+	class FileMapping
+	{
+	public:
+		FileMapping() = default;
+		FileMapping(const char* filename, const bool throws = false);
+		FileMapping(const FileMapping&) = delete;
+		FileMapping(FileMapping&& rhs) noexcept;
+
+		FileMapping& operator= (const FileMapping&) = delete;
+		FileMapping& operator= (FileMapping&& rhs) noexcept;
+
+		Result Open(const char* filename);
+		void Close() noexcept;
+
+		bool IsOpen() const noexcept;
+		const unsigned char* Data() const noexcept;
+		size_t Size() const noexcept;
+
+		~FileMapping();
+
+	private:
+		const unsigned char* data = nullptr;
+		size_t size = 0;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+#include "Engine/Utilities/Include/Color.h"
+#include <stddef.h>
+
+namespace rave
+{
+	// Expand tightly packed 3 byte pixels into Color with an opaque alpha.
+	// The conversion can run in place: src may be the last 3/4 of dst's memory, i.e. (unsigned char*)dst + count.
+	void ConvertRGBToRGBA(const unsigned char* src, Color* dst, size_t count) noexcept;
+	void ConvertBGRToRGBA(const unsigned char* src, Color* dst, size_t count) noexcept;
+	// Same as ConvertRGBToRGBA, but pixels equal to key get an alpha of 0
+	void ConvertRGBToRGBAKeyed(const unsigned char* src, Color* dst, size_t count, const Color& key) noexcept;
+
+	// src may be equal to dst
+	void ConvertBGRAToRGBA(const unsigned char* src, Color* dst, size_t count) noexcept;
+}
\ No newline at end of file
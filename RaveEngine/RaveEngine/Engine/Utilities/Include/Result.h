@@ -48,6 +48,7 @@ namespace rave
 		{
 			flags = rhs.flags;
 			CopyWString(&info, rhs.info);
+			return *this;
 		}
 
 		bool Succeeded() const noexcept
@@ -152,6 +153,7 @@ namespace rave
 		{
 			value = rhs.value;
 			result = rhs.result;
+			return *this;
 		}
 		T& GetAndCheck()
 		{
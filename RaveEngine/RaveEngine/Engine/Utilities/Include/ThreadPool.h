@@ -0,0 +1,54 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+#include <queue>
+
+namespace rave
+{
+	// Fixed set of worker threads pulling jobs from a shared queue.
+	class ThreadPool
+	{
+	public:
+		// A thread count of 0 uses one thread per hardware core
+		ThreadPool(size_t threadCount = 0);
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator= (const ThreadPool&) = delete;
+
+		void Push(std::function<void()> job);
+		// Blocks until the queue is empty and every worker is idle
+		void Wait();
+
+		// Runs job(i) for every i in [0, count) and returns once all have finished.
+		// If a job throws, the indices nobody has claimed yet are skipped and the first exception is rethrown here
+		void ParallelFor(size_t count, const std::function<void(size_t)>& job);
+
+		size_t GetThreadCount() const noexcept;
+		// Whether the calling thread is one of this pool's workers, which mustn't wait on the pool itself
+		bool IsWorkerThread() const noexcept;
+		// Whether the calling thread is a worker of any pool
+		static bool OnAnyWorkerThread() noexcept;
+
+		// Made on first use and shared by everything that splits its own work without being given a pool,
+		// so callers don't start threads of their own and concurrent ones don't multiply the thread count
+		static ThreadPool& GetShared();
+		// The pool work started on the calling thread should be split over: the requested one, or the shared one when none is given.
+		// Null when the caller should stay serial, because it runs on the requested pool's worker or, given none, on any pool's worker
+		static ThreadPool* ForCaller(ThreadPool* pRequested);
+
+		~ThreadPool();
+
+	private:
+		void WorkerLoop();
+
+		std::vector<std::thread> workers;
+		std::queue<std::function<void()>> jobs;
+		std::mutex mutex;
+		std::condition_variable jobAvailable;
+		std::condition_variable jobsDone;
+		size_t activeJobs = 0;
+		bool stopping = false;
+	};
+}
\ No newline at end of file
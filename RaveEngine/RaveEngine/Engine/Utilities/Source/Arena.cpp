@@ -0,0 +1,83 @@
+#include "Engine/Utilities/Include/Arena.h"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+rave::Arena::Arena(size_t blockSize)
+	:
+	blockSize(blockSize)
+{
+}
+
+void* rave::Arena::Allocate(size_t size, size_t alignment) noexcept
+{
+	if (!blocks.empty())
+	{
+		Block& block = blocks.back();
+		const uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+		const size_t start = ((base + offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+		if (start <= block.size && size <= block.size - start)
+		{
+			offset = start + size;
+			used += size;
+			return block.data.get() + start;
+		}
+	}
+
+	// Oversized requests get a block of their own
+	if (!AddBlock(std::max(blockSize, size + alignment)))
+		return nullptr;
+	return Allocate(size, alignment);
+}
+
+void rave::Arena::Reset() noexcept
+{
+	if (blocks.size() > 1)
+	{
+		const size_t capacity = GetCapacity();
+		Release();
+		AddBlock(capacity);
+	}
+	offset = 0;
+	used = 0;
+}
+
+void rave::Arena::Release() noexcept
+{
+	blocks.clear();
+	offset = 0;
+	used = 0;
+}
+
+size_t rave::Arena::GetUsedBytes() const noexcept
+{
+	return used;
+}
+
+size_t rave::Arena::GetCapacity() const noexcept
+{
+	size_t capacity = 0;
+	for (const Block& block : blocks)
+		capacity += block.size;
+	return capacity;
+}
+
+bool rave::Arena::AddBlock(size_t size) noexcept
+{
+	Block block;
+	block.data.reset(new (std::nothrow) unsigned char[size]);
+	if (!block.data)
+		return false;
+	block.size = size;
+
+	try
+	{
+		blocks.push_back(std::move(block));
+	}
+	catch (const std::bad_alloc&)
+	{
+		return false;
+	}
+	offset = 0;
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "Engine/Utilities/Include/CpuFeatures.h"
+
+#ifdef RE_ARCH_X86
+#	ifdef _MSC_VER
+#		include <intrin.h>
+#	else
+#		include <cpuid.h>
+#	endif
+#endif
+
+#ifdef RE_ARCH_X86
+static void Cpuid(int leaf, int subleaf, unsigned int regs[4])
+{
+#	ifdef _MSC_VER
+	int info[4];
+	__cpuidex(info, leaf, subleaf);
+	for (int i = 0; i < 4; i++)
+		regs[i] = (unsigned int)info[i];
+#	else
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#	endif
+}
+
+static unsigned long long ReadXCR0()
+{
+#	ifdef _MSC_VER
+	return _xgetbv(0);
+#	else
+	unsigned int eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((unsigned long long)edx << 32) | eax;
+#	endif
+}
+#endif
+
+static rave::CpuFeatures QueryCpuFeatures()
+{
+	rave::CpuFeatures features;
+
+#ifdef RE_ARCH_X86
+	unsigned int regs[4];
+	Cpuid(0, 0, regs);
+	const unsigned int maxLeaf = regs[0];
+
+	Cpuid(1, 0, regs);
+	features.sse2	= regs[3] & (1u << 26);
+	features.ssse3	= regs[2] & (1u << 9);
+	features.sse41	= regs[2] & (1u << 19);
+	features.pclmul	= regs[2] & (1u << 1);
+
+	// AVX2 also needs the OS to save the ymm registers on a context switch
+	const bool osxsave = regs[2] & (1u << 27);
+	const bool avx = regs[2] & (1u << 28);
+	if (maxLeaf >= 7 && osxsave && avx && (ReadXCR0() & 0x6) == 0x6)
+	{
+		Cpuid(7, 0, regs);
+		features.avx2 = regs[1] & (1u << 5);
+	}
+#elif defined(RE_ARCH_NEON)
+	features.neon = true;
+#endif
+
+	return features;
+}
+
+const rave::CpuFeatures& rave::GetCpuFeatures() noexcept
+{
+	static const CpuFeatures features = QueryCpuFeatures();
+	return features;
+}
\ No newline at end of file
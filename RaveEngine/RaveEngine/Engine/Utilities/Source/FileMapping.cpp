@@ -0,0 +1,136 @@
+#include "Engine/Utilities/Include/FileMapping.h"
+#include "Engine/Include/Platform.h"
+
+#ifndef RE_PLATFORM_WINDOWS
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define RETURN_FNF() return rave::Result((L"Unable to open file \"" + rave::Widen(std::string(filename)) + L"\"").c_str(), RE_FAIL, RE_FILE_NOT_FOUND)
+#define RETURN_MAP_FAIL() return rave::Result((L"Unable to map file \"" + rave::Widen(std::string(filename)) + L"\"").c_str(), RE_FAIL, RE_FILE_NOT_FOUND)
+
+rave::FileMapping::FileMapping(const char* filename, const bool throws)
+{
+	auto result = Open(filename);
+	if (throws)
+		result.Throw();
+}
+
+rave::FileMapping::FileMapping(FileMapping&& rhs) noexcept
+	:
+	data(rhs.data),
+	size(rhs.size)
+{
+	rhs.data = nullptr;
+	rhs.size = 0;
+}
+
+rave::FileMapping& rave::FileMapping::operator=(FileMapping&& rhs) noexcept
+{
+	if (this != &rhs)
+	{
+		Close();
+		data = rhs.data;
+		size = rhs.size;
+		rhs.data = nullptr;
+		rhs.size = 0;
+	}
+	return *this;
+}
+
+#ifdef RE_PLATFORM_WINDOWS
+rave::Result rave::FileMapping::Open(const char* filename)
+{
+	Close();
+
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		RETURN_FNF();
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		RETURN_MAP_FAIL();
+	}
+
+	// The view keeps the mapping object alive, so both handles can be closed straight away
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!mapping)
+		RETURN_MAP_FAIL();
+
+	data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	CloseHandle(mapping);
+	if (!data)
+		RETURN_MAP_FAIL();
+
+	size = static_cast<size_t>(fileSize.QuadPart);
+	return RE_SUCCESS;
+}
+
+void rave::FileMapping::Close() noexcept
+{
+	if (data)
+		UnmapViewOfFile(data);
+
+	data = nullptr;
+	size = 0;
+}
+#else
+rave::Result rave::FileMapping::Open(const char* filename)
+{
+	Close();
+
+	int fd = open(filename, O_RDONLY);
+	if (fd == -1)
+		RETURN_FNF();
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0)
+	{
+		close(fd);
+		RETURN_MAP_FAIL();
+	}
+
+	void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (view == MAP_FAILED)
+		RETURN_MAP_FAIL();
+
+	data = static_cast<const unsigned char*>(view);
+	size = static_cast<size_t>(info.st_size);
+	return RE_SUCCESS;
+}
+
+void rave::FileMapping::Close() noexcept
+{
+	if (data)
+		munmap(const_cast<unsigned char*>(data), size);
+
+	data = nullptr;
+	size = 0;
+}
+#endif
+
+bool rave::FileMapping::IsOpen() const noexcept
+{
+	return data;
+}
+
+const unsigned char* rave::FileMapping::Data() const noexcept
+{
+	return data;
+}
+
+size_t rave::FileMapping::Size() const noexcept
+{
+	return size;
+}
+
+rave::FileMapping::~FileMapping()
+{
+	Close();
+}
\ No newline at end of file
@@ -0,0 +1,226 @@
+#include "Engine/Utilities/Include/PixelConvert.h"
+#include "Engine/Utilities/Include/CpuFeatures.h"
+#include <stdint.h>
+
+#if defined(RE_ARCH_X86)
+#include <immintrin.h>
+#elif defined(RE_ARCH_NEON)
+#include <arm_neon.h>
+#endif
+
+// Every kernel handles as many whole blocks as it can and returns the number of pixels done,
+// the scalar loop finishes the rest. Blocks are fully loaded before they are stored, which is what makes
+// the in-place expansion safe: the bytes a block writes always lie below the bytes of the next block.
+
+static uint32_t PackKey(const rave::Color& key)
+{
+	return (uint32_t)key.r | ((uint32_t)key.g << 8) | ((uint32_t)key.b << 16);
+}
+
+template<bool Swap, bool Keyed>
+static void Expand3Scalar(const unsigned char* src, rave::Color* dst, size_t count, const rave::Color& key)
+{
+	for (size_t i = 0; i < count; i++, src += 3)
+	{
+		const unsigned char r = src[Swap ? 2 : 0];
+		const unsigned char g = src[1];
+		const unsigned char b = src[Swap ? 0 : 2];
+		const unsigned char a = (Keyed && r == key.r && g == key.g && b == key.b) ? 0 : 255;
+		dst[i] = rave::Color(r, g, b, a);
+	}
+}
+
+#if defined(RE_ARCH_X86)
+template<bool Swap>
+RE_TARGET("ssse3") static __m128i Expand3Mask()
+{
+	if constexpr (Swap)
+		return _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+	else
+		return _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+}
+
+template<bool Keyed>
+RE_TARGET("ssse3") static __m128i SetAlphaSSSE3(__m128i rgb, __m128i alpha, __m128i key)
+{
+	if constexpr (Keyed)
+		return _mm_or_si128(rgb, _mm_andnot_si128(_mm_cmpeq_epi32(rgb, key), alpha));
+	else
+		return _mm_or_si128(rgb, alpha);
+}
+
+template<bool Swap, bool Keyed>
+RE_TARGET("ssse3") static size_t Expand3SSSE3(const unsigned char* src, rave::Color* dst, size_t count, const rave::Color& key)
+{
+	const __m128i mask = Expand3Mask<Swap>();
+	const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+	const __m128i keyv = _mm_set1_epi32((int)PackKey(key));
+
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16, src += 48)
+	{
+		const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+		const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+		const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+
+		// Line every group of 4 pixels up at the start of a register
+		const __m128i p0 = _mm_shuffle_epi8(a, mask);
+		const __m128i p1 = _mm_shuffle_epi8(_mm_alignr_epi8(b, a, 12), mask);
+		const __m128i p2 = _mm_shuffle_epi8(_mm_alignr_epi8(c, b, 8), mask);
+		const __m128i p3 = _mm_shuffle_epi8(_mm_srli_si128(c, 4), mask);
+
+		__m128i* out = reinterpret_cast<__m128i*>(dst + i);
+		_mm_storeu_si128(out + 0, SetAlphaSSSE3<Keyed>(p0, alpha, keyv));
+		_mm_storeu_si128(out + 1, SetAlphaSSSE3<Keyed>(p1, alpha, keyv));
+		_mm_storeu_si128(out + 2, SetAlphaSSSE3<Keyed>(p2, alpha, keyv));
+		_mm_storeu_si128(out + 3, SetAlphaSSSE3<Keyed>(p3, alpha, keyv));
+	}
+	return i;
+}
+
+template<bool Swap, bool Keyed>
+RE_TARGET("avx2") static size_t Expand3AVX2(const unsigned char* src, rave::Color* dst, size_t count, const rave::Color& key)
+{
+	const __m256i mask = _mm256_broadcastsi128_si256(Expand3Mask<Swap>());
+	const __m256i spread = _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6);
+	const __m256i alpha = _mm256_set1_epi32((int)0xFF000000);
+	const __m256i keyv = _mm256_set1_epi32((int)PackKey(key));
+
+	// 8 pixels are 24 bytes but the load reads 32, so stop while that still lies inside src
+	size_t i = 0;
+	for (; i + 11 <= count; i += 8, src += 24)
+	{
+		// Move the second group of 4 pixels into the upper lane, then shuffle both lanes at once
+		const __m256i v = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)), spread);
+		const __m256i rgb = _mm256_shuffle_epi8(v, mask);
+
+		__m256i rgba;
+		if constexpr (Keyed)
+			rgba = _mm256_or_si256(rgb, _mm256_andnot_si256(_mm256_cmpeq_epi32(rgb, keyv), alpha));
+		else
+			rgba = _mm256_or_si256(rgb, alpha);
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), rgba);
+	}
+	return i;
+}
+
+RE_TARGET("ssse3") static size_t SwapSSSE3(const unsigned char* src, rave::Color* dst, size_t count)
+{
+	const __m128i mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4, src += 16)
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src)), mask));
+	return i;
+}
+
+RE_TARGET("avx2") static size_t SwapAVX2(const unsigned char* src, rave::Color* dst, size_t count)
+{
+	const __m256i mask = _mm256_setr_epi8(
+		2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+		2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15
+	);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8, src += 32)
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)), mask));
+	return i;
+}
+#elif defined(RE_ARCH_NEON)
+template<bool Swap, bool Keyed>
+static size_t Expand3NEON(const unsigned char* src, rave::Color* dst, size_t count, const rave::Color& key)
+{
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16, src += 48)
+	{
+		const uint8x16x3_t in = vld3q_u8(src);
+
+		uint8x16x4_t out;
+		out.val[0] = in.val[Swap ? 2 : 0];
+		out.val[1] = in.val[1];
+		out.val[2] = in.val[Swap ? 0 : 2];
+
+		if constexpr (Keyed)
+		{
+			const uint8x16_t r = vceqq_u8(out.val[0], vdupq_n_u8(key.r));
+			const uint8x16_t g = vceqq_u8(out.val[1], vdupq_n_u8(key.g));
+			const uint8x16_t b = vceqq_u8(out.val[2], vdupq_n_u8(key.b));
+			out.val[3] = vmvnq_u8(vandq_u8(vandq_u8(r, g), b));
+		}
+		else
+		{
+			out.val[3] = vdupq_n_u8(255);
+		}
+
+		vst4q_u8(reinterpret_cast<unsigned char*>(dst + i), out);
+	}
+	return i;
+}
+
+static size_t SwapNEON(const unsigned char* src, rave::Color* dst, size_t count)
+{
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16, src += 64)
+	{
+		uint8x16x4_t v = vld4q_u8(src);
+		const uint8x16_t r = v.val[2];
+		v.val[2] = v.val[0];
+		v.val[0] = r;
+		vst4q_u8(reinterpret_cast<unsigned char*>(dst + i), v);
+	}
+	return i;
+}
+#endif
+
+template<bool Swap, bool Keyed>
+static void Expand3(const unsigned char* src, rave::Color* dst, size_t count, const rave::Color& key)
+{
+	size_t done = 0;
+
+#if defined(RE_ARCH_X86)
+	const rave::CpuFeatures& cpu = rave::GetCpuFeatures();
+	if (cpu.avx2)
+		done = Expand3AVX2<Swap, Keyed>(src, dst, count, key);
+	else if (cpu.ssse3)
+		done = Expand3SSSE3<Swap, Keyed>(src, dst, count, key);
+#elif defined(RE_ARCH_NEON)
+	done = Expand3NEON<Swap, Keyed>(src, dst, count, key);
+#endif
+
+	Expand3Scalar<Swap, Keyed>(src + done * 3, dst + done, count - done, key);
+}
+
+void rave::ConvertRGBToRGBA(const unsigned char* src, Color* dst, size_t count) noexcept
+{
+	Expand3<false, false>(src, dst, count, Color());
+}
+
+void rave::ConvertBGRToRGBA(const unsigned char* src, Color* dst, size_t count) noexcept
+{
+	Expand3<true, false>(src, dst, count, Color());
+}
+
+void rave::ConvertRGBToRGBAKeyed(const unsigned char* src, Color* dst, size_t count, const Color& key) noexcept
+{
+	Expand3<false, true>(src, dst, count, key);
+}
+
+void rave::ConvertBGRAToRGBA(const unsigned char* src, Color* dst, size_t count) noexcept
+{
+	size_t done = 0;
+
+#if defined(RE_ARCH_X86)
+	const CpuFeatures& cpu = GetCpuFeatures();
+	if (cpu.avx2)
+		done = SwapAVX2(src, dst, count);
+	else if (cpu.ssse3)
+		done = SwapSSSE3(src, dst, count);
+#elif defined(RE_ARCH_NEON)
+	done = SwapNEON(src, dst, count);
+#endif
+
+	src += done * 4;
+	for (size_t i = done; i < count; i++, src += 4)
+		dst[i] = Color(src[2], src[1], src[0], src[3]);
+}
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include "Engine/Utilities/Include/ThreadPool.h"
+#include <atomic>
+#include <algorithm>
+#include <exception>
+
+// The pool whose worker the current thread is, if any
+static thread_local const rave::ThreadPool* currentPool = nullptr;
+
+rave::ThreadPool::ThreadPool(size_t threadCount)
+{
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+	workers.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; i++)
+		workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+void rave::ThreadPool::Push(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push(std::move(job));
+	}
+	jobAvailable.notify_one();
+}
+
+void rave::ThreadPool::Wait()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	jobsDone.wait(lock, [this]() { return jobs.empty() && activeJobs == 0; });
+}
+
+void rave::ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& job)
+{
+	if (count == 0)
+		return;
+
+	// One job per worker, each claiming indices until none are left, so slow items don't stall a fixed partition
+	std::atomic<size_t> next = 0;
+	std::atomic<size_t> remaining = std::min(count, workers.size());
+	std::mutex doneMutex;
+	std::condition_variable done;
+	std::exception_ptr exception;
+
+	const size_t jobCount = remaining;
+	for (size_t i = 0; i < jobCount; i++)
+	{
+		Push([&]()
+		{
+			try
+			{
+				for (size_t index = next++; index < count; index = next++)
+					job(index);
+			}
+			catch (...)
+			{
+				// Keep the first exception for the caller and leave the unclaimed indices alone
+				std::lock_guard<std::mutex> lock(doneMutex);
+				if (!exception)
+					exception = std::current_exception();
+				next = count;
+			}
+
+			std::lock_guard<std::mutex> lock(doneMutex);
+			if (--remaining == 0)
+				done.notify_one();
+		});
+	}
+
+	std::unique_lock<std::mutex> lock(doneMutex);
+	done.wait(lock, [&]() { return remaining == 0; });
+
+	if (exception)
+		std::rethrow_exception(exception);
+}
+
+size_t rave::ThreadPool::GetThreadCount() const noexcept
+{
+	return workers.size();
+}
+
+bool rave::ThreadPool::IsWorkerThread() const noexcept
+{
+	return currentPool == this;
+}
+
+bool rave::ThreadPool::OnAnyWorkerThread() noexcept
+{
+	return currentPool != nullptr;
+}
+
+rave::ThreadPool& rave::ThreadPool::GetShared()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+rave::ThreadPool* rave::ThreadPool::ForCaller(ThreadPool* pRequested)
+{
+	// Waiting on the pool from one of its workers takes that worker away from the jobs, with every worker doing it nothing runs.
+	// Without a requested pool, a caller on any worker is one of a batch that already keeps every core busy
+	if (pRequested)
+		return pRequested->IsWorkerThread() ? nullptr : pRequested;
+	return OnAnyWorkerThread() ? nullptr : &GetShared();
+}
+
+void rave::ThreadPool::WorkerLoop()
+{
+	currentPool = this;
+	while (true)
+	{
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			jobAvailable.wait(lock, [this]() { return stopping || !jobs.empty(); });
+			if (stopping && jobs.empty())
+				return;
+
+			job = std::move(jobs.front());
+			jobs.pop();
+			activeJobs++;
+		}
+
+		job();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			activeJobs--;
+			if (jobs.empty() && activeJobs == 0)
+				jobsDone.notify_all();
+		}
+	}
+}
+
+rave::ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	jobAvailable.notify_all();
+
+	for (std::thread& worker : workers)
+		worker.join();
+}
\ No newline at end of file
@@ -4,73 +4,105 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include <sys/types.h>
-#include <sys/stat.h>
-#include <fcntl.h>
-#ifdef _WIN32
-#include <io.h>
-#else
-#include <unistd.h>
-#endif
 
 #define MIN(A, B) ((A) < (B) ? (A) : (B))
 #define MAX(A, B) ((A) > (B) ? (A) : (B))
 
+/* Every LZW string is a copy of something that was already decoded,
+ * so a table entry only records where in the output it was last written. */
 typedef struct Entry {
+    uint32_t offset;
     uint16_t length;
-    uint16_t prefix;
-    uint8_t  suffix;
 } Entry;
 
-typedef struct Table {
-    int bulk;
-    int nentries;
-    Entry *entries;
-} Table;
+/* Sub-block framed LZW code stream, read through a 64-bit bit buffer. */
+typedef struct BitReader {
+    uint64_t bits;
+    int nbits;
+    uint8_t sub_len;
+    int ended;
+} BitReader;
+
+/* All input comes from the in-memory buffer through gif->pos.
+ * Reads past the end of the buffer yield zeroes, skips stop at the end. */
+static uint8_t
+read_byte(gd_GIF *gif)
+{
+    return gif->pos < gif->end ? *gif->pos++ : 0;
+}
+
+static void
+read_bytes(gd_GIF *gif, void *buf, size_t n)
+{
+    size_t avail = (size_t) (gif->end - gif->pos);
+
+    if (n > avail) {
+        memset((uint8_t *) buf + avail, 0, n - avail);
+        n = avail;
+    }
+    memcpy(buf, gif->pos, n);
+    gif->pos += n;
+}
+
+static void
+skip_bytes(gd_GIF *gif, size_t n)
+{
+    gif->pos += MIN(n, (size_t) (gif->end - gif->pos));
+}
 
 static uint16_t
-read_num(int fd)
+read_num(gd_GIF *gif)
 {
-    uint8_t bytes[2];
+    uint16_t lo = read_byte(gif);
+    return lo + (((uint16_t) read_byte(gif)) << 8);
+}
 
-    read(fd, bytes, 2);
-    return bytes[0] + (((uint16_t) bytes[1]) << 8);
+/* Fill the canvas with the background color, as it is before the first frame. */
+static void
+reset_canvas(gd_GIF *gif)
+{
+    int i;
+    uint8_t *bgcolor;
+
+    memset(gif->frame, gif->bgindex, gif->width * gif->height);
+    bgcolor = &gif->palette->colors[gif->bgindex*3];
+    if (bgcolor[0] || bgcolor[1] || bgcolor [2])
+        for (i = 0; i < gif->width * gif->height; i++)
+            memcpy(&gif->canvas[i*3], bgcolor, 3);
+    else
+        memset(gif->canvas, 0, gif->width * gif->height * 3);
 }
 
-gd_GIF *
-gd_open_gif(const char *fname)
+static gd_GIF *
+gd_open(const uint8_t *data, size_t size, uint8_t *owned)
 {
-    int fd;
+    gd_GIF src;
     uint8_t sigver[3];
     uint16_t width, height, depth;
     uint8_t fdsz, bgidx, aspect;
-    int i;
-    uint8_t *bgcolor;
     int gct_sz;
     gd_GIF *gif;
 
-    fd = open(fname, O_RDONLY);
-    if (fd == -1) return NULL;
-#ifdef _WIN32
-    setmode(fd, O_BINARY);
-#endif
+    memset(&src, 0, sizeof(src));
+    src.data = src.pos = data;
+    src.end = data + size;
     /* Header */
-    read(fd, sigver, 3);
+    read_bytes(&src, sigver, 3);
     if (memcmp(sigver, "GIF", 3) != 0) {
         fprintf(stderr, "invalid signature\n");
         goto fail;
     }
     /* Version */
-    read(fd, sigver, 3);
+    read_bytes(&src, sigver, 3);
     if (memcmp(sigver, "89a", 3) != 0) {
         fprintf(stderr, "invalid version\n");
         goto fail;
     }
     /* Width x Height */
-    width  = read_num(fd);
-    height = read_num(fd);
+    width  = read_num(&src);
+    height = read_num(&src);
     /* FDSZ */
-    read(fd, &fdsz, 1);
+    fdsz = read_byte(&src);
     /* Presence of GCT */
     if (!(fdsz & 0x80)) {
         fprintf(stderr, "no global color table\n");
@@ -82,46 +114,75 @@ gd_open_gif(const char *fname)
     /* GCT Size */
     gct_sz = 1 << ((fdsz & 0x07) + 1);
     /* Background Color Index */
-    read(fd, &bgidx, 1);
+    bgidx = read_byte(&src);
     /* Aspect Ratio */
-    read(fd, &aspect, 1);
+    aspect = read_byte(&src);
     /* Create gd_GIF Structure. */
     gif = (gd_GIF*)calloc(1, sizeof(*gif) + 4 * width * height);
     if (!gif) goto fail;
-    gif->fd = fd;
+    gif->data = data;
+    gif->size = size;
+    gif->end = src.end;
+    gif->pos = src.pos;
+    gif->owned = owned;
     gif->width  = width;
     gif->height = height;
     gif->depth  = depth;
     /* Read GCT */
     gif->gct.size = gct_sz;
-    read(fd, gif->gct.colors, 3 * gif->gct.size);
+    read_bytes(gif, gif->gct.colors, 3 * gif->gct.size);
     gif->palette = &gif->gct;
     gif->bgindex = bgidx;
     gif->canvas = (uint8_t *) &gif[1];
     gif->frame = &gif->canvas[3 * width * height];
-    if (gif->bgindex)
-        memset(gif->frame, gif->bgindex, gif->width * gif->height);
-    bgcolor = &gif->palette->colors[gif->bgindex*3];
-    if (bgcolor[0] || bgcolor[1] || bgcolor [2])
-        for (i = 0; i < gif->width * gif->height; i++)
-            memcpy(&gif->canvas[i*3], bgcolor, 3);
-    gif->anim_start = lseek(fd, 0, SEEK_CUR);
+    reset_canvas(gif);
+    gif->anim_start = gif->pos;
     goto ok;
 fail:
-    close(fd);
+    free(owned);
     gif = NULL;
 ok:
     return gif;
 }
 
+gd_GIF *
+gd_open_gif(const char *fname)
+{
+    FILE *file;
+    long size;
+    uint8_t *data;
+
+    /* Read the whole file at once, decoding then never touches the file again. */
+    file = fopen(fname, "rb");
+    if (!file) return NULL;
+    data = NULL;
+    if (fseek(file, 0, SEEK_END) == 0 && (size = ftell(file)) > 0 && fseek(file, 0, SEEK_SET) == 0) {
+        data = (uint8_t *) malloc((size_t) size);
+        if (data && fread(data, 1, (size_t) size, file) != (size_t) size) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(file);
+    if (!data) return NULL;
+    return gd_open(data, (size_t) size, data);
+}
+
+gd_GIF *
+gd_open_gif_memory(const void *data, size_t size)
+{
+    if (!data || !size) return NULL;
+    return gd_open((const uint8_t *) data, size, NULL);
+}
+
 static void
 discard_sub_blocks(gd_GIF *gif)
 {
     uint8_t size;
 
     do {
-        read(gif->fd, &size, 1);
-        lseek(gif->fd, size, SEEK_CUR);
+        size = read_byte(gif);
+        skip_bytes(gif, size);
     } while (size);
 }
 
@@ -131,22 +192,22 @@ read_plain_text_ext(gd_GIF *gif)
     if (gif->plain_text) {
         uint16_t tx, ty, tw, th;
         uint8_t cw, ch, fg, bg;
-        off_t sub_block;
-        lseek(gif->fd, 1, SEEK_CUR); /* block size = 12 */
-        tx = read_num(gif->fd);
-        ty = read_num(gif->fd);
-        tw = read_num(gif->fd);
-        th = read_num(gif->fd);
-        read(gif->fd, &cw, 1);
-        read(gif->fd, &ch, 1);
-        read(gif->fd, &fg, 1);
-        read(gif->fd, &bg, 1);
-        sub_block = lseek(gif->fd, 0, SEEK_CUR);
+        const uint8_t *sub_block;
+        skip_bytes(gif, 1); /* block size = 12 */
+        tx = read_num(gif);
+        ty = read_num(gif);
+        tw = read_num(gif);
+        th = read_num(gif);
+        cw = read_byte(gif);
+        ch = read_byte(gif);
+        fg = read_byte(gif);
+        bg = read_byte(gif);
+        sub_block = gif->pos;
         gif->plain_text(gif, tx, ty, tw, th, cw, ch, fg, bg);
-        lseek(gif->fd, sub_block, SEEK_SET);
+        gif->pos = sub_block;
     } else {
         /* Discard plain text metadata. */
-        lseek(gif->fd, 13, SEEK_CUR);
+        skip_bytes(gif, 13);
     }
     /* Discard plain text sub-blocks. */
     discard_sub_blocks(gif);
@@ -158,24 +219,24 @@ read_graphic_control_ext(gd_GIF *gif)
     uint8_t rdit;
 
     /* Discard block size (always 0x04). */
-    lseek(gif->fd, 1, SEEK_CUR);
-    read(gif->fd, &rdit, 1);
+    skip_bytes(gif, 1);
+    rdit = read_byte(gif);
     gif->gce.disposal = (rdit >> 2) & 3;
     gif->gce.input = rdit & 2;
     gif->gce.transparency = rdit & 1;
-    gif->gce.delay = read_num(gif->fd);
-    read(gif->fd, &gif->gce.tindex, 1);
+    gif->gce.delay = read_num(gif);
+    gif->gce.tindex = read_byte(gif);
     /* Skip block terminator. */
-    lseek(gif->fd, 1, SEEK_CUR);
+    skip_bytes(gif, 1);
 }
 
 static void
 read_comment_ext(gd_GIF *gif)
 {
     if (gif->comment) {
-        off_t sub_block = lseek(gif->fd, 0, SEEK_CUR);
+        const uint8_t *sub_block = gif->pos;
         gif->comment(gif);
-        lseek(gif->fd, sub_block, SEEK_SET);
+        gif->pos = sub_block;
     }
     /* Discard comment sub-blocks. */
     discard_sub_blocks(gif);
@@ -188,21 +249,21 @@ read_application_ext(gd_GIF *gif)
     char app_auth_code[3];
 
     /* Discard block size (always 0x0B). */
-    lseek(gif->fd, 1, SEEK_CUR);
+    skip_bytes(gif, 1);
     /* Application Identifier. */
-    read(gif->fd, app_id, 8);
+    read_bytes(gif, app_id, 8);
     /* Application Authentication Code. */
-    read(gif->fd, app_auth_code, 3);
+    read_bytes(gif, app_auth_code, 3);
     if (!strncmp(app_id, "NETSCAPE", sizeof(app_id))) {
         /* Discard block size (0x03) and constant byte (0x01). */
-        lseek(gif->fd, 2, SEEK_CUR);
-        gif->loop_count = read_num(gif->fd);
+        skip_bytes(gif, 2);
+        gif->loop_count = read_num(gif);
         /* Skip block terminator. */
-        lseek(gif->fd, 1, SEEK_CUR);
+        skip_bytes(gif, 1);
     } else if (gif->application) {
-        off_t sub_block = lseek(gif->fd, 0, SEEK_CUR);
+        const uint8_t *sub_block = gif->pos;
         gif->application(gif, app_id, app_auth_code);
-        lseek(gif->fd, sub_block, SEEK_SET);
+        gif->pos = sub_block;
         discard_sub_blocks(gif);
     } else {
         discard_sub_blocks(gif);
@@ -214,7 +275,7 @@ read_ext(gd_GIF *gif)
 {
     uint8_t label;
 
-    read(gif->fd, &label, 1);
+    label = read_byte(gif);
     switch (label) {
     case 0x01:
         read_plain_text_ext(gif);
@@ -233,69 +294,131 @@ read_ext(gd_GIF *gif)
     }
 }
 
-static Table *
-new_table(int key_size)
+static void
+refill_bits(gd_GIF *gif, BitReader *br)
 {
-    int key;
-    int init_bulk = MAX(1 << (key_size + 1), 0x100);
-    Table *table = (Table*)malloc(sizeof(*table) + sizeof(Entry) * init_bulk);
-    if (table) {
-        table->bulk = init_bulk;
-        table->nentries = (1 << key_size) + 2;
-        table->entries = (Entry *) &table[1];
-        for (key = 0; key < (1 << key_size); key++)
-            table->entries[key] = Entry{ 1, 0xFFF, (uint8_t)key };
+    uint64_t chunk;
+    int count;
+
+    while (br->nbits < 56 && !br->ended) {
+        if (br->sub_len == 0) {
+            br->sub_len = read_byte(gif);
+            if (br->sub_len == 0) {
+                br->ended = 1;
+                break;
+            }
+        }
+        /* Take whole bytes straight from the block when there are enough of them. */
+        count = (63 - br->nbits) >> 3;
+        if (br->sub_len >= count && gif->end - gif->pos >= 8) {
+            memcpy(&chunk, gif->pos, 8);
+            chunk &= ((uint64_t) 1 << (count * 8)) - 1;
+            br->bits |= chunk << br->nbits;
+            br->nbits += count * 8;
+            br->sub_len -= (uint8_t) count;
+            gif->pos += count;
+        } else {
+            br->bits |= (uint64_t) read_byte(gif) << br->nbits;
+            br->nbits += 8;
+            br->sub_len--;
+        }
     }
-    return table;
 }
 
-/* Add table entry. Return value:
- *  0 on success
- *  +1 if key size must be incremented after this addition
- *  -1 if could not realloc table */
+/* Return the next code, or -1 when the data runs out. */
 static int
-add_entry(Table **tablep, uint16_t length, uint16_t prefix, uint8_t suffix)
+get_key(gd_GIF *gif, BitReader *br, int key_size)
 {
-    Table *table = *tablep;
-    if (table->nentries == table->bulk) {
-        table->bulk *= 2;
-        table = (Table*)realloc(table, sizeof(*table) + sizeof(Entry) * table->bulk);
-        if (!table) return -1;
-        table->entries = (Entry *) &table[1];
-        *tablep = table;
+    int key;
+
+    if (br->nbits < key_size) {
+        refill_bits(gif, br);
+        if (br->nbits < key_size)
+            return -1;
     }
-    table->entries[table->nentries] = Entry{length, prefix, suffix};
-    table->nentries++;
-    if ((table->nentries & (table->nentries - 1)) == 0)
-        return 1;
-    return 0;
+    key = (int) (br->bits & ((1u << key_size) - 1));
+    br->bits >>= key_size;
+    br->nbits -= key_size;
+    return key;
 }
 
-static uint16_t
-get_key(gd_GIF *gif, int key_size, uint8_t *sub_len, uint8_t *shift, uint8_t *byte)
+/* Copy an earlier string. Short strings are copied 8 bytes at a time, which may write
+ * past the string; that is harmless since those bytes get overwritten by what follows.
+ * A chunk may overlap the bytes it writes, as in the KwKwK case where the string ends
+ * right at dst, so it has to be a memmove; it compiles to the same load and store. */
+static void
+copy_string(uint8_t *out, uint32_t dst, uint32_t src, int length, uint32_t size)
+{
+    int i;
+
+    if (length <= 16 && dst + 16 <= size) {
+        for (i = 0; i < length; i += 8)
+            memmove(&out[dst + i], &out[src + i], 8);
+    } else {
+        memcpy(&out[dst], &out[src], length);
+    }
+}
+
+/* Decode LZW data into the linear buffer out of the given size.
+ * Return the number of pixels decoded. */
+static uint32_t
+decode_lzw(gd_GIF *gif, int min_key_size, uint8_t *out, uint32_t size)
 {
-    int bits_read;
-    int rpad;
-    int frag_size;
-    uint16_t key;
-
-    key = 0;
-    for (bits_read = 0; bits_read < key_size; bits_read += frag_size) {
-        rpad = (*shift + bits_read) % 8;
-        if (rpad == 0) {
-            /* Update byte. */
-            if (*sub_len == 0)
-                read(gif->fd, sub_len, 1); /* Must be nonzero! */
-            read(gif->fd, byte, 1);
-            (*sub_len)--;
+    Entry table[0x1000];
+    BitReader br;
+    int key_size, key, clear, stop, next, prev_length, length;
+    uint32_t n, prev_offset;
+
+    memset(&br, 0, sizeof(br));
+    clear = 1 << min_key_size;
+    stop = clear + 1;
+    key_size = min_key_size + 1;
+    next = clear + 2;
+    prev_length = 0;
+    prev_offset = 0;
+    n = 0;
+    while (n < size) {
+        key = get_key(gif, &br, key_size);
+        if (key == -1 || key == stop)
+            break;
+        if (key == clear) {
+            key_size = min_key_size + 1;
+            next = clear + 2;
+            prev_length = 0;
+            continue;
+        }
+        if (key < clear) {
+            out[n] = (uint8_t) key;
+            length = 1;
+        } else if (key < next && prev_length) {
+            length = table[key].length;
+            if (n + length > size)
+                length = (int) (size - n);
+            copy_string(out, n, table[key].offset, length, size);
+        } else if (key == next && prev_length) {
+            /* The code being defined right now: the previous string plus its own first pixel. */
+            length = prev_length + 1;
+            if (n + length > size)
+                length = (int) (size - n);
+            copy_string(out, n, prev_offset, length - 1, size);
+            out[n + length - 1] = out[prev_offset];
+        } else {
+            /* Invalid code */
+            break;
+        }
+        /* The previous string followed by this one's first pixel is already laid out at prev_offset. */
+        if (prev_length && next < 0x1000) {
+            table[next].offset = prev_offset;
+            table[next].length = (uint16_t) (prev_length + 1);
+            next++;
+            if (next == (1 << key_size) && key_size < 12)
+                key_size++;
         }
-        frag_size = MIN(key_size - bits_read, 8 - rpad);
-        key |= ((uint16_t) ((*byte) >> rpad)) << bits_read;
+        prev_offset = n;
+        prev_length = length;
+        n += length;
     }
-    /* Clear extra bits to the left. */
-    key &= (1 << key_size) - 1;
-    *shift = (*shift + key_size) % 8;
-    return key;
+    return n;
 }
 
 /* Compute output index of y-th input line, in frame of height h. */
@@ -321,75 +444,51 @@ interlaced_line_index(int h, int y)
 }
 
 /* Decompress image pixels.
- * Return 0 on success or -1 on out-of-memory (w.r.t. LZW code table). */
+ * Return 0 on success or -1 on out-of-memory. */
 static int
 read_image_data(gd_GIF *gif, int interlace)
 {
-    uint8_t sub_len, shift, byte;
-    int init_key_size, key_size, table_is_full;
-    int frm_off, str_len, p, x, y;
-    uint16_t key, clear, stop;
-    int ret;
-    Table *table;
-    Entry entry;
-    off_t start, end;
-
-    read(gif->fd, &byte, 1);
-    key_size = (int) byte;
-    start = lseek(gif->fd, 0, SEEK_CUR);
+    int min_key_size, direct, y, line, width;
+    uint32_t size, decoded, row, count;
+    const uint8_t *start, *end;
+    uint8_t *out;
+
+    min_key_size = (int) read_byte(gif);
+    /* Find the end of the image data first, the decoder might not consume all of it. */
+    start = gif->pos;
     discard_sub_blocks(gif);
-    end = lseek(gif->fd, 0, SEEK_CUR);
-    lseek(gif->fd, start, SEEK_SET);
-    clear = 1 << key_size;
-    stop = clear + 1;
-    table = new_table(key_size);
-    key_size++;
-    init_key_size = key_size;
-    sub_len = shift = 0;
-    key = get_key(gif, key_size, &sub_len, &shift, &byte); /* clear code */
-    frm_off = 0;
-    ret = 0;
-    while (1) {
-        if (key == clear) {
-            key_size = init_key_size;
-            table->nentries = (1 << (key_size - 1)) + 2;
-            table_is_full = 0;
-        } else if (!table_is_full) {
-            ret = add_entry(&table, str_len + 1, key, entry.suffix);
-            if (ret == -1) {
-                free(table);
-                return -1;
-            }
-            if (table->nentries == 0x1000) {
-                ret = 0;
-                table_is_full = 1;
-            }
+    end = gif->pos;
+    gif->pos = start;
+    if (min_key_size > 11) {
+        gif->pos = end;
+        return 0;
+    }
+    size = (uint32_t) gif->fw * gif->fh;
+    /* Rows of a full width, progressive frame are contiguous, so it can be decoded in place. */
+    direct = !interlace && gif->fx == 0 && gif->fw == gif->width && gif->fy + gif->fh <= gif->height;
+    if (direct) {
+        out = &gif->frame[gif->fy * gif->width];
+    } else {
+        out = (uint8_t *) malloc(size ? size : 1);
+        if (!out) {
+            gif->pos = end;
+            return -1;
         }
-        key = get_key(gif, key_size, &sub_len, &shift, &byte);
-        if (key == clear) continue;
-        if (key == stop) break;
-        if (ret == 1) key_size++;
-        entry = table->entries[key];
-        str_len = entry.length;
-        while (1) {
-            p = frm_off + entry.length - 1;
-            x = p % gif->fw;
-            y = p / gif->fw;
-            if (interlace)
-                y = interlaced_line_index((int) gif->fh, y);
-            gif->frame[(gif->fy + y) * gif->width + gif->fx + x] = entry.suffix;
-            if (entry.prefix == 0xFFF)
-                break;
-            else
-                entry = table->entries[entry.prefix];
+    }
+    decoded = decode_lzw(gif, min_key_size, out, size);
+    if (!direct) {
+        /* Place the rows in the canvas, only as far as the data went. */
+        width = MIN(gif->fw, MAX(gif->width - gif->fx, 0));
+        for (y = 0, row = 0; y < gif->fh && row < decoded; y++, row += gif->fw) {
+            line = interlace ? interlaced_line_index((int) gif->fh, y) : y;
+            if (gif->fy + line >= gif->height)
+                continue;
+            count = MIN((uint32_t) width, decoded - row);
+            memcpy(&gif->frame[(gif->fy + line) * gif->width + gif->fx], &out[row], count);
         }
-        frm_off += str_len;
-        if (key < table->nentries - 1 && !table_is_full)
-            table->entries[table->nentries - 1].suffix = entry.suffix;
+        free(out);
     }
-    free(table);
-    read(gif->fd, &sub_len, 1); /* Must be zero! */
-    lseek(gif->fd, end, SEEK_SET);
+    gif->pos = end;
     return 0;
 }
 
@@ -402,18 +501,18 @@ read_image(gd_GIF *gif)
     int interlace;
 
     /* Image Descriptor. */
-    gif->fx = read_num(gif->fd);
-    gif->fy = read_num(gif->fd);
-    gif->fw = read_num(gif->fd);
-    gif->fh = read_num(gif->fd);
-    read(gif->fd, &fisrz, 1);
+    gif->fx = read_num(gif);
+    gif->fy = read_num(gif);
+    gif->fw = read_num(gif);
+    gif->fh = read_num(gif);
+    fisrz = read_byte(gif);
     interlace = fisrz & 0x40;
     /* Ignore Sort Flag. */
     /* Local Color Table? */
     if (fisrz & 0x80) {
         /* Read LCT */
         gif->lct.size = 1 << ((fisrz & 0x07) + 1);
-        read(gif->fd, gif->lct.colors, 3 * gif->lct.size);
+        read_bytes(gif, gif->lct.colors, 3 * gif->lct.size);
         gif->palette = &gif->lct;
     } else
         gif->palette = &gif->gct;
@@ -468,14 +567,14 @@ gd_get_frame(gd_GIF *gif)
     char sep;
 
     dispose(gif);
-    read(gif->fd, &sep, 1);
+    sep = (char) read_byte(gif);
     while (sep != ',') {
         if (sep == ';')
             return 0;
         if (sep == '!')
             read_ext(gif);
         else return -1;
-        read(gif->fd, &sep, 1);
+        sep = (char) read_byte(gif);
     }
     if (read_image(gif) == -1)
         return -1;
@@ -495,15 +594,21 @@ gd_is_bgcolor(gd_GIF *gif, const uint8_t color[3])
     return !memcmp(&gif->palette->colors[gif->bgindex*3], color, 3);
 }
 
+/* Go back to the first frame. The canvas and the state of the previous frame are
+ * reset as well, otherwise the first frame would be composed onto the last one. */
 void
 gd_rewind(gd_GIF *gif)
 {
-    lseek(gif->fd, gif->anim_start, SEEK_SET);
+    gif->pos = gif->anim_start;
+    memset(&gif->gce, 0, sizeof(gif->gce));
+    gif->fx = gif->fy = gif->fw = gif->fh = 0;
+    gif->palette = &gif->gct;
+    reset_canvas(gif);
 }
 
 void
 gd_close_gif(gd_GIF *gif)
 {
-    close(gif->fd);
+    free(gif->owned);
     free(gif);
 }
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <stdint.h>
-#include <sys/types.h>
+#include <stddef.h>
 
 typedef struct gd_Palette {
     int size;
@@ -17,8 +17,11 @@ typedef struct gd_GCE {
 } gd_GCE;
 
 typedef struct gd_GIF {
-    int fd;
-    off_t anim_start;
+    const uint8_t *data;
+    size_t size;
+    const uint8_t *pos, *end;
+    const uint8_t *anim_start;
+    uint8_t *owned;
     uint16_t width, height;
     uint16_t depth;
     uint16_t loop_count;
@@ -38,6 +41,7 @@ typedef struct gd_GIF {
 } gd_GIF;
 
 gd_GIF *gd_open_gif(const char *fname);
+gd_GIF *gd_open_gif_memory(const void *data, size_t size);
 int gd_get_frame(gd_GIF *gif);
 void gd_render_frame(gd_GIF *gif, uint8_t *buffer);
 int gd_is_bgcolor(gd_GIF *gif, const uint8_t color[3]);
@@ -12,6 +12,7 @@
 #define JPEG_INTERNALS
 #include "jinclude.h"
 #include "jpeglib.h"
+#include "jsimd.h"
 
 
 /* Private subobject */
@@ -24,6 +25,9 @@ typedef struct {
   int * Cb_b_tab;		/* => table for Cb to B conversion */
   INT32 * Cr_g_tab;		/* => table for Cr to G conversion */
   INT32 * Cb_g_tab;		/* => table for Cb to G conversion */
+#ifdef JSIMD_SUPPORTED
+  jsimd_ycc_rgb_ptr ycc_rgb_row; /* => SIMD kernel, if one was selected */
+#endif
 
   /* Private state for RGB->Y conversion */
   INT32 * rgb_y_tab;		/* => table for RGB to Y conversion */
@@ -178,6 +182,31 @@ ycc_rgb_convert (j_decompress_ptr cinfo,
 }
 
 
+#ifdef JSIMD_SUPPORTED
+
+/*
+ * The same conversion done by a SIMD kernel, a row at a time.
+ */
+
+METHODDEF(void)
+ycc_rgb_convert_simd (j_decompress_ptr cinfo,
+		      JSAMPIMAGE input_buf, JDIMENSION input_row,
+		      JSAMPARRAY output_buf, int num_rows)
+{
+  my_cconvert_ptr cconvert = (my_cconvert_ptr) cinfo->cconvert;
+
+  while (--num_rows >= 0) {
+    (*cconvert->ycc_rgb_row) (input_buf[0][input_row],
+			      input_buf[1][input_row],
+			      input_buf[2][input_row],
+			      *output_buf++, cinfo->output_width);
+    input_row++;
+  }
+}
+
+#endif /* JSIMD_SUPPORTED */
+
+
 /**************** Cases other than YCbCr -> RGB **************/
 
 
@@ -571,6 +600,10 @@ jinit_color_deconverter (j_decompress_ptr cinfo)
     cinfo->out_color_components = RGB_PIXELSIZE;
     if (cinfo->jpeg_color_space == JCS_YCbCr) {
       cconvert->pub.color_convert = ycc_rgb_convert;
+#ifdef JSIMD_SUPPORTED
+      if ((cconvert->ycc_rgb_row = jsimd_ycc_rgb_method(FALSE)) != NULL)
+	cconvert->pub.color_convert = ycc_rgb_convert_simd;
+#endif
       build_ycc_rgb_table(cinfo);
     } else if (cinfo->jpeg_color_space == JCS_GRAYSCALE) {
       cconvert->pub.color_convert = gray_rgb_convert;
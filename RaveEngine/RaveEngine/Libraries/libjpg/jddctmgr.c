@@ -20,6 +20,7 @@
 #include "jinclude.h"
 #include "jpeglib.h"
 #include "jdct.h"		/* Private declarations for DCT subsystem */
+#include "jsimd.h"
 
 
 /*
@@ -256,6 +257,10 @@ start_pass (j_decompress_ptr cinfo)
 	       compptr->DCT_h_scaled_size, compptr->DCT_v_scaled_size);
       break;
     }
+#ifdef JSIMD_SUPPORTED
+    /* Same results, computed with SSE2 or AVX2 where available */
+    method_ptr = jsimd_idct_method(method_ptr);
+#endif
     idct->pub.inverse_DCT[ci] = method_ptr;
     /* Create multiplier table from quant table.
      * However, we can skip this if the component is uninteresting
@@ -35,6 +35,7 @@
 #define JPEG_INTERNALS
 #include "jinclude.h"
 #include "jpeglib.h"
+#include "jsimd.h"
 
 #ifdef UPSAMPLE_MERGING_SUPPORTED
 
@@ -54,6 +55,9 @@ typedef struct {
   int * Cb_b_tab;		/* => table for Cb to B conversion */
   INT32 * Cr_g_tab;		/* => table for Cr to G conversion */
   INT32 * Cb_g_tab;		/* => table for Cb to G conversion */
+#ifdef JSIMD_SUPPORTED
+  jsimd_ycc_rgb_ptr ycc_rgb_row; /* => SIMD kernel, if one was selected */
+#endif
 
   /* For 2:1 vertical sampling, we produce two output rows at a time.
    * We need a "spare" row buffer to hold the second output row if the
@@ -358,6 +362,46 @@ h2v2_merged_upsample (j_decompress_ptr cinfo,
 }
 
 
+#ifdef JSIMD_SUPPORTED
+
+/*
+ * The h2v1 and h2v2 cases done by a SIMD kernel, a row at a time.
+ */
+
+METHODDEF(void)
+h2v1_merged_upsample_simd (j_decompress_ptr cinfo,
+			   JSAMPIMAGE input_buf, JDIMENSION in_row_group_ctr,
+			   JSAMPARRAY output_buf)
+{
+  my_upsample_ptr upsample = (my_upsample_ptr) cinfo->upsample;
+
+  (*upsample->ycc_rgb_row) (input_buf[0][in_row_group_ctr],
+			    input_buf[1][in_row_group_ctr],
+			    input_buf[2][in_row_group_ctr],
+			    output_buf[0], cinfo->output_width);
+}
+
+
+METHODDEF(void)
+h2v2_merged_upsample_simd (j_decompress_ptr cinfo,
+			   JSAMPIMAGE input_buf, JDIMENSION in_row_group_ctr,
+			   JSAMPARRAY output_buf)
+{
+  my_upsample_ptr upsample = (my_upsample_ptr) cinfo->upsample;
+
+  (*upsample->ycc_rgb_row) (input_buf[0][in_row_group_ctr*2],
+			    input_buf[1][in_row_group_ctr],
+			    input_buf[2][in_row_group_ctr],
+			    output_buf[0], cinfo->output_width);
+  (*upsample->ycc_rgb_row) (input_buf[0][in_row_group_ctr*2 + 1],
+			    input_buf[1][in_row_group_ctr],
+			    input_buf[2][in_row_group_ctr],
+			    output_buf[1], cinfo->output_width);
+}
+
+#endif /* JSIMD_SUPPORTED */
+
+
 /*
  * Module initialization routine for merged upsampling/color conversion.
  *
@@ -394,6 +438,12 @@ jinit_merged_upsampler (j_decompress_ptr cinfo)
     upsample->spare_row = NULL;
   }
 
+#ifdef JSIMD_SUPPORTED
+  if ((upsample->ycc_rgb_row = jsimd_ycc_rgb_method(TRUE)) != NULL)
+    upsample->upmethod = cinfo->max_v_samp_factor == 2 ?
+			 h2v2_merged_upsample_simd : h2v1_merged_upsample_simd;
+#endif
+
   build_ycc_rgb_table(cinfo);
 }
 
@@ -28,19 +28,43 @@ extern void free JPP((void *ptr));
 
 /*
  * Memory allocation and freeing are controlled by the regular library
- * routines malloc() and free().
+ * routines malloc() and free(), unless the calling thread has installed
+ * replacements with jpeg_set_memory_hooks().
  */
 
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+static THREAD_LOCAL const jpeg_memory_hooks * memory_hooks = NULL;
+
+GLOBAL(const jpeg_memory_hooks *)
+jpeg_set_memory_hooks (const jpeg_memory_hooks * hooks)
+{
+  const jpeg_memory_hooks * previous = memory_hooks;
+
+  memory_hooks = hooks;
+  return previous;
+}
+
+
 GLOBAL(void *)
 jpeg_get_small (j_common_ptr cinfo, size_t sizeofobject)
 {
+  if (memory_hooks != NULL)
+    return (*memory_hooks->get_mem) (memory_hooks->opaque, sizeofobject);
   return (void *) malloc(sizeofobject);
 }
 
 GLOBAL(void)
 jpeg_free_small (j_common_ptr cinfo, void * object, size_t sizeofobject)
 {
-  free(object);
+  if (memory_hooks != NULL)
+    (*memory_hooks->free_mem) (memory_hooks->opaque, object);
+  else
+    free(object);
 }
 
 
@@ -54,13 +78,18 @@ jpeg_free_small (j_common_ptr cinfo, void * object, size_t sizeofobject)
 GLOBAL(void FAR *)
 jpeg_get_large (j_common_ptr cinfo, size_t sizeofobject)
 {
+  if (memory_hooks != NULL)
+    return (void FAR *) (*memory_hooks->get_mem) (memory_hooks->opaque, sizeofobject);
   return (void FAR *) malloc(sizeofobject);
 }
 
 GLOBAL(void)
 jpeg_free_large (j_common_ptr cinfo, void FAR * object, size_t sizeofobject)
 {
-  free(object);
+  if (memory_hooks != NULL)
+    (*memory_hooks->free_mem) (memory_hooks->opaque, (void *) object);
+  else
+    free(object);
 }
 
 
@@ -1108,6 +1108,30 @@ EXTERN(void) jpeg_destroy JPP((j_common_ptr cinfo));
 EXTERN(boolean) jpeg_resync_to_restart JPP((j_decompress_ptr cinfo,
 					    int desired));
 
+/* Replacement for malloc/free behind the memory manager, see jmemnobs.c.
+ * The hooks apply to the calling thread only.  Every object created while
+ * a set of hooks is installed must also be destroyed while it is installed.
+ */
+typedef struct {
+  void * (*get_mem) JPP((void * opaque, size_t sizeofobject));
+  void (*free_mem) JPP((void * opaque, void * object));
+  void * opaque;
+} jpeg_memory_hooks;
+
+/* Installs hooks for the calling thread (NULL for malloc/free) and
+ * returns the previous ones.
+ */
+EXTERN(const jpeg_memory_hooks *) jpeg_set_memory_hooks
+	JPP((const jpeg_memory_hooks * hooks));
+
+/* Caps the SIMD kernels of jsimd.h used by decompressors set up from now
+ * on: 0 for the C code only, 1 for up to SSE2, 2 (the default) for up to
+ * AVX2.  Returns the level that will actually be used, which is lower when
+ * the CPU lacks it.  Meant for tests comparing the paths; not to be called
+ * while another thread starts a decompression.
+ */
+EXTERN(int) jpeg_simd_limit JPP((int max_level));
+
 
 /* These marker codes are exported since applications and data source modules
  * are likely to want to use them.
@@ -0,0 +1,176 @@
+/*
+ * jsimd.c
+ *
+ * This file is part of the Independent JPEG Group's software.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * This file contains the run-time selection of the SIMD kernels declared
+ * in jsimd.h.  The CPU is examined once per process; AVX2 is preferred,
+ * SSE2 is assumed on x64 and checked for on x86.
+ */
+
+#define JPEG_INTERNALS
+#include "jinclude.h"
+#include "jpeglib.h"
+#include "jdct.h"		/* Private declarations for DCT subsystem */
+#include "jsimd.h"
+
+#ifdef JSIMD_SUPPORTED
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <windows.h>
+#else
+#include <cpuid.h>
+#include <pthread.h>
+#endif
+
+#define JSIMD_NONE	0
+#define JSIMD_SSE2	1
+#define JSIMD_AVX2	2
+
+static int simd_level = JSIMD_NONE;
+static int simd_limit = JSIMD_AVX2;
+
+
+LOCAL(void)
+cpuid (int leaf, unsigned int regs[4])
+{
+#ifdef _MSC_VER
+  int info[4];
+  int i;
+
+  __cpuidex(info, leaf, 0);
+  for (i = 0; i < 4; i++)
+    regs[i] = (unsigned int) info[i];
+#else
+  __cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+
+LOCAL(unsigned long long)
+read_xcr0 (void)
+{
+#ifdef _MSC_VER
+  return _xgetbv(0);
+#else
+  unsigned int eax, edx;
+
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return ((unsigned long long) edx << 32) | eax;
+#endif
+}
+
+
+LOCAL(void)
+detect_simd (void)
+{
+  unsigned int regs[4];
+  unsigned int max_leaf;
+
+  cpuid(0, regs);
+  max_leaf = regs[0];
+  if (max_leaf < 1)
+    return;
+
+  cpuid(1, regs);
+  if ((regs[3] & (1u << 26)) == 0)
+    return;
+  simd_level = JSIMD_SSE2;
+
+  /* AVX2 also needs the OS to save the ymm registers */
+  if (max_leaf >= 7 && (regs[2] & (1u << 27)) && (regs[2] & (1u << 28)) &&
+      (read_xcr0() & 0x6) == 0x6) {
+    cpuid(7, regs);
+    if (regs[1] & (1u << 5))
+      simd_level = JSIMD_AVX2;
+  }
+}
+
+
+#ifdef _MSC_VER
+
+static INIT_ONCE detect_once = INIT_ONCE_STATIC_INIT;
+
+LOCAL(BOOL CALLBACK)
+detect_simd_once (PINIT_ONCE once, PVOID param, PVOID * context)
+{
+  detect_simd();
+  return TRUE;
+}
+
+LOCAL(int)
+get_simd_level (void)
+{
+  InitOnceExecuteOnce(&detect_once, detect_simd_once, NULL, NULL);
+  return simd_level < simd_limit ? simd_level : simd_limit;
+}
+
+#else
+
+static pthread_once_t detect_once = PTHREAD_ONCE_INIT;
+
+LOCAL(int)
+get_simd_level (void)
+{
+  pthread_once(&detect_once, detect_simd);
+  return simd_level < simd_limit ? simd_level : simd_limit;
+}
+
+#endif
+
+
+GLOBAL(inverse_DCT_method_ptr)
+jsimd_idct_method (inverse_DCT_method_ptr method)
+{
+  int level = get_simd_level();
+
+  if (level == JSIMD_NONE)
+    return method;
+#ifdef DCT_ISLOW_SUPPORTED
+  if (method == jpeg_idct_islow)
+    return level == JSIMD_AVX2 ? jsimd_idct_islow_avx2 :
+				 jsimd_idct_islow_sse2;
+#ifdef IDCT_SCALING_SUPPORTED
+  if (method == jpeg_idct_16x16)
+    return level == JSIMD_AVX2 ? jsimd_idct_16x16_avx2 :
+				 jsimd_idct_16x16_sse2;
+  if (method == jpeg_idct_16x8)
+    return level == JSIMD_AVX2 ? jsimd_idct_16x8_avx2 :
+				 jsimd_idct_16x8_sse2;
+#endif
+#endif
+  return method;
+}
+
+
+GLOBAL(jsimd_ycc_rgb_ptr)
+jsimd_ycc_rgb_method (boolean h2)
+{
+  switch (get_simd_level()) {
+  case JSIMD_AVX2:
+    return h2 ? jsimd_ycc_rgb_h2_row_avx2 : jsimd_ycc_rgb_row_avx2;
+  case JSIMD_SSE2:
+    return h2 ? jsimd_ycc_rgb_h2_row_sse2 : jsimd_ycc_rgb_row_sse2;
+  }
+  return NULL;
+}
+
+
+GLOBAL(int)
+jpeg_simd_limit (int max_level)
+{
+  simd_limit = max_level < JSIMD_NONE ? JSIMD_NONE : max_level;
+  return get_simd_level();
+}
+
+#else /* !JSIMD_SUPPORTED */
+
+GLOBAL(int)
+jpeg_simd_limit (int max_level)
+{
+  return 0;
+}
+
+#endif /* JSIMD_SUPPORTED */
@@ -0,0 +1,118 @@
+/*
+ * jsimd.h
+ *
+ * This file is part of the Independent JPEG Group's software.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * This include file declares the SSE2 and AVX2 versions of the hottest
+ * decompression kernels: the islow IDCT, the 16x16 and 16x8 scaled IDCTs
+ * that do fancy h2v2/h2v1 upsampling, and YCbCr->RGB conversion (both the
+ * plain converter and the merged upsamplers).  Every kernel reproduces the
+ * integer arithmetic of the C code exactly, so output is bit-identical;
+ * the C versions stay in use wherever these are not selected.
+ *
+ * The IDCT kernels load the multiplier table as 32-bit ints, so they
+ * require the default int MULTIPLIER.  Define NO_JSIMD to disable them.
+ */
+
+#ifndef JSIMD_H
+#define JSIMD_H
+
+#if !defined(NO_JSIMD) && BITS_IN_JSAMPLE == 8 && DCTSIZE == 8 && \
+    RGB_RED == 0 && RGB_GREEN == 1 && RGB_BLUE == 2 && RGB_PIXELSIZE == 3
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JSIMD_SUPPORTED
+#endif
+#endif
+
+#ifdef JSIMD_SUPPORTED
+
+/* MSVC lets any function use any intrinsic, gcc and clang need the
+ * instruction set enabled per function.
+ */
+#if defined(_MSC_VER) && !defined(__clang__)
+#define JSIMD_TARGET(features)
+#else
+#define JSIMD_TARGET(features)  __attribute__((target(features)))
+#endif
+
+/* Helpers of the kernels, inlined so their vectors stay in registers */
+#if defined(_MSC_VER) && !defined(__clang__)
+#define JSIMD_LOCAL(type)  static __forceinline type
+#else
+#define JSIMD_LOCAL(type)  static __inline__ __attribute__((always_inline)) type
+#endif
+
+#ifdef NEED_SHORT_EXTERNAL_NAMES
+#define jsimd_idct_method	jSIdctMethod
+#define jsimd_ycc_rgb_method	jSYccRgbMethod
+#define jsimd_idct_islow_sse2	jSIdctIslowSse2
+#define jsimd_idct_16x16_sse2	jSIdct16x16Sse2
+#define jsimd_idct_16x8_sse2	jSIdct16x8Sse2
+#define jsimd_ycc_rgb_row_sse2	jSYccRgbSse2
+#define jsimd_ycc_rgb_h2_row_sse2	jSYccRgbH2Sse2
+#define jsimd_idct_islow_avx2	jSIdctIslowAvx2
+#define jsimd_idct_16x16_avx2	jSIdct16x16Avx2
+#define jsimd_idct_16x8_avx2	jSIdct16x8Avx2
+#define jsimd_ycc_rgb_row_avx2	jSYccRgbAvx2
+#define jsimd_ycc_rgb_h2_row_avx2	jSYccRgbH2Avx2
+#endif /* NEED_SHORT_EXTERNAL_NAMES */
+
+/* Converts one row of num_cols pixels.  For the h2 variant the chroma
+ * rows hold (num_cols+1)/2 samples, each shared by two output pixels.
+ */
+typedef JMETHOD(void, jsimd_ycc_rgb_ptr,
+		(JSAMPROW inptr0, JSAMPROW inptr1, JSAMPROW inptr2,
+		 JSAMPROW outptr, JDIMENSION num_cols));
+
+/* Selection, done by the modules when they set up a pass.
+ * jsimd_idct_method returns a faster equivalent of method, or method itself;
+ * jsimd_ycc_rgb_method returns NULL if the C converter should be kept.
+ */
+EXTERN(inverse_DCT_method_ptr) jsimd_idct_method
+	JPP((inverse_DCT_method_ptr method));
+EXTERN(jsimd_ycc_rgb_ptr) jsimd_ycc_rgb_method JPP((boolean h2));
+
+/* The kernels themselves */
+EXTERN(void) jsimd_idct_islow_sse2
+	JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	     JCOEFPTR coef_block, JSAMPARRAY output_buf,
+	     JDIMENSION output_col));
+EXTERN(void) jsimd_idct_16x16_sse2
+	JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	     JCOEFPTR coef_block, JSAMPARRAY output_buf,
+	     JDIMENSION output_col));
+EXTERN(void) jsimd_idct_16x8_sse2
+	JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	     JCOEFPTR coef_block, JSAMPARRAY output_buf,
+	     JDIMENSION output_col));
+EXTERN(void) jsimd_ycc_rgb_row_sse2
+	JPP((JSAMPROW inptr0, JSAMPROW inptr1, JSAMPROW inptr2,
+	     JSAMPROW outptr, JDIMENSION num_cols));
+EXTERN(void) jsimd_ycc_rgb_h2_row_sse2
+	JPP((JSAMPROW inptr0, JSAMPROW inptr1, JSAMPROW inptr2,
+	     JSAMPROW outptr, JDIMENSION num_cols));
+
+EXTERN(void) jsimd_idct_islow_avx2
+	JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	     JCOEFPTR coef_block, JSAMPARRAY output_buf,
+	     JDIMENSION output_col));
+EXTERN(void) jsimd_idct_16x16_avx2
+	JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	     JCOEFPTR coef_block, JSAMPARRAY output_buf,
+	     JDIMENSION output_col));
+EXTERN(void) jsimd_idct_16x8_avx2
+	JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	     JCOEFPTR coef_block, JSAMPARRAY output_buf,
+	     JDIMENSION output_col));
+EXTERN(void) jsimd_ycc_rgb_row_avx2
+	JPP((JSAMPROW inptr0, JSAMPROW inptr1, JSAMPROW inptr2,
+	     JSAMPROW outptr, JDIMENSION num_cols));
+EXTERN(void) jsimd_ycc_rgb_h2_row_avx2
+	JPP((JSAMPROW inptr0, JSAMPROW inptr1, JSAMPROW inptr2,
+	     JSAMPROW outptr, JDIMENSION num_cols));
+
+#endif /* JSIMD_SUPPORTED */
+
+#endif /* JSIMD_H */
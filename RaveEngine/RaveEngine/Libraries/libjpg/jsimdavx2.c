@@ -0,0 +1,240 @@
+/*
+ * jsimdavx2.c
+ *
+ * This file is part of the Independent JPEG Group's software.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * This file contains the AVX2 versions of the kernels in jsimdker.h,
+ * working on 8 columns or rows of an IDCT and 32 pixels at a time.
+ * Byte and word operations work within each 128-bit half of a vector,
+ * which is harmless as long as every unpack is undone by a pack.
+ */
+
+#define JPEG_INTERNALS
+#include "jinclude.h"
+#include "jpeglib.h"
+#include "jdct.h"		/* Private declarations for DCT subsystem */
+#include "jsimd.h"
+
+#ifdef JSIMD_SUPPORTED
+
+#include <immintrin.h>
+
+#define JVEC		__m256i
+#define JVEC_LANES	8
+#define JSIMD_SUFFIX	avx2
+#define JSIMD_KERNEL	JSIMD_TARGET("avx2")
+
+
+/* 32-bit lane operations */
+
+#define jv_zero()		_mm256_setzero_si256()
+#define jv_set1(c)		_mm256_set1_epi32(c)
+#define jv_add(a,b)		_mm256_add_epi32(a, b)
+#define jv_sub(a,b)		_mm256_sub_epi32(a, b)
+#define jv_mul(a,b)		_mm256_mullo_epi32(a, b)
+#define jv_slli(a,n)		_mm256_slli_epi32(a, n)
+#define jv_srai(a,n)		_mm256_srai_epi32(a, n)
+#define jv_or(a,b)		_mm256_or_si256(a, b)
+#define jv_iszero(a)		_mm256_cmpeq_epi32(a, _mm256_setzero_si256())
+#define jv_all(mask)		(_mm256_movemask_epi8(mask) == -1)
+#define jv_select(mask,a,b)	_mm256_blendv_epi8(b, a, mask)
+#define jv_load_int(p)		_mm256_loadu_si256((const __m256i *) (p))
+#define jv_store_int(p,v)	_mm256_storeu_si256((__m256i *) (p), v)
+#define jv_load_coef(p) \
+  _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (p)))
+
+
+/* 16-bit and 8-bit lane operations */
+
+#define jb_loadu(p)		_mm256_loadu_si256((const __m256i *) (p))
+#define jb_set1_16(c)		_mm256_set1_epi16(c)
+#define jb_add16(a,b)		_mm256_add_epi16(a, b)
+#define jb_sub16(a,b)		_mm256_sub_epi16(a, b)
+#define jb_madd16(a,b)		_mm256_madd_epi16(a, b)
+#define jb_packs32(a,b)		_mm256_packs_epi32(a, b)
+#define jb_packus16(a,b)	_mm256_packus_epi16(a, b)
+#define jb_unpacklo8(a,b)	_mm256_unpacklo_epi8(a, b)
+#define jb_unpackhi8(a,b)	_mm256_unpackhi_epi8(a, b)
+#define jb_unpacklo16(a,b)	_mm256_unpacklo_epi16(a, b)
+#define jb_unpackhi16(a,b)	_mm256_unpackhi_epi16(a, b)
+
+/* 16 chroma samples, each doubled */
+
+JSIMD_KERNEL JSIMD_LOCAL(__m256i)
+jb_load_h2 (JSAMPROW p)
+{
+  __m128i x = _mm_loadu_si128((const __m128i *) p);
+
+  return _mm256_inserti128_si256(
+	   _mm256_castsi128_si256(_mm_unpacklo_epi8(x, x)),
+	   _mm_unpackhi_epi8(x, x), 1);
+}
+
+
+/*
+ * Load 8 workspace rows of 8 entries as 8 vectors of 8 rows each.
+ */
+
+JSIMD_KERNEL JSIMD_LOCAL(void)
+load_columns (int * wsptr, __m256i * in)
+{
+  __m256i r[8], t[8], u[8];
+  int i;
+
+  for (i = 0; i < 8; i++)
+    r[i] = _mm256_loadu_si256((const __m256i *) (wsptr + 8*i));
+  for (i = 0; i < 8; i += 2) {
+    t[i]   = _mm256_unpacklo_epi32(r[i], r[i+1]);
+    t[i+1] = _mm256_unpackhi_epi32(r[i], r[i+1]);
+  }
+  for (i = 0; i < 8; i += 4) {
+    u[i]   = _mm256_unpacklo_epi64(t[i],   t[i+2]);
+    u[i+1] = _mm256_unpackhi_epi64(t[i],   t[i+2]);
+    u[i+2] = _mm256_unpacklo_epi64(t[i+1], t[i+3]);
+    u[i+3] = _mm256_unpackhi_epi64(t[i+1], t[i+3]);
+  }
+  /* u[0..3] hold columns 0..3 (low half) and 4..7 (high half) of rows
+   * 0..3, u[4..7] the same for rows 4..7.
+   */
+  for (i = 0; i < 4; i++) {
+    in[i]   = _mm256_permute2x128_si256(u[i], u[i+4], 0x20);
+    in[i+4] = _mm256_permute2x128_si256(u[i], u[i+4], 0x31);
+  }
+}
+
+
+/*
+ * Narrow 8 vectors of 8 rows each to samples, transposed as in
+ * jsimdsse2.c: the low half of *rows01 receives rows 0 and 1, the high
+ * half rows 4 and 5, and *rows23 likewise rows 2, 3, 6 and 7.
+ */
+
+JSIMD_KERNEL JSIMD_LOCAL(void)
+transpose_samples (__m256i * out, __m256i * rows01, __m256i * rows23)
+{
+  __m256i a, b, t0, t1;
+
+  a = _mm256_packus_epi16(_mm256_packs_epi32(out[0], out[1]),
+			  _mm256_packs_epi32(out[2], out[3]));
+  b = _mm256_packus_epi16(_mm256_packs_epi32(out[4], out[5]),
+			  _mm256_packs_epi32(out[6], out[7]));
+  t0 = _mm256_unpacklo_epi8(a, b);
+  t1 = _mm256_unpackhi_epi8(a, b);
+  a = _mm256_unpacklo_epi8(t0, t1);
+  b = _mm256_unpackhi_epi8(t0, t1);
+  *rows01 = _mm256_unpacklo_epi8(a, b);
+  *rows23 = _mm256_unpackhi_epi8(a, b);
+}
+
+
+/*
+ * Store n (8 or 16) range-limited outputs for each of 8 rows.
+ */
+
+JSIMD_KERNEL JSIMD_LOCAL(void)
+store_rows (__m256i * out, int n, JSAMPARRAY output_buf,
+	    JDIMENSION output_col)
+{
+  __m256i lo01, lo23, hi01, hi23, row;
+  int half;
+
+  transpose_samples(out, &lo01, &lo23);
+  if (n == 8) {
+    for (half = 0; half < 8; half += 4) {
+      __m128i r01 = half ? _mm256_extracti128_si256(lo01, 1) :
+			   _mm256_castsi256_si128(lo01);
+      __m128i r23 = half ? _mm256_extracti128_si256(lo23, 1) :
+			   _mm256_castsi256_si128(lo23);
+
+      _mm_storel_epi64((__m128i *) (output_buf[half+0] + output_col), r01);
+      _mm_storel_epi64((__m128i *) (output_buf[half+1] + output_col),
+		       _mm_srli_si128(r01, 8));
+      _mm_storel_epi64((__m128i *) (output_buf[half+2] + output_col), r23);
+      _mm_storel_epi64((__m128i *) (output_buf[half+3] + output_col),
+		       _mm_srli_si128(r23, 8));
+    }
+    return;
+  }
+
+  transpose_samples(out + 8, &hi01, &hi23);
+  for (half = 0; half < 8; half += 4) {
+    row = _mm256_unpacklo_epi64(lo01, hi01);
+    _mm_storeu_si128((__m128i *) (output_buf[half+0] + output_col),
+		     half ? _mm256_extracti128_si256(row, 1) :
+			    _mm256_castsi256_si128(row));
+    row = _mm256_unpackhi_epi64(lo01, hi01);
+    _mm_storeu_si128((__m128i *) (output_buf[half+1] + output_col),
+		     half ? _mm256_extracti128_si256(row, 1) :
+			    _mm256_castsi256_si128(row));
+    row = _mm256_unpacklo_epi64(lo23, hi23);
+    _mm_storeu_si128((__m128i *) (output_buf[half+2] + output_col),
+		     half ? _mm256_extracti128_si256(row, 1) :
+			    _mm256_castsi256_si128(row));
+    row = _mm256_unpackhi_epi64(lo23, hi23);
+    _mm_storeu_si128((__m128i *) (output_buf[half+3] + output_col),
+		     half ? _mm256_extracti128_si256(row, 1) :
+			    _mm256_castsi256_si128(row));
+  }
+}
+
+
+/*
+ * Store 16 pixels as R,G,B triplets; each output byte is picked from
+ * one of the three inputs by a pshufb.
+ */
+
+JSIMD_KERNEL JSIMD_LOCAL(void)
+store_rgb16 (JSAMPROW outptr, __m128i r, __m128i g, __m128i b)
+{
+  __m128i r0 = _mm_setr_epi8(0, -1, -1, 1, -1, -1, 2, -1,
+			     -1, 3, -1, -1, 4, -1, -1, 5);
+  __m128i r1 = _mm_setr_epi8(-1, -1, 6, -1, -1, 7, -1, -1,
+			     8, -1, -1, 9, -1, -1, 10, -1);
+  __m128i r2 = _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13,
+			     -1, -1, 14, -1, -1, 15, -1, -1);
+  __m128i g0 = _mm_setr_epi8(-1, 0, -1, -1, 1, -1, -1, 2,
+			     -1, -1, 3, -1, -1, 4, -1, -1);
+  __m128i g1 = _mm_setr_epi8(5, -1, -1, 6, -1, -1, 7, -1,
+			     -1, 8, -1, -1, 9, -1, -1, 10);
+  __m128i g2 = _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1,
+			     13, -1, -1, 14, -1, -1, 15, -1);
+  __m128i b0 = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1,
+			     2, -1, -1, 3, -1, -1, 4, -1);
+  __m128i b1 = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7,
+			     -1, -1, 8, -1, -1, 9, -1, -1);
+  __m128i b2 = _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1,
+			     -1, 13, -1, -1, 14, -1, -1, 15);
+
+  _mm_storeu_si128((__m128i *) outptr,
+		   _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r0),
+					     _mm_shuffle_epi8(g, g0)),
+				_mm_shuffle_epi8(b, b0)));
+  _mm_storeu_si128((__m128i *) (outptr + 16),
+		   _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r1),
+					     _mm_shuffle_epi8(g, g1)),
+				_mm_shuffle_epi8(b, b1)));
+  _mm_storeu_si128((__m128i *) (outptr + 32),
+		   _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r2),
+					     _mm_shuffle_epi8(g, g2)),
+				_mm_shuffle_epi8(b, b2)));
+}
+
+
+/*
+ * Store 32 pixels as R,G,B triplets.
+ */
+
+JSIMD_KERNEL JSIMD_LOCAL(void)
+store_rgb (JSAMPROW outptr, __m256i r, __m256i g, __m256i b)
+{
+  store_rgb16(outptr, _mm256_castsi256_si128(r), _mm256_castsi256_si128(g),
+	      _mm256_castsi256_si128(b));
+  store_rgb16(outptr + 48, _mm256_extracti128_si256(r, 1),
+	      _mm256_extracti128_si256(g, 1), _mm256_extracti128_si256(b, 1));
+}
+
+
+#include "jsimdker.h"
+
+#endif /* JSIMD_SUPPORTED */
@@ -0,0 +1,499 @@
+/*
+ * jsimdker.h
+ *
+ * This file is part of the Independent JPEG Group's software.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * This file holds the bodies of the SIMD kernels declared in jsimd.h.
+ * It is included by jsimdsse2.c and jsimdavx2.c, which first define:
+ *
+ *	JVEC			vector type (__m128i or __m256i)
+ *	JVEC_LANES		number of 32-bit lanes in a JVEC
+ *	JSIMD_SUFFIX		suffix of the exported kernel names
+ *	JSIMD_KERNEL		function attribute enabling the instruction set
+ *	jv_*, jb_*		the operations used below, see those files
+ *	load_columns		transposed load of JVEC_LANES workspace rows
+ *	store_rows		transposed store of JVEC_LANES output rows
+ *	store_rgb		interleaved store of 3 vectors of samples
+ *
+ * The IDCTs are the algorithms of jidctint.c with one column (pass 1) or
+ * one row (pass 2) per lane.  INT32 arithmetic there wraps exactly like
+ * the 32-bit lanes here, and the zero-AC shortcuts are taken per lane,
+ * so the results are identical even for out-of-range coefficients.
+ */
+
+#define CONST_BITS  13
+#define PASS1_BITS  2
+
+#define FIX_0_298631336  2446
+#define FIX_0_390180644  3196
+#define FIX_0_541196100  4433
+#define FIX_0_765366865  6270
+#define FIX_0_899976223  7373
+#define FIX_1_175875602  9633
+#define FIX_1_501321110  12299
+#define FIX_1_847759065  15137
+#define FIX_1_961570560  16069
+#define FIX_2_053119869  16819
+#define FIX_2_562915447  20995
+#define FIX_3_072711026  25172
+
+#define JSIMD_PASTE2(name,suffix)  name##_##suffix
+#define JSIMD_PASTE(name,suffix)   JSIMD_PASTE2(name,suffix)
+#define JSIMD_NAME(name)           JSIMD_PASTE(name, JSIMD_SUFFIX)
+
+/* Multiply every lane by a constant */
+#define jv_mulc(a,c)  jv_mul(a, jv_set1(c))
+
+
+/*
+ * 8-point kernel of jpeg_idct_islow.  in[] holds the eight inputs of each
+ * lane; the DC term is scaled by 2^CONST_BITS here and fudge is added to it.
+ */
+
+JSIMD_KERNEL JSIMD_LOCAL(void)
+idct8 (JVEC * in, JVEC fudge, JVEC * out, int shift)
+{
+  JVEC tmp0, tmp1, tmp2, tmp3, tmp10, tmp11, tmp12, tmp13;
+  JVEC z1, z2, z3;
+
+  /* Even part */
+
+  z1 = jv_mulc(jv_add(in[2], in[6]), FIX_0_541196100);
+  tmp2 = jv_add(z1, jv_mulc(in[2], FIX_0_765366865));
+  tmp3 = jv_sub(z1, jv_mulc(in[6], FIX_1_847759065));
+
+  z2 = jv_add(jv_slli(in[0], CONST_BITS), fudge);
+  z3 = jv_slli(in[4], CONST_BITS);
+
+  tmp0 = jv_add(z2, z3);
+  tmp1 = jv_sub(z2, z3);
+
+  tmp10 = jv_add(tmp0, tmp2);
+  tmp13 = jv_sub(tmp0, tmp2);
+  tmp11 = jv_add(tmp1, tmp3);
+  tmp12 = jv_sub(tmp1, tmp3);
+
+  /* Odd part */
+
+  tmp0 = in[7];
+  tmp1 = in[5];
+  tmp2 = in[3];
+  tmp3 = in[1];
+
+  z2 = jv_add(tmp0, tmp2);
+  z3 = jv_add(tmp1, tmp3);
+
+  z1 = jv_mulc(jv_add(z2, z3), FIX_1_175875602);
+  z2 = jv_add(jv_mulc(z2, - FIX_1_961570560), z1);
+  z3 = jv_add(jv_mulc(z3, - FIX_0_390180644), z1);
+
+  z1 = jv_mulc(jv_add(tmp0, tmp3), - FIX_0_899976223);
+  tmp0 = jv_add(jv_mulc(tmp0, FIX_0_298631336), jv_add(z1, z2));
+  tmp3 = jv_add(jv_mulc(tmp3, FIX_1_501321110), jv_add(z1, z3));
+
+  z1 = jv_mulc(jv_add(tmp1, tmp2), - FIX_2_562915447);
+  tmp1 = jv_add(jv_mulc(tmp1, FIX_2_053119869), jv_add(z1, z3));
+  tmp2 = jv_add(jv_mulc(tmp2, FIX_3_072711026), jv_add(z1, z2));
+
+  /* Final output stage */
+
+  out[0] = jv_srai(jv_add(tmp10, tmp3), shift);
+  out[7] = jv_srai(jv_sub(tmp10, tmp3), shift);
+  out[1] = jv_srai(jv_add(tmp11, tmp2), shift);
+  out[6] = jv_srai(jv_sub(tmp11, tmp2), shift);
+  out[2] = jv_srai(jv_add(tmp12, tmp1), shift);
+  out[5] = jv_srai(jv_sub(tmp12, tmp1), shift);
+  out[3] = jv_srai(jv_add(tmp13, tmp0), shift);
+  out[4] = jv_srai(jv_sub(tmp13, tmp0), shift);
+}
+
+
+/*
+ * 16-point kernel of jpeg_idct_16x16 and jpeg_idct_16x8, same conventions.
+ */
+
+JSIMD_KERNEL JSIMD_LOCAL(void)
+idct16 (JVEC * in, JVEC fudge, JVEC * out, int shift)
+{
+  JVEC tmp0, tmp1, tmp2, tmp3, tmp10, tmp11, tmp12, tmp13;
+  JVEC tmp20, tmp21, tmp22, tmp23, tmp24, tmp25, tmp26, tmp27;
+  JVEC z1, z2, z3, z4;
+
+  /* Even part */
+
+  tmp0 = jv_add(jv_slli(in[0], CONST_BITS), fudge);
+
+  z1 = in[4];
+  tmp1 = jv_mulc(z1, FIX(1.306562965));
+  tmp2 = jv_mulc(z1, FIX_0_541196100);
+
+  tmp10 = jv_add(tmp0, tmp1);
+  tmp11 = jv_sub(tmp0, tmp1);
+  tmp12 = jv_add(tmp0, tmp2);
+  tmp13 = jv_sub(tmp0, tmp2);
+
+  z1 = in[2];
+  z2 = in[6];
+  z3 = jv_sub(z1, z2);
+  z4 = jv_mulc(z3, FIX(0.275899379));
+  z3 = jv_mulc(z3, FIX(1.387039845));
+
+  tmp0 = jv_add(z3, jv_mulc(z2, FIX_2_562915447));
+  tmp1 = jv_add(z4, jv_mulc(z1, FIX_0_899976223));
+  tmp2 = jv_sub(z3, jv_mulc(z1, FIX(0.601344887)));
+  tmp3 = jv_sub(z4, jv_mulc(z2, FIX(0.509795579)));
+
+  tmp20 = jv_add(tmp10, tmp0);
+  tmp27 = jv_sub(tmp10, tmp0);
+  tmp21 = jv_add(tmp12, tmp1);
+  tmp26 = jv_sub(tmp12, tmp1);
+  tmp22 = jv_add(tmp13, tmp2);
+  tmp25 = jv_sub(tmp13, tmp2);
+  tmp23 = jv_add(tmp11, tmp3);
+  tmp24 = jv_sub(tmp11, tmp3);
+
+  /* Odd part */
+
+  z1 = in[1];
+  z2 = in[3];
+  z3 = in[5];
+  z4 = in[7];
+
+  tmp11 = jv_add(z1, z3);
+
+  tmp1  = jv_mulc(jv_add(z1, z2), FIX(1.353318001));
+  tmp2  = jv_mulc(tmp11, FIX(1.247225013));
+  tmp3  = jv_mulc(jv_add(z1, z4), FIX(1.093201867));
+  tmp10 = jv_mulc(jv_sub(z1, z4), FIX(0.897167586));
+  tmp11 = jv_mulc(tmp11, FIX(0.666655658));
+  tmp12 = jv_mulc(jv_sub(z1, z2), FIX(0.410524528));
+  tmp0  = jv_sub(jv_add(jv_add(tmp1, tmp2), tmp3),
+		 jv_mulc(z1, FIX(2.286341144)));
+  tmp13 = jv_sub(jv_add(jv_add(tmp10, tmp11), tmp12),
+		 jv_mulc(z1, FIX(1.835730603)));
+  z1    = jv_mulc(jv_add(z2, z3), FIX(0.138617169));
+  tmp1  = jv_add(tmp1, jv_add(z1, jv_mulc(z2, FIX(0.071888074))));
+  tmp2  = jv_add(tmp2, jv_sub(z1, jv_mulc(z3, FIX(1.125726048))));
+  z1    = jv_mulc(jv_sub(z3, z2), FIX(1.407403738));
+  tmp11 = jv_add(tmp11, jv_sub(z1, jv_mulc(z3, FIX(0.766367282))));
+  tmp12 = jv_add(tmp12, jv_add(z1, jv_mulc(z2, FIX(1.971951411))));
+  z2    = jv_add(z2, z4);
+  z1    = jv_mulc(z2, - FIX(0.666655658));
+  tmp1  = jv_add(tmp1, z1);
+  tmp3  = jv_add(tmp3, jv_add(z1, jv_mulc(z4, FIX(1.065388962))));
+  z2    = jv_mulc(z2, - FIX(1.247225013));
+  tmp10 = jv_add(tmp10, jv_add(z2, jv_mulc(z4, FIX(3.141271809))));
+  tmp12 = jv_add(tmp12, z2);
+  z2    = jv_mulc(jv_add(z3, z4), - FIX(1.353318001));
+  tmp2  = jv_add(tmp2, z2);
+  tmp3  = jv_add(tmp3, z2);
+  z2    = jv_mulc(jv_sub(z4, z3), FIX(0.410524528));
+  tmp10 = jv_add(tmp10, z2);
+  tmp11 = jv_add(tmp11, z2);
+
+  /* Final output stage */
+
+  out[0]  = jv_srai(jv_add(tmp20, tmp0), shift);
+  out[15] = jv_srai(jv_sub(tmp20, tmp0), shift);
+  out[1]  = jv_srai(jv_add(tmp21, tmp1), shift);
+  out[14] = jv_srai(jv_sub(tmp21, tmp1), shift);
+  out[2]  = jv_srai(jv_add(tmp22, tmp2), shift);
+  out[13] = jv_srai(jv_sub(tmp22, tmp2), shift);
+  out[3]  = jv_srai(jv_add(tmp23, tmp3), shift);
+  out[12] = jv_srai(jv_sub(tmp23, tmp3), shift);
+  out[4]  = jv_srai(jv_add(tmp24, tmp10), shift);
+  out[11] = jv_srai(jv_sub(tmp24, tmp10), shift);
+  out[5]  = jv_srai(jv_add(tmp25, tmp11), shift);
+  out[10] = jv_srai(jv_sub(tmp25, tmp11), shift);
+  out[6]  = jv_srai(jv_add(tmp26, tmp12), shift);
+  out[9]  = jv_srai(jv_sub(tmp26, tmp12), shift);
+  out[7]  = jv_srai(jv_add(tmp27, tmp13), shift);
+  out[8]  = jv_srai(jv_sub(tmp27, tmp13), shift);
+}
+
+
+/*
+ * Dequantize JVEC_LANES columns of the coefficient block.
+ * Returns a mask of the lanes whose AC coefficients are all zero.
+ */
+
+JSIMD_KERNEL JSIMD_LOCAL(JVEC)
+dequantize (JCOEFPTR inptr, ISLOW_MULT_TYPE * quantptr, JVEC * in)
+{
+  JVEC coef, ac;
+  int i;
+
+  in[0] = jv_mul(jv_load_coef(inptr), jv_load_int(quantptr));
+  ac = jv_zero();
+  for (i = 1; i < DCTSIZE; i++) {
+    coef = jv_load_coef(inptr + DCTSIZE*i);
+    ac = jv_or(ac, coef);
+    in[i] = jv_mul(coef, jv_load_int(quantptr + DCTSIZE*i));
+  }
+  return jv_iszero(ac);
+}
+
+
+/*
+ * Pass 1 of jpeg_idct_islow and jpeg_idct_16x8: 8-point IDCT of
+ * JVEC_LANES columns, stored into an 8x8 workspace.
+ */
+
+JSIMD_KERNEL JSIMD_LOCAL(void)
+pass1_8 (JCOEFPTR inptr, ISLOW_MULT_TYPE * quantptr, int * wsptr)
+{
+  JVEC in[8], out[8], dcval, zero_ac;
+  int i;
+
+  zero_ac = dequantize(inptr, quantptr, in);
+  dcval = jv_slli(in[0], PASS1_BITS);
+  if (jv_all(zero_ac)) {
+    for (i = 0; i < 8; i++)
+      jv_store_int(wsptr + DCTSIZE*i, dcval);
+    return;
+  }
+
+  idct8(in, jv_set1(1 << (CONST_BITS-PASS1_BITS-1)), out,
+	CONST_BITS-PASS1_BITS);
+  for (i = 0; i < 8; i++)
+    jv_store_int(wsptr + DCTSIZE*i, jv_select(zero_ac, dcval, out[i]));
+}
+
+
+/*
+ * Pass 1 of jpeg_idct_16x16: 16-point IDCT of JVEC_LANES columns,
+ * stored into a 16x8 workspace.  There is no zero-AC shortcut here.
+ */
+
+JSIMD_KERNEL JSIMD_LOCAL(void)
+pass1_16 (JCOEFPTR inptr, ISLOW_MULT_TYPE * quantptr, int * wsptr)
+{
+  JVEC in[8], out[16];
+  int i;
+
+  (void) dequantize(inptr, quantptr, in);
+  idct16(in, jv_set1(1 << (CONST_BITS-PASS1_BITS-1)), out,
+	 CONST_BITS-PASS1_BITS);
+  for (i = 0; i < 16; i++)
+    jv_store_int(wsptr + DCTSIZE*i, out[i]);
+}
+
+
+/*
+ * The range_limit[x & RANGE_MASK] lookup of the C code: the low 10 bits
+ * taken as signed, offset by CENTERJSAMPLE and clamped to 0..MAXJSAMPLE.
+ * The clamp is done by the saturating packs in store_rows.
+ */
+
+#define jv_range_limit(x) \
+  jv_add(jv_srai(jv_slli(x, 22), 22), jv_set1(CENTERJSAMPLE))
+
+
+JSIMD_KERNEL GLOBAL(void)
+JSIMD_NAME(jsimd_idct_islow) (j_decompress_ptr cinfo,
+			      jpeg_component_info * compptr,
+			      JCOEFPTR coef_block,
+			      JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  JVEC in[8], out[8], dcval, zero_ac;
+  int workspace[DCTSIZE2];
+  int ctr, i;
+
+  /* Pass 1: process columns from input, store into work array. */
+
+  for (ctr = 0; ctr < DCTSIZE; ctr += JVEC_LANES)
+    pass1_8(coef_block + ctr, (ISLOW_MULT_TYPE *) compptr->dct_table + ctr,
+	    workspace + ctr);
+
+  /* Pass 2: process rows from work array, store into output array. */
+
+  for (ctr = 0; ctr < DCTSIZE; ctr += JVEC_LANES) {
+    load_columns(workspace + DCTSIZE*ctr, in);
+    zero_ac = jv_iszero(jv_or(jv_or(jv_or(in[1], in[2]), jv_or(in[3], in[4])),
+			      jv_or(jv_or(in[5], in[6]), in[7])));
+    dcval = jv_srai(jv_add(in[0], jv_set1(1 << (PASS1_BITS+2))),
+		    PASS1_BITS+3);
+    if (jv_all(zero_ac)) {
+      for (i = 0; i < 8; i++)
+	out[i] = dcval;
+    } else {
+      idct8(in, jv_set1(1 << (CONST_BITS+PASS1_BITS+2)), out,
+	    CONST_BITS+PASS1_BITS+3);
+      for (i = 0; i < 8; i++)
+	out[i] = jv_select(zero_ac, dcval, out[i]);
+    }
+    for (i = 0; i < 8; i++)
+      out[i] = jv_range_limit(out[i]);
+    store_rows(out, 8, output_buf + ctr, output_col);
+  }
+}
+
+
+JSIMD_KERNEL GLOBAL(void)
+JSIMD_NAME(jsimd_idct_16x16) (j_decompress_ptr cinfo,
+			      jpeg_component_info * compptr,
+			      JCOEFPTR coef_block,
+			      JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  JVEC in[8], out[16];
+  int workspace[8*16];
+  int ctr, i;
+
+  for (ctr = 0; ctr < 8; ctr += JVEC_LANES)
+    pass1_16(coef_block + ctr, (ISLOW_MULT_TYPE *) compptr->dct_table + ctr,
+	     workspace + ctr);
+
+  for (ctr = 0; ctr < 16; ctr += JVEC_LANES) {
+    load_columns(workspace + 8*ctr, in);
+    idct16(in, jv_set1(1 << (CONST_BITS+PASS1_BITS+2)), out,
+	   CONST_BITS+PASS1_BITS+3);
+    for (i = 0; i < 16; i++)
+      out[i] = jv_range_limit(out[i]);
+    store_rows(out, 16, output_buf + ctr, output_col);
+  }
+}
+
+
+JSIMD_KERNEL GLOBAL(void)
+JSIMD_NAME(jsimd_idct_16x8) (j_decompress_ptr cinfo,
+			     jpeg_component_info * compptr,
+			     JCOEFPTR coef_block,
+			     JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  JVEC in[8], out[16];
+  int workspace[8*8];
+  int ctr, i;
+
+  for (ctr = 0; ctr < DCTSIZE; ctr += JVEC_LANES)
+    pass1_8(coef_block + ctr, (ISLOW_MULT_TYPE *) compptr->dct_table + ctr,
+	    workspace + ctr);
+
+  for (ctr = 0; ctr < 8; ctr += JVEC_LANES) {
+    load_columns(workspace + 8*ctr, in);
+    idct16(in, jv_set1(1 << (CONST_BITS+PASS1_BITS+2)), out,
+	   CONST_BITS+PASS1_BITS+3);
+    for (i = 0; i < 16; i++)
+      out[i] = jv_range_limit(out[i]);
+    store_rows(out, 16, output_buf + ctr, output_col);
+  }
+}
+
+
+/*
+ * YCbCr->RGB conversion, the equations of jdcolor.c computed in 16-bit
+ * lanes.  The table entries there are RIGHT_SHIFT(FIX(k) * x + ONE_HALF, 16)
+ * with FIX16(k) up to 116130, too wide for a 16-bit multiplier; so each
+ * constant is split into a multiple of 2^16, applied as a plain add, and
+ * a remainder that fits.  The remainder products are summed with pmaddwd,
+ * whose second operand pairs each constant with the rounding term, which
+ * keeps the result exact.
+ */
+
+#define SCALEBITS	16
+#define ONE_HALF	((INT32) 1 << (SCALEBITS-1))
+#define FIX16(x)	((INT32) ((x) * (1L<<SCALEBITS) + 0.5))
+
+/* A 32-bit lane holding lo in its low and hi in its high 16 bits */
+#define PAIR16(lo,hi)	((int) (((unsigned int) (hi) << 16) | \
+				((unsigned int) (lo) & 0xFFFF)))
+
+JSIMD_KERNEL JSIMD_LOCAL(void)
+ycc_rgb_half (JVEC y, JVEC cb, JVEC cr, JVEC * r, JVEC * g, JVEC * b)
+{
+  JVEC two = jb_set1_16(2);
+  JVEC k_r = jv_set1(PAIR16(FIX16(1.40200) - 65536, ONE_HALF/2));
+  JVEC k_b = jv_set1(PAIR16(FIX16(1.77200) - 131072, ONE_HALF/2));
+  JVEC k_g = jv_set1(PAIR16(- FIX16(0.34414), 65536 - FIX16(0.71414)));
+  JVEC half = jv_set1(ONE_HALF);
+  JVEC lo, hi, cbcr;
+
+  /* R = Y + Cr + ((26345 * Cr + 2 * 16384) >> 16) */
+  lo = jv_srai(jb_madd16(jb_unpacklo16(cr, two), k_r), SCALEBITS);
+  hi = jv_srai(jb_madd16(jb_unpackhi16(cr, two), k_r), SCALEBITS);
+  *r = jb_add16(jb_add16(y, cr), jb_packs32(lo, hi));
+
+  /* B = Y + 2 * Cb + ((-14942 * Cb + 2 * 16384) >> 16) */
+  lo = jv_srai(jb_madd16(jb_unpacklo16(cb, two), k_b), SCALEBITS);
+  hi = jv_srai(jb_madd16(jb_unpackhi16(cb, two), k_b), SCALEBITS);
+  *b = jb_add16(jb_add16(y, jb_add16(cb, cb)), jb_packs32(lo, hi));
+
+  /* G = Y - Cr + ((-22554 * Cb + 18734 * Cr + ONE_HALF) >> 16) */
+  cbcr = jb_unpacklo16(cb, cr);
+  lo = jv_srai(jv_add(jb_madd16(cbcr, k_g), half), SCALEBITS);
+  cbcr = jb_unpackhi16(cb, cr);
+  hi = jv_srai(jv_add(jb_madd16(cbcr, k_g), half), SCALEBITS);
+  *g = jb_add16(jb_sub16(y, cr), jb_packs32(lo, hi));
+}
+
+
+/* Converts and stores JVEC_LANES*4 pixels */
+
+JSIMD_KERNEL JSIMD_LOCAL(void)
+ycc_rgb_vector (JVEC y, JVEC cb, JVEC cr, JSAMPROW outptr)
+{
+  JVEC zero = jv_zero();
+  JVEC center = jb_set1_16(CENTERJSAMPLE);
+  JVEC rl, gl, bl, rh, gh, bh;
+
+  ycc_rgb_half(jb_unpacklo8(y, zero),
+	       jb_sub16(jb_unpacklo8(cb, zero), center),
+	       jb_sub16(jb_unpacklo8(cr, zero), center), &rl, &gl, &bl);
+  ycc_rgb_half(jb_unpackhi8(y, zero),
+	       jb_sub16(jb_unpackhi8(cb, zero), center),
+	       jb_sub16(jb_unpackhi8(cr, zero), center), &rh, &gh, &bh);
+  store_rgb(outptr, jb_packus16(rl, rh), jb_packus16(gl, gh),
+	    jb_packus16(bl, bh));
+}
+
+
+/* One pixel the way jdcolor.c does it, for the ends of rows */
+
+LOCAL(void)
+ycc_rgb_pixel (int y, int cb, int cr, JSAMPROW outptr)
+{
+  int x;
+  SHIFT_TEMPS
+
+  cb -= CENTERJSAMPLE;
+  cr -= CENTERJSAMPLE;
+  x = y + (int) RIGHT_SHIFT(FIX16(1.40200) * cr + ONE_HALF, SCALEBITS);
+  outptr[RGB_RED] = (JSAMPLE) (x < 0 ? 0 : x > MAXJSAMPLE ? MAXJSAMPLE : x);
+  x = y + (int) RIGHT_SHIFT(- FIX16(0.34414) * cb - FIX16(0.71414) * cr +
+			    ONE_HALF, SCALEBITS);
+  outptr[RGB_GREEN] = (JSAMPLE) (x < 0 ? 0 : x > MAXJSAMPLE ? MAXJSAMPLE : x);
+  x = y + (int) RIGHT_SHIFT(FIX16(1.77200) * cb + ONE_HALF, SCALEBITS);
+  outptr[RGB_BLUE] = (JSAMPLE) (x < 0 ? 0 : x > MAXJSAMPLE ? MAXJSAMPLE : x);
+}
+
+
+JSIMD_KERNEL GLOBAL(void)
+JSIMD_NAME(jsimd_ycc_rgb_row) (JSAMPROW inptr0, JSAMPROW inptr1,
+			       JSAMPROW inptr2, JSAMPROW outptr,
+			       JDIMENSION num_cols)
+{
+  JDIMENSION col = 0;
+
+  for (; col + JVEC_LANES*4 <= num_cols; col += JVEC_LANES*4)
+    ycc_rgb_vector(jb_loadu(inptr0 + col), jb_loadu(inptr1 + col),
+		   jb_loadu(inptr2 + col), outptr + col * RGB_PIXELSIZE);
+  for (; col < num_cols; col++)
+    ycc_rgb_pixel(GETJSAMPLE(inptr0[col]), GETJSAMPLE(inptr1[col]),
+		  GETJSAMPLE(inptr2[col]), outptr + col * RGB_PIXELSIZE);
+}
+
+
+JSIMD_KERNEL GLOBAL(void)
+JSIMD_NAME(jsimd_ycc_rgb_h2_row) (JSAMPROW inptr0, JSAMPROW inptr1,
+				  JSAMPROW inptr2, JSAMPROW outptr,
+				  JDIMENSION num_cols)
+{
+  JDIMENSION col = 0;
+
+  for (; col + JVEC_LANES*4 <= num_cols; col += JVEC_LANES*4)
+    ycc_rgb_vector(jb_loadu(inptr0 + col), jb_load_h2(inptr1 + col/2),
+		   jb_load_h2(inptr2 + col/2), outptr + col * RGB_PIXELSIZE);
+  for (; col < num_cols; col++)
+    ycc_rgb_pixel(GETJSAMPLE(inptr0[col]), GETJSAMPLE(inptr1[col >> 1]),
+		  GETJSAMPLE(inptr2[col >> 1]), outptr + col * RGB_PIXELSIZE);
+}
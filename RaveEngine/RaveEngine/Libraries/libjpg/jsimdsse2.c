@@ -0,0 +1,224 @@
+/*
+ * jsimdsse2.c
+ *
+ * This file is part of the Independent JPEG Group's software.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * This file contains the SSE2 versions of the kernels in jsimdker.h,
+ * working on 4 columns or rows of an IDCT and 16 pixels at a time.
+ */
+
+#define JPEG_INTERNALS
+#include "jinclude.h"
+#include "jpeglib.h"
+#include "jdct.h"		/* Private declarations for DCT subsystem */
+#include "jsimd.h"
+
+#ifdef JSIMD_SUPPORTED
+
+#include <emmintrin.h>
+
+#define JVEC		__m128i
+#define JVEC_LANES	4
+#define JSIMD_SUFFIX	sse2
+#define JSIMD_KERNEL
+
+
+/* 32-bit lane operations */
+
+#define jv_zero()		_mm_setzero_si128()
+#define jv_set1(c)		_mm_set1_epi32(c)
+#define jv_add(a,b)		_mm_add_epi32(a, b)
+#define jv_sub(a,b)		_mm_sub_epi32(a, b)
+#define jv_slli(a,n)		_mm_slli_epi32(a, n)
+#define jv_srai(a,n)		_mm_srai_epi32(a, n)
+#define jv_or(a,b)		_mm_or_si128(a, b)
+#define jv_iszero(a)		_mm_cmpeq_epi32(a, _mm_setzero_si128())
+#define jv_all(mask)		(_mm_movemask_epi8(mask) == 0xFFFF)
+#define jv_select(mask,a,b) \
+  _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b))
+#define jv_load_int(p)		_mm_loadu_si128((const __m128i *) (p))
+#define jv_store_int(p,v)	_mm_storeu_si128((__m128i *) (p), v)
+
+/* SSE2 has no 32-bit multiply; do lanes 0,2 and 1,3 as 64-bit products */
+
+JSIMD_LOCAL(__m128i)
+jv_mul (__m128i a, __m128i b)
+{
+  __m128i even = _mm_mul_epu32(a, b);
+  __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0,0,2,0)),
+			    _mm_shuffle_epi32(odd, _MM_SHUFFLE(0,0,2,0)));
+}
+
+/* 4 coefficients, sign-extended to 32 bits */
+
+JSIMD_LOCAL(__m128i)
+jv_load_coef (JCOEFPTR p)
+{
+  __m128i x = _mm_loadl_epi64((const __m128i *) p);
+
+  return _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+}
+
+
+/* 16-bit and 8-bit lane operations */
+
+#define jb_loadu(p)		_mm_loadu_si128((const __m128i *) (p))
+#define jb_set1_16(c)		_mm_set1_epi16(c)
+#define jb_add16(a,b)		_mm_add_epi16(a, b)
+#define jb_sub16(a,b)		_mm_sub_epi16(a, b)
+#define jb_madd16(a,b)		_mm_madd_epi16(a, b)
+#define jb_packs32(a,b)		_mm_packs_epi32(a, b)
+#define jb_packus16(a,b)	_mm_packus_epi16(a, b)
+#define jb_unpacklo8(a,b)	_mm_unpacklo_epi8(a, b)
+#define jb_unpackhi8(a,b)	_mm_unpackhi_epi8(a, b)
+#define jb_unpacklo16(a,b)	_mm_unpacklo_epi16(a, b)
+#define jb_unpackhi16(a,b)	_mm_unpackhi_epi16(a, b)
+
+/* 8 chroma samples, each doubled */
+
+JSIMD_LOCAL(__m128i)
+jb_load_h2 (JSAMPROW p)
+{
+  __m128i x = _mm_loadl_epi64((const __m128i *) p);
+
+  return _mm_unpacklo_epi8(x, x);
+}
+
+
+/*
+ * Load 4 workspace rows of 8 entries as 8 vectors of 4 rows each.
+ */
+
+JSIMD_LOCAL(void)
+load_columns (int * wsptr, __m128i * in)
+{
+  __m128i r0, r1, r2, r3, t0, t1, t2, t3;
+  int half;
+
+  for (half = 0; half < 8; half += 4) {
+    r0 = _mm_loadu_si128((const __m128i *) (wsptr + 8*0 + half));
+    r1 = _mm_loadu_si128((const __m128i *) (wsptr + 8*1 + half));
+    r2 = _mm_loadu_si128((const __m128i *) (wsptr + 8*2 + half));
+    r3 = _mm_loadu_si128((const __m128i *) (wsptr + 8*3 + half));
+    t0 = _mm_unpacklo_epi32(r0, r1);
+    t1 = _mm_unpacklo_epi32(r2, r3);
+    t2 = _mm_unpackhi_epi32(r0, r1);
+    t3 = _mm_unpackhi_epi32(r2, r3);
+    in[half+0] = _mm_unpacklo_epi64(t0, t1);
+    in[half+1] = _mm_unpackhi_epi64(t0, t1);
+    in[half+2] = _mm_unpacklo_epi64(t2, t3);
+    in[half+3] = _mm_unpackhi_epi64(t2, t3);
+  }
+}
+
+
+/*
+ * Narrow 8 vectors of 4 rows each to samples, transposed:
+ * *rows01 receives 8 samples of rows 0 and 1, *rows23 those of rows 2 and 3.
+ */
+
+JSIMD_LOCAL(void)
+transpose_samples (__m128i * out, __m128i * rows01, __m128i * rows23)
+{
+  __m128i a, b, t0, t1;
+
+  /* a holds outputs 0..3, b outputs 4..7, each for rows 0..3 */
+  a = _mm_packus_epi16(_mm_packs_epi32(out[0], out[1]),
+		       _mm_packs_epi32(out[2], out[3]));
+  b = _mm_packus_epi16(_mm_packs_epi32(out[4], out[5]),
+		       _mm_packs_epi32(out[6], out[7]));
+  t0 = _mm_unpacklo_epi8(a, b);
+  t1 = _mm_unpackhi_epi8(a, b);
+  a = _mm_unpacklo_epi8(t0, t1);
+  b = _mm_unpackhi_epi8(t0, t1);
+  *rows01 = _mm_unpacklo_epi8(a, b);
+  *rows23 = _mm_unpackhi_epi8(a, b);
+}
+
+
+/*
+ * Store n (8 or 16) range-limited outputs for each of 4 rows.
+ */
+
+JSIMD_LOCAL(void)
+store_rows (__m128i * out, int n, JSAMPARRAY output_buf,
+	    JDIMENSION output_col)
+{
+  __m128i lo01, lo23, hi01, hi23;
+
+  transpose_samples(out, &lo01, &lo23);
+  if (n == 8) {
+    _mm_storel_epi64((__m128i *) (output_buf[0] + output_col), lo01);
+    _mm_storel_epi64((__m128i *) (output_buf[1] + output_col),
+		     _mm_srli_si128(lo01, 8));
+    _mm_storel_epi64((__m128i *) (output_buf[2] + output_col), lo23);
+    _mm_storel_epi64((__m128i *) (output_buf[3] + output_col),
+		     _mm_srli_si128(lo23, 8));
+    return;
+  }
+
+  transpose_samples(out + 8, &hi01, &hi23);
+  _mm_storeu_si128((__m128i *) (output_buf[0] + output_col),
+		   _mm_unpacklo_epi64(lo01, hi01));
+  _mm_storeu_si128((__m128i *) (output_buf[1] + output_col),
+		   _mm_unpackhi_epi64(lo01, hi01));
+  _mm_storeu_si128((__m128i *) (output_buf[2] + output_col),
+		   _mm_unpacklo_epi64(lo23, hi23));
+  _mm_storeu_si128((__m128i *) (output_buf[3] + output_col),
+		   _mm_unpackhi_epi64(lo23, hi23));
+}
+
+
+/*
+ * Squeeze 4 pixels laid out as R,G,B,0 into the low 12 bytes.
+ */
+
+JSIMD_LOCAL(__m128i)
+pack_rgb0 (__m128i x)
+{
+  __m128i mask_lo = _mm_set_epi32(0, 0x00FFFFFF, 0, 0x00FFFFFF);
+  __m128i mask_hi = _mm_set_epi32(0x0000FFFF, 0xFF000000,
+				  0x0000FFFF, 0xFF000000);
+
+  /* 6 bytes at the bottom of each qword, then join the qwords */
+  x = _mm_or_si128(_mm_and_si128(x, mask_lo),
+		   _mm_and_si128(_mm_srli_epi64(x, 8), mask_hi));
+  return _mm_or_si128(_mm_move_epi64(x),
+		      _mm_slli_si128(_mm_srli_si128(x, 8), 6));
+}
+
+
+/*
+ * Store 16 pixels as R,G,B triplets.
+ */
+
+JSIMD_LOCAL(void)
+store_rgb (JSAMPROW outptr, __m128i r, __m128i g, __m128i b)
+{
+  __m128i zero = _mm_setzero_si128();
+  __m128i rg, b0, c0, c1, c2, c3;
+
+  rg = _mm_unpacklo_epi8(r, g);
+  b0 = _mm_unpacklo_epi8(b, zero);
+  c0 = pack_rgb0(_mm_unpacklo_epi16(rg, b0));
+  c1 = pack_rgb0(_mm_unpackhi_epi16(rg, b0));
+  rg = _mm_unpackhi_epi8(r, g);
+  b0 = _mm_unpackhi_epi8(b, zero);
+  c2 = pack_rgb0(_mm_unpacklo_epi16(rg, b0));
+  c3 = pack_rgb0(_mm_unpackhi_epi16(rg, b0));
+
+  _mm_storeu_si128((__m128i *) outptr,
+		   _mm_or_si128(c0, _mm_slli_si128(c1, 12)));
+  _mm_storeu_si128((__m128i *) (outptr + 16),
+		   _mm_or_si128(_mm_srli_si128(c1, 4), _mm_slli_si128(c2, 8)));
+  _mm_storeu_si128((__m128i *) (outptr + 32),
+		   _mm_or_si128(_mm_srli_si128(c2, 8), _mm_slli_si128(c3, 4)));
+}
+
+
+#include "jsimdker.h"
+
+#endif /* JSIMD_SUPPORTED */
@@ -0,0 +1,45 @@
+
+/* arm_init.c - NEON optimized filter functions
+ *
+ * This code is released under the libpng license.
+ * For conditions of distribution and use, see the disclaimer
+ * and license in png.h
+ */
+
+#include "../pngpriv.h"
+
+#ifdef PNG_READ_SUPPORTED
+
+#if PNG_ARM_NEON_OPT > 0
+
+#if PNG_ARM_NEON_IMPLEMENTATION != 1
+#  error "Only the NEON intrinsics implementation is bundled"
+#endif
+
+/* pngpriv.h only turns PNG_ARM_NEON_OPT on when the compiler itself targets
+ * NEON, so unlike upstream there is no run-time check to make here.
+ */
+void
+png_init_filter_functions_neon(png_structp pp, unsigned int bpp)
+{
+   pp->read_filter[PNG_FILTER_VALUE_UP-1] = png_read_filter_row_up_neon;
+
+   if (bpp == 3)
+   {
+      pp->read_filter[PNG_FILTER_VALUE_SUB-1] = png_read_filter_row_sub3_neon;
+      pp->read_filter[PNG_FILTER_VALUE_AVG-1] = png_read_filter_row_avg3_neon;
+      pp->read_filter[PNG_FILTER_VALUE_PAETH-1] =
+         png_read_filter_row_paeth3_neon;
+   }
+
+   else if (bpp == 4)
+   {
+      pp->read_filter[PNG_FILTER_VALUE_SUB-1] = png_read_filter_row_sub4_neon;
+      pp->read_filter[PNG_FILTER_VALUE_AVG-1] = png_read_filter_row_avg4_neon;
+      pp->read_filter[PNG_FILTER_VALUE_PAETH-1] =
+         png_read_filter_row_paeth4_neon;
+   }
+}
+
+#endif /* PNG_ARM_NEON_OPT > 0 */
+#endif /* READ */
@@ -0,0 +1,199 @@
+
+/* filter_neon_intrinsics.c - NEON optimized filter functions
+ *
+ * This code is released under the libpng license.
+ * For conditions of distribution and use, see the disclaimer
+ * and license in png.h
+ */
+
+#include "../pngpriv.h"
+
+#ifdef PNG_READ_SUPPORTED
+
+#if PNG_ARM_NEON_IMPLEMENTATION == 1 /* intrinsics code from pngpriv.h */
+
+#if defined(_MSC_VER) && defined(_M_ARM64)
+#  include <arm64_neon.h>
+#else
+#  include <arm_neon.h>
+#endif
+
+#if PNG_ARM_NEON_OPT > 0
+
+/* Same layout as the SSE2 code in intel/: one pixel per 32 bit lane, moved
+ * through memcpy so that unaligned rows are fine.  A 3 byte pixel is read as
+ * 4 bytes while the row has a byte after it; the extra lane is never stored.
+ */
+static uint8x8_t
+load_pixel(png_const_bytep p, size_t rb)
+{
+   png_uint_32 tmp = 0;
+
+   memcpy(&tmp, p, rb >= 4 ? 4 : 3);
+   return vreinterpret_u8_u32(vdup_n_u32(tmp));
+}
+
+static void
+store_pixel(png_bytep p, uint8x8_t v, unsigned int bpp)
+{
+   png_uint_32 tmp = vget_lane_u32(vreinterpret_u32_u8(v), 0);
+
+   memcpy(p, &tmp, bpp);
+}
+
+void
+png_read_filter_row_up_neon(png_row_infop row_info, png_bytep row,
+    png_const_bytep prev)
+{
+   size_t rb = row_info->rowbytes;
+
+   png_debug(1, "in png_read_filter_row_up_neon");
+
+   while (rb >= 16)
+   {
+      vst1q_u8(row, vaddq_u8(vld1q_u8(row), vld1q_u8(prev)));
+
+      row += 16;
+      prev += 16;
+      rb -= 16;
+   }
+
+   while (rb > 0)
+   {
+      *row = (png_byte)(*row + *prev++);
+      row++;
+      rb--;
+   }
+}
+
+static void
+filter_row_sub(png_row_infop row_info, png_bytep row, unsigned int bpp)
+{
+   size_t rb = row_info->rowbytes;
+   uint8x8_t d = vdup_n_u8(0);
+
+   while (rb >= bpp)
+   {
+      d = vadd_u8(load_pixel(row, rb), d);
+      store_pixel(row, d, bpp);
+
+      row += bpp;
+      rb -= bpp;
+   }
+}
+
+void
+png_read_filter_row_sub3_neon(png_row_infop row_info, png_bytep row,
+    png_const_bytep prev)
+{
+   png_debug(1, "in png_read_filter_row_sub3_neon");
+
+   filter_row_sub(row_info, row, 3);
+   PNG_UNUSED(prev)
+}
+
+void
+png_read_filter_row_sub4_neon(png_row_infop row_info, png_bytep row,
+    png_const_bytep prev)
+{
+   png_debug(1, "in png_read_filter_row_sub4_neon");
+
+   filter_row_sub(row_info, row, 4);
+   PNG_UNUSED(prev)
+}
+
+/* vhadd_u8 is floor((a + b) / 2), exactly the average predictor */
+static void
+filter_row_avg(png_row_infop row_info, png_bytep row, png_const_bytep prev,
+    unsigned int bpp)
+{
+   size_t rb = row_info->rowbytes;
+   uint8x8_t d = vdup_n_u8(0);
+
+   while (rb >= bpp)
+   {
+      d = vadd_u8(load_pixel(row, rb), vhadd_u8(d, load_pixel(prev, rb)));
+      store_pixel(row, d, bpp);
+
+      row += bpp;
+      prev += bpp;
+      rb -= bpp;
+   }
+}
+
+void
+png_read_filter_row_avg3_neon(png_row_infop row_info, png_bytep row,
+    png_const_bytep prev)
+{
+   png_debug(1, "in png_read_filter_row_avg3_neon");
+
+   filter_row_avg(row_info, row, prev, 3);
+}
+
+void
+png_read_filter_row_avg4_neon(png_row_infop row_info, png_bytep row,
+    png_const_bytep prev)
+{
+   png_debug(1, "in png_read_filter_row_avg4_neon");
+
+   filter_row_avg(row_info, row, prev, 4);
+}
+
+/* pa = |b - c|, pb = |a - c| and pc = |a + b - 2c| in 16 bit lanes; a is used
+ * if pa is the smallest, else b if pb <= pc, else c.
+ */
+static uint8x8_t
+paeth(uint8x8_t a, uint8x8_t b, uint8x8_t c)
+{
+   uint16x8_t pa = vabdl_u8(b, c);
+   uint16x8_t pb = vabdl_u8(a, c);
+   uint16x8_t pc = vabdq_u16(vaddl_u8(a, b), vaddl_u8(c, c));
+   uint8x8_t use_a = vmovn_u16(vandq_u16(vcleq_u16(pa, pb),
+       vcleq_u16(pa, pc)));
+   uint8x8_t use_b = vmovn_u16(vcleq_u16(pb, pc));
+
+   return vbsl_u8(use_a, a, vbsl_u8(use_b, b, c));
+}
+
+static void
+filter_row_paeth(png_row_infop row_info, png_bytep row, png_const_bytep prev,
+    unsigned int bpp)
+{
+   size_t rb = row_info->rowbytes;
+   uint8x8_t a, b = vdup_n_u8(0), c, d = vdup_n_u8(0);
+
+   while (rb >= bpp)
+   {
+      c = b;
+      b = load_pixel(prev, rb);
+      a = d;
+      d = vadd_u8(load_pixel(row, rb), paeth(a, b, c));
+      store_pixel(row, d, bpp);
+
+      row += bpp;
+      prev += bpp;
+      rb -= bpp;
+   }
+}
+
+void
+png_read_filter_row_paeth3_neon(png_row_infop row_info, png_bytep row,
+    png_const_bytep prev)
+{
+   png_debug(1, "in png_read_filter_row_paeth3_neon");
+
+   filter_row_paeth(row_info, row, prev, 3);
+}
+
+void
+png_read_filter_row_paeth4_neon(png_row_infop row_info, png_bytep row,
+    png_const_bytep prev)
+{
+   png_debug(1, "in png_read_filter_row_paeth4_neon");
+
+   filter_row_paeth(row_info, row, prev, 4);
+}
+
+#endif /* PNG_ARM_NEON_OPT > 0 */
+#endif /* PNG_ARM_NEON_IMPLEMENTATION == 1 (intrinsics) */
+#endif /* READ */
@@ -0,0 +1,91 @@
+
+/* palette_neon_intrinsics.c - NEON optimized palette expansion functions
+ *
+ * This code is released under the libpng license.
+ * For conditions of distribution and use, see the disclaimer
+ * and license in png.h
+ */
+
+#include "../pngpriv.h"
+
+#if PNG_ARM_NEON_IMPLEMENTATION == 1
+
+#if defined(_MSC_VER) && defined(_M_ARM64)
+#  include <arm64_neon.h>
+#else
+#  include <arm_neon.h>
+#endif
+
+/* Builds the RGBA lookup table used by png_do_expand_palette_rgba8_neon.  Both
+ * palette and trans_alpha are allocated with PNG_MAX_PALETTE_LENGTH entries.
+ */
+void
+png_riffle_palette_neon(png_structrp png_ptr)
+{
+   png_const_colorp palette = png_ptr->palette;
+   png_const_bytep trans_alpha = png_ptr->trans_alpha;
+   png_bytep riffled = png_ptr->riffled_palette;
+   int num_trans = png_ptr->num_trans;
+   int i;
+
+   png_debug(1, "in png_riffle_palette_neon");
+
+   for (i = 0; i < PNG_MAX_PALETTE_LENGTH; i++)
+   {
+      riffled[(i << 2) + 0] = palette[i].red;
+      riffled[(i << 2) + 1] = palette[i].green;
+      riffled[(i << 2) + 2] = palette[i].blue;
+      riffled[(i << 2) + 3] = i < num_trans ? trans_alpha[i] : 0xff;
+   }
+}
+
+/* Expands 4 palette indices at a time into RGBA through the riffled palette.
+ * The caller passes the last byte of the source and destination rows and
+ * finishes whatever is left, so only whole groups of 4 are done here.
+ */
+int
+png_do_expand_palette_rgba8_neon(png_structrp png_ptr, png_row_infop row_info,
+    png_const_bytep row, const png_bytepp ssp, const png_bytepp ddp)
+{
+   const png_uint_32 *riffled = (const png_uint_32 *)png_ptr->riffled_palette;
+   png_uint_32 row_width = row_info->width;
+   png_uint_32 i;
+
+   png_debug(1, "in png_do_expand_palette_rgba8_neon");
+
+   PNG_UNUSED(row)
+
+   for (i = 0; i + 4 <= row_width; i += 4)
+   {
+      png_const_bytep sp = *ssp - i;
+      png_bytep dp = *ddp - (i << 2) - 15;
+      uint32x4_t cur = vdupq_n_u32(riffled[sp[-3]]);
+
+      cur = vsetq_lane_u32(riffled[sp[-2]], cur, 1);
+      cur = vsetq_lane_u32(riffled[sp[-1]], cur, 2);
+      cur = vsetq_lane_u32(riffled[sp[0]], cur, 3);
+      vst1q_u32((png_uint_32 *)(void *)dp, cur);
+   }
+
+   *ssp -= i;
+   *ddp -= i << 2;
+   return (int)i;
+}
+
+/* The RGB case has no riffled palette to look up; leave it to the portable
+ * loop in png_do_expand_palette.
+ */
+int
+png_do_expand_palette_rgb8_neon(png_structrp png_ptr, png_row_infop row_info,
+    png_const_bytep row, const png_bytepp ssp, const png_bytepp ddp)
+{
+   PNG_UNUSED(png_ptr)
+   PNG_UNUSED(row_info)
+   PNG_UNUSED(row)
+   PNG_UNUSED(ssp)
+   PNG_UNUSED(ddp)
+
+   return 0;
+}
+
+#endif /* PNG_ARM_NEON_IMPLEMENTATION */
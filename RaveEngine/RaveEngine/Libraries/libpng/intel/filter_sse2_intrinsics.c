@@ -0,0 +1,278 @@
+
+/* filter_sse2_intrinsics.c - SSE2 and SSSE3 optimized filter functions
+ *
+ * This code is released under the libpng license.
+ * For conditions of distribution and use, see the disclaimer
+ * and license in png.h
+ */
+
+#include "../pngpriv.h"
+
+#ifdef PNG_READ_SUPPORTED
+
+#if PNG_INTEL_SSE_IMPLEMENTATION > 0
+
+#include <emmintrin.h>
+#include <tmmintrin.h>
+
+/* The SSSE3 functions are only called after a cpuid check, so they are built
+ * for SSSE3 even when the rest of the library is not.
+ */
+#if PNG_INTEL_SSE_IMPLEMENTATION < 2 && (defined(__GNUC__) || defined(__clang__))
+#  define PNG_TARGET_SSSE3 __attribute__((target("ssse3")))
+#else
+#  define PNG_TARGET_SSSE3
+#endif
+
+/* Pixels are moved in and out of the vector registers through memcpy, which
+ * keeps unaligned accesses well defined.  A 3 byte pixel is read as 4 bytes
+ * while the row still has a byte after it, only the last pixel of the row is
+ * assembled a byte at a time; the extra lane is never stored.
+ */
+static __m128i
+load_pixel(png_const_bytep p, size_t rb)
+{
+   int tmp;
+
+   if (rb >= 4)
+      memcpy(&tmp, p, sizeof tmp);
+
+   else
+      tmp = p[0] | (p[1] << 8) | (p[2] << 16);
+
+   return _mm_cvtsi32_si128(tmp);
+}
+
+static void
+store_pixel(png_bytep p, __m128i v, unsigned int bpp)
+{
+   int tmp = _mm_cvtsi128_si32(v);
+
+   if (bpp == 4)
+      memcpy(p, &tmp, sizeof tmp);
+
+   else
+   {
+      memcpy(p, &tmp, 2);
+      p[2] = (png_byte)(tmp >> 16);
+   }
+}
+
+void
+png_read_filter_row_up_sse2(png_row_infop row_info, png_bytep row,
+    png_const_bytep prev)
+{
+   /* The up filter is independent of the pixel size: process 16 bytes at a
+    * time and finish the row one byte at a time.
+    */
+   size_t rb = row_info->rowbytes;
+
+   png_debug(1, "in png_read_filter_row_up_sse2");
+
+   while (rb >= 16)
+   {
+      __m128i d = _mm_loadu_si128((const __m128i *)(const void *)row);
+      __m128i b = _mm_loadu_si128((const __m128i *)(const void *)prev);
+
+      _mm_storeu_si128((__m128i *)(void *)row, _mm_add_epi8(d, b));
+
+      row += 16;
+      prev += 16;
+      rb -= 16;
+   }
+
+   while (rb > 0)
+   {
+      *row = (png_byte)(*row + *prev++);
+      row++;
+      rb--;
+   }
+}
+
+/* The sub filter predicts each pixel from the one to its left, so the row is
+ * walked one pixel at a time with a running sum: d = d + left.
+ */
+static void
+filter_row_sub(png_row_infop row_info, png_bytep row, unsigned int bpp)
+{
+   size_t rb = row_info->rowbytes;
+   __m128i d = _mm_setzero_si128();
+
+   while (rb >= bpp)
+   {
+      d = _mm_add_epi8(load_pixel(row, rb), d);
+      store_pixel(row, d, bpp);
+
+      row += bpp;
+      rb -= bpp;
+   }
+}
+
+void
+png_read_filter_row_sub3_sse2(png_row_infop row_info, png_bytep row,
+    png_const_bytep prev)
+{
+   png_debug(1, "in png_read_filter_row_sub3_sse2");
+
+   filter_row_sub(row_info, row, 3);
+   PNG_UNUSED(prev)
+}
+
+void
+png_read_filter_row_sub4_sse2(png_row_infop row_info, png_bytep row,
+    png_const_bytep prev)
+{
+   png_debug(1, "in png_read_filter_row_sub4_sse2");
+
+   filter_row_sub(row_info, row, 4);
+   PNG_UNUSED(prev)
+}
+
+/* The average filter uses floor((a + b) / 2); _mm_avg_epu8 rounds up, so the
+ * low bit of a ^ b is subtracted back out.
+ */
+static void
+filter_row_avg(png_row_infop row_info, png_bytep row, png_const_bytep prev,
+    unsigned int bpp)
+{
+   const __m128i one = _mm_set1_epi8(1);
+   size_t rb = row_info->rowbytes;
+   __m128i a, b, d = _mm_setzero_si128();
+
+   while (rb >= bpp)
+   {
+      a = d;
+      b = load_pixel(prev, rb);
+      d = _mm_sub_epi8(_mm_avg_epu8(a, b),
+          _mm_and_si128(_mm_xor_si128(a, b), one));
+      d = _mm_add_epi8(load_pixel(row, rb), d);
+      store_pixel(row, d, bpp);
+
+      row += bpp;
+      prev += bpp;
+      rb -= bpp;
+   }
+}
+
+void
+png_read_filter_row_avg3_sse2(png_row_infop row_info, png_bytep row,
+    png_const_bytep prev)
+{
+   png_debug(1, "in png_read_filter_row_avg3_sse2");
+
+   filter_row_avg(row_info, row, prev, 3);
+}
+
+void
+png_read_filter_row_avg4_sse2(png_row_infop row_info, png_bytep row,
+    png_const_bytep prev)
+{
+   png_debug(1, "in png_read_filter_row_avg4_sse2");
+
+   filter_row_avg(row_info, row, prev, 4);
+}
+
+/* Paeth works on 16 bit lanes.  With a the left pixel, b the one above and c
+ * the one above-left, the distances to p = a + b - c are:
+ *
+ *    pa = |b - c|    pb = |a - c|    pc = |(b - c) + (a - c)|
+ *
+ * and the predictor is the first of a, b, c whose distance is smallest, which
+ * is exactly the tie breaking of png_read_filter_row_paeth_multibyte_pixel.
+ */
+static __m128i
+if_then_else(__m128i c, __m128i t, __m128i e)
+{
+   return _mm_or_si128(_mm_and_si128(c, t), _mm_andnot_si128(c, e));
+}
+
+static __m128i
+paeth_nearest(__m128i a, __m128i b, __m128i c, __m128i pa, __m128i pb,
+    __m128i pc)
+{
+   __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+
+   return if_then_else(_mm_cmpeq_epi16(smallest, pa), a,
+       if_then_else(_mm_cmpeq_epi16(smallest, pb), b, c));
+}
+
+/* SSE2 has no 16 bit absolute value, use max(x, -x) */
+static __m128i
+abs_i16_sse2(__m128i x)
+{
+   return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+/* The SSE2 and SSSE3 versions only differ in abs_i16.  The predictor is added
+ * in the 16 bit lanes with _mm_add_epi8 so that each sum wraps at 256 and the
+ * high bytes stay zero.
+ */
+#define PNG_PAETH_LOOP(bpp, abs_i16) \
+   { \
+      const __m128i zero = _mm_setzero_si128(); \
+      size_t rb = row_info->rowbytes; \
+      __m128i a, b = zero, c, d = zero, pa, pb, pc; \
+   \
+      while (rb >= bpp) \
+      { \
+         c = b; \
+         b = _mm_unpacklo_epi8(load_pixel(prev, rb), zero); \
+         a = d; \
+         d = _mm_unpacklo_epi8(load_pixel(row, rb), zero); \
+   \
+         pa = _mm_sub_epi16(b, c); \
+         pb = _mm_sub_epi16(a, c); \
+         pc = _mm_add_epi16(pa, pb); \
+   \
+         pa = abs_i16(pa); \
+         pb = abs_i16(pb); \
+         pc = abs_i16(pc); \
+   \
+         d = _mm_add_epi8(d, paeth_nearest(a, b, c, pa, pb, pc)); \
+         store_pixel(row, _mm_packus_epi16(d, d), bpp); \
+   \
+         row += bpp; \
+         prev += bpp; \
+         rb -= bpp; \
+      } \
+   }
+
+void
+png_read_filter_row_paeth3_sse2(png_row_infop row_info, png_bytep row,
+    png_const_bytep prev)
+{
+   png_debug(1, "in png_read_filter_row_paeth3_sse2");
+
+   PNG_PAETH_LOOP(3, abs_i16_sse2)
+}
+
+void
+png_read_filter_row_paeth4_sse2(png_row_infop row_info, png_bytep row,
+    png_const_bytep prev)
+{
+   png_debug(1, "in png_read_filter_row_paeth4_sse2");
+
+   PNG_PAETH_LOOP(4, abs_i16_sse2)
+}
+
+/* SSSE3 provides the absolute value directly */
+PNG_TARGET_SSSE3 void
+png_read_filter_row_paeth3_ssse3(png_row_infop row_info, png_bytep row,
+    png_const_bytep prev)
+{
+   png_debug(1, "in png_read_filter_row_paeth3_ssse3");
+
+   PNG_PAETH_LOOP(3, _mm_abs_epi16)
+}
+
+PNG_TARGET_SSSE3 void
+png_read_filter_row_paeth4_ssse3(png_row_infop row_info, png_bytep row,
+    png_const_bytep prev)
+{
+   png_debug(1, "in png_read_filter_row_paeth4_ssse3");
+
+   PNG_PAETH_LOOP(4, _mm_abs_epi16)
+}
+
+#endif /* PNG_INTEL_SSE_IMPLEMENTATION > 0 */
+#endif /* READ */
@@ -0,0 +1,74 @@
+
+/* intel_init.c - SSE2 and SSSE3 optimized filter functions
+ *
+ * This code is released under the libpng license.
+ * For conditions of distribution and use, see the disclaimer
+ * and license in png.h
+ */
+
+#include "../pngpriv.h"
+
+#ifdef PNG_READ_SUPPORTED
+
+#if PNG_INTEL_SSE_IMPLEMENTATION > 0
+
+#if PNG_INTEL_SSE_IMPLEMENTATION < 2
+#  ifdef _MSC_VER
+#     include <intrin.h>
+#  else
+#     include <cpuid.h>
+#  endif
+#endif
+
+/* SSE2 is guaranteed whenever this file is built (x64, or /arch:SSE2 and
+ * above on x86); SSSE3 is checked for at run time unless the compiler was
+ * already told it may use it.
+ */
+static int
+png_have_ssse3(void)
+{
+#if PNG_INTEL_SSE_IMPLEMENTATION >= 2
+   return 1;
+#elif defined(_MSC_VER)
+   int info[4];
+
+   __cpuid(info, 1);
+   return (info[2] & (1 << 9)) != 0;
+#else
+   unsigned int eax, ebx, ecx, edx;
+
+   if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0)
+      return 0;
+
+   return (ecx & (1U << 9)) != 0;
+#endif
+}
+
+void
+png_init_filter_functions_sse2(png_structp pp, unsigned int bpp)
+{
+   /* The up filter is byte wise, so every pixel size uses it.  The other
+    * filters depend on the previous pixel and are only provided for RGB and
+    * RGBA 8 bit images, which are the ones that spend real time here.
+    */
+   pp->read_filter[PNG_FILTER_VALUE_UP-1] = png_read_filter_row_up_sse2;
+
+   if (bpp == 3)
+   {
+      pp->read_filter[PNG_FILTER_VALUE_SUB-1] = png_read_filter_row_sub3_sse2;
+      pp->read_filter[PNG_FILTER_VALUE_AVG-1] = png_read_filter_row_avg3_sse2;
+      pp->read_filter[PNG_FILTER_VALUE_PAETH-1] = png_have_ssse3() != 0 ?
+         png_read_filter_row_paeth3_ssse3 : png_read_filter_row_paeth3_sse2;
+   }
+
+   else if (bpp == 4)
+   {
+      pp->read_filter[PNG_FILTER_VALUE_SUB-1] = png_read_filter_row_sub4_sse2;
+      pp->read_filter[PNG_FILTER_VALUE_AVG-1] = png_read_filter_row_avg4_sse2;
+      pp->read_filter[PNG_FILTER_VALUE_PAETH-1] = png_have_ssse3() != 0 ?
+         png_read_filter_row_paeth4_ssse3 : png_read_filter_row_paeth4_sse2;
+   }
+}
+
+#endif /* PNG_INTEL_SSE_IMPLEMENTATION > 0 */
+#endif /* READ */
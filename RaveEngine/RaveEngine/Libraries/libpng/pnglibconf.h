@@ -215,5 +215,7 @@
 #define PNG_Z_DEFAULT_STRATEGY 1
 #define PNG_sCAL_PRECISION 5
 #define PNG_sRGB_PROFILE_CHECKS 2
+/* Use the SSE2/SSSE3 filter functions in intel/ on x86 and x64 */
+#define PNG_INTEL_SSE
 /* end of settings */
 #endif /* PNGLCONF_H */
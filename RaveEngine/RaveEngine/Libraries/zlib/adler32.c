@@ -6,6 +6,7 @@
 /* @(#) $Id$ */
 
 #include "zutil.h"
+#include "adler32_simd.h"
 
 local uLong adler32_combine_ OF((uLong adler1, uLong adler2, z_off64_t len2));
 
@@ -87,6 +88,17 @@ uLong ZEXPORT adler32_z(adler, buf, len)
     if (buf == Z_NULL)
         return 1L;
 
+#ifdef X86_SIMD
+    /* long buffers go to the widest vector code this CPU has */
+    if (len >= 64) {
+        cpu_check_features();
+        if (x86_cpu_has_avx2)
+            return adler32_avx2(adler | (sum2 << 16), buf, len);
+        if (x86_cpu_has_ssse3)
+            return adler32_ssse3(adler | (sum2 << 16), buf, len);
+    }
+#endif
+
     /* in case short lengths are provided, keep it somewhat fast */
     if (len < 16) {
         while (len--) {
@@ -0,0 +1,160 @@
+/* adler32_simd.c -- SSSE3 and AVX2 Adler-32
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+/*
+   Both versions split the data into blocks of 32 or 64 bytes.  Within a
+   block the bytes are summed with psadbw for s1, and multiplied by their
+   distance from the end of the block with pmaddubsw for s2.  Every block
+   also adds 32 or 64 times the s1 at its start to s2, which is deferred by
+   summing those s1 values and shifting once at the end.  At most NMAX bytes
+   are summed between modulos, the same bound the portable code uses.
+ */
+
+#include "zutil.h"
+#include "adler32_simd.h"
+
+#ifdef X86_SIMD
+
+#include <immintrin.h>
+
+#define BASE 65521U     /* largest prime smaller than 65536 */
+#define NMAX 5552
+
+/* sums of the bytes left after the last whole block */
+local uLong adler32_tail(unsigned long s1, unsigned long s2,
+                         const Bytef *buf, z_size_t len)
+{
+    if (len) {
+        while (len--) {
+            s1 += *buf++;
+            s2 += s1;
+        }
+        s1 %= BASE;
+        s2 %= BASE;
+    }
+    return s1 | (s2 << 16);
+}
+
+Z_TARGET("ssse3")
+uLong ZLIB_INTERNAL adler32_ssse3(uLong adler, const Bytef *buf, z_size_t len)
+{
+    unsigned long s1 = adler & 0xffff;
+    unsigned long s2 = (adler >> 16) & 0xffff;
+    z_size_t blocks = len / 32;
+
+    const __m128i tap1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+                                       24, 23, 22, 21, 20, 19, 18, 17);
+    const __m128i tap2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9,
+                                       8, 7, 6, 5, 4, 3, 2, 1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+
+    len -= blocks * 32;
+    while (blocks) {
+        unsigned n = NMAX / 32;
+        __m128i v_ps, v_s1, v_s2;
+
+        if (n > blocks)
+            n = (unsigned)blocks;
+        blocks -= n;
+
+        v_ps = _mm_setr_epi32((int)(s1 * n), 0, 0, 0);
+        v_s1 = zero;
+        v_s2 = _mm_setr_epi32((int)s2, 0, 0, 0);
+        do {
+            const __m128i bytes1 = _mm_loadu_si128((const __m128i *)buf);
+            const __m128i bytes2 = _mm_loadu_si128((const __m128i *)(buf + 16));
+
+            v_ps = _mm_add_epi32(v_ps, v_s1);
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes1, zero));
+            v_s2 = _mm_add_epi32(v_s2,
+                _mm_madd_epi16(_mm_maddubs_epi16(bytes1, tap1), ones));
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes2, zero));
+            v_s2 = _mm_add_epi32(v_s2,
+                _mm_madd_epi16(_mm_maddubs_epi16(bytes2, tap2), ones));
+            buf += 32;
+        } while (--n);
+        v_s2 = _mm_add_epi32(v_s2, _mm_slli_epi32(v_ps, 5));
+
+        /* horizontal sums */
+        v_s1 = _mm_add_epi32(v_s1, _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(2, 3, 0, 1)));
+        v_s1 = _mm_add_epi32(v_s1, _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(1, 0, 3, 2)));
+        s1 += (unsigned)_mm_cvtsi128_si32(v_s1);
+        v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(2, 3, 0, 1)));
+        v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(1, 0, 3, 2)));
+        s2 = (unsigned)_mm_cvtsi128_si32(v_s2);
+
+        s1 %= BASE;
+        s2 %= BASE;
+    }
+
+    return adler32_tail(s1, s2, buf, len);
+}
+
+Z_TARGET("avx2")
+uLong ZLIB_INTERNAL adler32_avx2(uLong adler, const Bytef *buf, z_size_t len)
+{
+    unsigned long s1 = adler & 0xffff;
+    unsigned long s2 = (adler >> 16) & 0xffff;
+    z_size_t blocks = len / 64;
+
+    const __m256i tap1 = _mm256_setr_epi8(64, 63, 62, 61, 60, 59, 58, 57,
+                                          56, 55, 54, 53, 52, 51, 50, 49,
+                                          48, 47, 46, 45, 44, 43, 42, 41,
+                                          40, 39, 38, 37, 36, 35, 34, 33);
+    const __m256i tap2 = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+                                          24, 23, 22, 21, 20, 19, 18, 17,
+                                          16, 15, 14, 13, 12, 11, 10, 9,
+                                          8, 7, 6, 5, 4, 3, 2, 1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+
+    len -= blocks * 64;
+    while (blocks) {
+        unsigned n = NMAX / 64;
+        __m256i v_ps, v_s1, v_s2;
+        __m128i h_s1, h_s2;
+
+        if (n > blocks)
+            n = (unsigned)blocks;
+        blocks -= n;
+
+        v_ps = _mm256_setr_epi32((int)(s1 * n), 0, 0, 0, 0, 0, 0, 0);
+        v_s1 = zero;
+        v_s2 = _mm256_setr_epi32((int)s2, 0, 0, 0, 0, 0, 0, 0);
+        do {
+            const __m256i bytes1 = _mm256_loadu_si256((const __m256i *)buf);
+            const __m256i bytes2 = _mm256_loadu_si256((const __m256i *)(buf + 32));
+
+            v_ps = _mm256_add_epi32(v_ps, v_s1);
+            v_s1 = _mm256_add_epi32(v_s1, _mm256_sad_epu8(bytes1, zero));
+            v_s2 = _mm256_add_epi32(v_s2,
+                _mm256_madd_epi16(_mm256_maddubs_epi16(bytes1, tap1), ones));
+            v_s1 = _mm256_add_epi32(v_s1, _mm256_sad_epu8(bytes2, zero));
+            v_s2 = _mm256_add_epi32(v_s2,
+                _mm256_madd_epi16(_mm256_maddubs_epi16(bytes2, tap2), ones));
+            buf += 64;
+        } while (--n);
+        v_s2 = _mm256_add_epi32(v_s2, _mm256_slli_epi32(v_ps, 6));
+
+        /* horizontal sums */
+        h_s1 = _mm_add_epi32(_mm256_castsi256_si128(v_s1),
+                             _mm256_extracti128_si256(v_s1, 1));
+        h_s1 = _mm_add_epi32(h_s1, _mm_shuffle_epi32(h_s1, _MM_SHUFFLE(2, 3, 0, 1)));
+        h_s1 = _mm_add_epi32(h_s1, _mm_shuffle_epi32(h_s1, _MM_SHUFFLE(1, 0, 3, 2)));
+        s1 += (unsigned)_mm_cvtsi128_si32(h_s1);
+        h_s2 = _mm_add_epi32(_mm256_castsi256_si128(v_s2),
+                             _mm256_extracti128_si256(v_s2, 1));
+        h_s2 = _mm_add_epi32(h_s2, _mm_shuffle_epi32(h_s2, _MM_SHUFFLE(2, 3, 0, 1)));
+        h_s2 = _mm_add_epi32(h_s2, _mm_shuffle_epi32(h_s2, _MM_SHUFFLE(1, 0, 3, 2)));
+        s2 = (unsigned)_mm_cvtsi128_si32(h_s2);
+
+        s1 %= BASE;
+        s2 %= BASE;
+    }
+
+    return adler32_tail(s1, s2, buf, len);
+}
+
+#endif /* X86_SIMD */
@@ -0,0 +1,19 @@
+/* adler32_simd.h -- SSSE3 and AVX2 Adler-32
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+/* WARNING: this file should *not* be used by applications. It is
+   part of the implementation of the compression library and is
+   subject to change. Applications should only use zlib.h.
+ */
+
+#include "cpu_features.h"
+
+#ifdef X86_SIMD
+/* Same result as the portable adler32_z() for any length, buf must not be
+   Z_NULL.  Only call them when cpu_check_features() found the instructions */
+uLong ZLIB_INTERNAL adler32_ssse3 OF((uLong adler, const Bytef *buf,
+                                      z_size_t len));
+uLong ZLIB_INTERNAL adler32_avx2 OF((uLong adler, const Bytef *buf,
+                                     z_size_t len));
+#endif
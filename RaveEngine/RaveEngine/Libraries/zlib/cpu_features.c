@@ -0,0 +1,93 @@
+/* cpu_features.c -- runtime detection of the instruction sets used by the
+ * SIMD checksums
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+#include "zutil.h"
+#include "cpu_features.h"
+
+#ifdef X86_SIMD
+
+#ifdef _MSC_VER
+#  include <intrin.h>
+#  include <windows.h>
+#else
+#  include <cpuid.h>
+#  include <pthread.h>
+#endif
+
+int ZLIB_INTERNAL x86_cpu_has_ssse3 = 0;
+int ZLIB_INTERNAL x86_cpu_has_avx2 = 0;
+int ZLIB_INTERNAL x86_cpu_has_pclmul = 0;
+
+local void cpuid(int leaf, unsigned regs[4])
+{
+#ifdef _MSC_VER
+    int info[4];
+    int i;
+
+    __cpuidex(info, leaf, 0);
+    for (i = 0; i < 4; i++)
+        regs[i] = (unsigned)info[i];
+#else
+    __cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+local unsigned long long read_xcr0(void)
+{
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned eax, edx;
+
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+
+local void detect_features(void)
+{
+    unsigned regs[4];
+    unsigned max_leaf;
+
+    cpuid(0, regs);
+    max_leaf = regs[0];
+
+    cpuid(1, regs);
+    x86_cpu_has_ssse3 = (regs[2] & (1u << 9)) != 0;
+    x86_cpu_has_pclmul = (regs[2] & (1u << 1)) != 0 &&
+                         (regs[2] & (1u << 19)) != 0;
+
+    /* AVX2 also needs the OS to save the ymm registers */
+    if (max_leaf >= 7 && (regs[2] & (1u << 27)) && (regs[2] & (1u << 28)) &&
+        (read_xcr0() & 0x6) == 0x6) {
+        cpuid(7, regs);
+        x86_cpu_has_avx2 = (regs[1] & (1u << 5)) != 0;
+    }
+}
+
+#ifdef _MSC_VER
+static INIT_ONCE features_once = INIT_ONCE_STATIC_INIT;
+
+local BOOL CALLBACK detect_features_once(PINIT_ONCE once, PVOID param,
+                                         PVOID *context)
+{
+    detect_features();
+    return TRUE;
+}
+
+void ZLIB_INTERNAL cpu_check_features(void)
+{
+    InitOnceExecuteOnce(&features_once, detect_features_once, NULL, NULL);
+}
+#else
+static pthread_once_t features_once = PTHREAD_ONCE_INIT;
+
+void ZLIB_INTERNAL cpu_check_features(void)
+{
+    pthread_once(&features_once, detect_features);
+}
+#endif
+
+#endif /* X86_SIMD */
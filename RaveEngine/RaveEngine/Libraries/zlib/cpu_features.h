@@ -0,0 +1,35 @@
+/* cpu_features.h -- runtime detection of the instruction sets used by the
+ * SIMD checksums
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+/* WARNING: this file should *not* be used by applications. It is
+   part of the implementation of the compression library and is
+   subject to change. Applications should only use zlib.h.
+ */
+
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#  define X86_SIMD
+#endif
+
+/* MSVC lets any function use any intrinsic, gcc and clang need the
+   instruction set enabled per function */
+#if defined(_MSC_VER) && !defined(__clang__)
+#  define Z_TARGET(features)
+#else
+#  define Z_TARGET(features) __attribute__((target(features)))
+#endif
+
+#ifdef X86_SIMD
+extern int ZLIB_INTERNAL x86_cpu_has_ssse3;
+extern int ZLIB_INTERNAL x86_cpu_has_avx2;
+extern int ZLIB_INTERNAL x86_cpu_has_pclmul;    /* also implies SSE4.1 */
+
+/* Fills in the flags above, cheap after the first call */
+void ZLIB_INTERNAL cpu_check_features OF((void));
+#endif
+
+#endif /* CPU_FEATURES_H */
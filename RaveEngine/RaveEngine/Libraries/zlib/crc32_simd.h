@@ -0,0 +1,20 @@
+/* crc32_simd.h -- CRC-32 folded with carry-less multiplication
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+/* WARNING: this file should *not* be used by applications. It is
+   part of the implementation of the compression library and is
+   subject to change. Applications should only use zlib.h.
+ */
+
+#include "cpu_features.h"
+
+#ifdef X86_SIMD
+/* Same result as the portable crc32_z().  len must be a multiple of 16 and
+   at least 64, and cpu_check_features() must have found PCLMULQDQ */
+#define CRC32_PCLMUL_MIN_LENGTH 64
+
+unsigned long ZLIB_INTERNAL crc32_pclmul OF((unsigned long crc,
+                                             const unsigned char FAR *buf,
+                                             z_size_t len));
+#endif
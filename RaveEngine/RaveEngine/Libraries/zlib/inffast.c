@@ -47,6 +47,83 @@
       requires strm->avail_out >= 258 for each loop to avoid checking for
       output space.
  */
+
+#ifdef INFLATE_WIDE_HOLD
+typedef unsigned long long hold_t;
+
+/*
+   The bit buffer is refilled with one unaligned 8 byte load, keeping 6 of
+   the bytes.  The top of hold then already holds the next input bytes, so
+   later refills OR in the same bits again instead of adding them.
+ */
+local hold_t read64le(z_const unsigned char FAR *in)
+{
+    hold_t word;
+
+    zmemcpy((Bytef *)&word, in, sizeof(word));
+    return word;
+}
+#else
+typedef unsigned long hold_t;
+#endif
+
+/*
+   Match copies move whole 16 byte chunks where they can.  Copying from the
+   output overlaps the destination when the distance is shorter than the
+   length, so short distances first repeat their pattern, doubling it each
+   time, until it is a chunk long.  Neither helper writes past out + len.
+ */
+#define CHUNK 16
+
+local unsigned char FAR *copy_output OF((unsigned char FAR *out,
+                                         unsigned dist, unsigned len));
+local unsigned char FAR *copy_window OF((unsigned char FAR *out,
+                                         z_const unsigned char FAR *from,
+                                         unsigned len, int shared));
+
+/* copy len bytes from dist bytes back in the output */
+local unsigned char FAR *copy_output(out, dist, len)
+unsigned char FAR *out;
+unsigned dist;
+unsigned len;
+{
+    unsigned char FAR *from = out - dist;
+
+    while (dist < CHUNK && len > dist) {
+        zmemcpy(out, from, dist);
+        out += dist;
+        len -= dist;
+        dist += dist;
+    }
+    if (dist >= CHUNK)
+        while (len >= CHUNK) {
+            zmemcpy(out, from, CHUNK);
+            out += CHUNK;
+            from += CHUNK;
+            len -= CHUNK;
+        }
+    while (len--)
+        *out++ = *from++;
+    return out;
+}
+
+/* copy len bytes from the window.  inflateBack() decodes straight into its
+   window, so there the source can overlap the output and is copied bytewise */
+local unsigned char FAR *copy_window(out, from, len, shared)
+unsigned char FAR *out;
+z_const unsigned char FAR *from;
+unsigned len;
+int shared;
+{
+    if (shared) {
+        while (len--)
+            *out++ = *from++;
+        return out;
+    }
+    zmemcpy(out, from, len);
+    return out + len;
+}
+
 void ZLIB_INTERNAL inflate_fast(strm, start)
 z_streamp strm;
 unsigned start;         /* inflate()'s starting value for strm->avail_out */
@@ -64,7 +141,7 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
     unsigned whave;             /* valid bytes in the window */
     unsigned wnext;             /* window write index */
     unsigned char FAR *window;  /* allocated sliding window, if wsize != 0 */
-    unsigned long hold;         /* local strm->hold */
+    hold_t hold;                /* local strm->hold */
     unsigned bits;              /* local strm->bits */
     code const FAR *lcode;      /* local strm->lencode */
     code const FAR *dcode;      /* local strm->distcode */
@@ -76,11 +153,12 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
     unsigned len;               /* match length, unused bytes */
     unsigned dist;              /* match distance */
     unsigned char FAR *from;    /* where to copy match from */
+    int shared;                 /* output is written into the window */
 
     /* copy state to local variables */
     state = (struct inflate_state FAR *)strm->state;
     in = strm->next_in;
-    last = in + (strm->avail_in - 5);
+    last = in + (strm->avail_in - (INFLATE_FAST_MIN_INPUT - 1));
     out = strm->next_out;
     beg = out - (start - strm->avail_out);
     end = out + (strm->avail_out - 257);
@@ -91,6 +169,7 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
     whave = state->whave;
     wnext = state->wnext;
     window = state->window;
+    shared = beg == window;
     hold = state->hold;
     bits = state->bits;
     lcode = state->lencode;
@@ -102,10 +181,16 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
        input data or output space */
     do {
         if (bits < 15) {
-            hold += (unsigned long)(*in++) << bits;
+#ifdef INFLATE_WIDE_HOLD
+            hold |= read64le(in) << bits;
+            in += 6;
+            bits += 48;
+#else
+            hold |= (hold_t)(*in++) << bits;
             bits += 8;
-            hold += (unsigned long)(*in++) << bits;
+            hold |= (hold_t)(*in++) << bits;
             bits += 8;
+#endif
         }
         here = lcode[hold & lmask];
       dolen:
@@ -124,7 +209,7 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
             op &= 15;                           /* number of extra bits */
             if (op) {
                 if (bits < op) {
-                    hold += (unsigned long)(*in++) << bits;
+                    hold |= (hold_t)(*in++) << bits;
                     bits += 8;
                 }
                 len += (unsigned)hold & ((1U << op) - 1);
@@ -133,9 +218,9 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
             }
             Tracevv((stderr, "inflate:         length %u\n", len));
             if (bits < 15) {
-                hold += (unsigned long)(*in++) << bits;
+                hold |= (hold_t)(*in++) << bits;
                 bits += 8;
-                hold += (unsigned long)(*in++) << bits;
+                hold |= (hold_t)(*in++) << bits;
                 bits += 8;
             }
             here = dcode[hold & dmask];
@@ -148,10 +233,10 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                 dist = (unsigned)(here.val);
                 op &= 15;                       /* number of extra bits */
                 if (bits < op) {
-                    hold += (unsigned long)(*in++) << bits;
+                    hold |= (hold_t)(*in++) << bits;
                     bits += 8;
                     if (bits < op) {
-                        hold += (unsigned long)(*in++) << bits;
+                        hold |= (hold_t)(*in++) << bits;
                         bits += 8;
                     }
                 }
@@ -201,10 +286,9 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                         from += wsize - op;
                         if (op < len) {         /* some from window */
                             len -= op;
-                            do {
-                                *out++ = *from++;
-                            } while (--op);
-                            from = out - dist;  /* rest from output */
+                            out = copy_window(out, from, op, shared);
+                            out = copy_output(out, dist, len);
+                            continue;
                         }
                     }
                     else if (wnext < op) {      /* wrap around window */
@@ -212,17 +296,14 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                         op -= wnext;
                         if (op < len) {         /* some from end of window */
                             len -= op;
-                            do {
-                                *out++ = *from++;
-                            } while (--op);
+                            out = copy_window(out, from, op, shared);
                             from = window;
                             if (wnext < len) {  /* some from start of window */
                                 op = wnext;
                                 len -= op;
-                                do {
-                                    *out++ = *from++;
-                                } while (--op);
-                                from = out - dist;      /* rest from output */
+                                out = copy_window(out, from, op, shared);
+                                out = copy_output(out, dist, len);
+                                continue;
                             }
                         }
                     }
@@ -230,38 +311,15 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                         from += wnext - op;
                         if (op < len) {         /* some from window */
                             len -= op;
-                            do {
-                                *out++ = *from++;
-                            } while (--op);
-                            from = out - dist;  /* rest from output */
+                            out = copy_window(out, from, op, shared);
+                            out = copy_output(out, dist, len);
+                            continue;
                         }
                     }
-                    while (len > 2) {
-                        *out++ = *from++;
-                        *out++ = *from++;
-                        *out++ = *from++;
-                        len -= 3;
-                    }
-                    if (len) {
-                        *out++ = *from++;
-                        if (len > 1)
-                            *out++ = *from++;
-                    }
-                }
-                else {
-                    from = out - dist;          /* copy direct from output */
-                    do {                        /* minimum length is three */
-                        *out++ = *from++;
-                        *out++ = *from++;
-                        *out++ = *from++;
-                        len -= 3;
-                    } while (len > 2);
-                    if (len) {
-                        *out++ = *from++;
-                        if (len > 1)
-                            *out++ = *from++;
-                    }
+                    out = copy_window(out, from, len, shared);
                 }
+                else                            /* copy direct from output */
+                    out = copy_output(out, dist, len);
             }
             else if ((op & 64) == 0) {          /* 2nd level distance code */
                 here = dcode[here.val + (hold & ((1U << op) - 1))];
@@ -298,10 +356,12 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
     /* update state and return */
     strm->next_in = in;
     strm->next_out = out;
-    strm->avail_in = (unsigned)(in < last ? 5 + (last - in) : 5 - (in - last));
+    strm->avail_in = (unsigned)(in < last ?
+                                (INFLATE_FAST_MIN_INPUT - 1) + (last - in) :
+                                (INFLATE_FAST_MIN_INPUT - 1) - (in - last));
     strm->avail_out = (unsigned)(out < end ?
                                  257 + (end - out) : 257 - (out - end));
-    state->hold = hold;
+    state->hold = (unsigned long)hold;
     state->bits = bits;
     return;
 }
@@ -9,3 +9,14 @@
  */
 
 void ZLIB_INTERNAL inflate_fast OF((z_streamp strm, unsigned start));
+
+/* 64-bit little endian targets refill the bit buffer 8 bytes at a time */
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_ARM64) || \
+    (defined(__aarch64__) && defined(__ORDER_LITTLE_ENDIAN__) && \
+     __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#  define INFLATE_WIDE_HOLD
+#  define INFLATE_FAST_MIN_INPUT 8
+#else
+#  define INFLATE_FAST_MIN_INPUT 6
+#endif
+#define INFLATE_FAST_MIN_OUTPUT 258